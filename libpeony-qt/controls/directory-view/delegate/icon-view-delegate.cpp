@@ -23,6 +23,7 @@
 #include "icon-view-delegate.h"
 #include "icon-view.h"
 #include "file-item-proxy-filter-sort-model.h"
+#include "flat-directory-model.h"
 #include "file-item.h"
 #include "file-info.h"
 
@@ -49,8 +50,13 @@
 #include <QPushButton>
 
 #include "clipboard-utils.h"
+#include "thumbnail-manager.h"
+#include "thumbnail-shadow.h"
+#include "theme-icon-cache.h"
 
 #include <QTextLayout>
+#include <QGlyphRun>
+#include <QCache>
 #include <QPainter>
 
 using namespace Peony;
@@ -112,12 +118,8 @@ void IconViewDelegate::paint(QPainter *painter, const QStyleOptionViewItem &opti
     style->drawPrimitive(QStyle::PE_PanelItemViewItem, &opt, painter, nullptr);
 
     if (ClipboardUtils::getClipedFilesParentUri() == view->getDirectoryUri()) {
-        if (ClipboardUtils::isClipboardFilesBeCut()) {
-            auto clipedUris = ClipboardUtils::getClipboardFilesUris();
-            if (clipedUris.contains(index.data(FileItemModel::UriRole).toString())) {
-                painter->setOpacity(0.5);
-                qDebug()<<"cut item"<<index.data();
-            }
+        if (ClipboardUtils::isCutFile(index.data(FileItemModel::UriRole).toString())) {
+            painter->setOpacity(0.5);
         }
     }
 
@@ -126,6 +128,11 @@ void IconViewDelegate::paint(QPainter *painter, const QStyleOptionViewItem &opti
     int y_delta = iconSizeExpected.height() - iconRect.height();
     opt.rect.setY(opt.rect.y() + y_delta);
 
+    //the shadow is not baked into the thumbnails, paint it behind the icon.
+    if (ThumbnailManager::getInstance()->hasShadow(index.data(FileItemModel::UriRole).toString())) {
+        ThumbnailShadow::paint(painter, opt);
+    }
+
     auto text = opt.text;
     opt.text = nullptr;
     style->drawControl(QStyle::CE_ItemViewItem, &opt, painter, opt.widget);
@@ -144,14 +151,21 @@ void IconViewDelegate::paint(QPainter *painter, const QStyleOptionViewItem &opti
     painter->restore();
 
     //get file info from index
-    auto model = static_cast<FileItemProxyFilterSortModel*>(view->model());
-    auto item = model->itemFromIndex(index);
-    //NOTE: item might be deleted when painting, because we might start a
-    //location change during the painting.
-    if (!item) {
+    std::shared_ptr<FileInfo> info;
+    if (auto flatModel = qobject_cast<FlatDirectoryModel*>(view->model())) {
+        //the info of a flat model's row is only materialized when it is painted.
+        info = flatModel->infoAt(index.row());
+    } else {
+        auto model = static_cast<FileItemProxyFilterSortModel*>(view->model());
+        auto item = model->itemFromIndex(index);
+        //NOTE: item might be deleted when painting, because we might start a
+        //location change during the painting.
+        if (item)
+            info = item->info();
+    }
+    if (!info) {
         return;
     }
-    auto info = item->info();
     auto rect = view->visualRect(index);
 
     bool useIndexWidget = false;
@@ -166,7 +180,7 @@ void IconViewDelegate::paint(QPainter *painter, const QStyleOptionViewItem &opti
 
     //paint symbolic link emblems
     if (info->isSymbolLink()) {
-        QIcon icon = QIcon::fromTheme("emblem-symbolic-link");
+        QIcon icon = ThemeIconCache::getInstance()->icon("emblem-symbolic-link");
         //qDebug()<<info->symbolicIconName();
         icon.paint(painter, rect.x() + rect.width() - 30, rect.y() + 10, 20, 20, Qt::AlignCenter);
     }
@@ -174,12 +188,13 @@ void IconViewDelegate::paint(QPainter *painter, const QStyleOptionViewItem &opti
     //paint access emblems
 
     //NOTE: we can not query the file attribute in smb:///(samba) and network:///.
-    if (info->uri().startsWith("file:")) {
+    //the info might be still querying, do not paint the access emblems with its default values.
+    if (info->uri().startsWith("file:") && !info->isEmptyInfo()) {
         if (!info->canRead()) {
-            QIcon icon = QIcon::fromTheme("emblem-unreadable");
+            QIcon icon = ThemeIconCache::getInstance()->icon("emblem-unreadable");
             icon.paint(painter, rect.x() + 10, rect.y() + 10, 20, 20);
         } else if (!info->canWrite() && !info->canExecute()){
-            QIcon icon = QIcon::fromTheme("emblem-readonly");
+            QIcon icon = ThemeIconCache::getInstance()->icon("emblem-readonly");
             icon.paint(painter, rect.x() + 10, rect.y() + 10, 20, 20);
         }
         painter->restore();
@@ -343,8 +358,38 @@ QSize IconViewTextHelper::getTextSizeForIndex(const QStyleOptionViewItem &option
     return QSize(fixedWidth, textHight);
 }
 
+/*!
+ * \brief The IconViewTextLayout struct
+ * \details
+ * The shaped lines of a file name, ready to be drawn. Laying out and eliding
+ * the text is much more expensive than drawing the glyphs, and the names in
+ * a view are painted again and again while scrolling or rubber band selecting,
+ * so the layouts are kept in a LRU cache shared by all icon view delegates,
+ * desktop's included.
+ */
+struct IconViewTextLayout
+{
+    QVector<QGlyphRun> glyphRuns;
+    QVector<QPointF> origins;
+};
+
+static QCache<QString, IconViewTextLayout> *textLayoutCache()
+{
+    static QCache<QString, IconViewTextLayout> *cache = nullptr;
+    if (!cache) {
+        cache = new QCache<QString, IconViewTextLayout>(2048);
+        //the dpi is a part of the key, the old layouts are useless once
+        //the font changed.
+        QObject::connect(qApp, &QApplication::fontChanged, [=](){
+            cache->clear();
+        });
+    }
+    return cache;
+}
+
 void IconViewTextHelper::paintText(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index, int textMaxHeight, int horizalMargin, int maxLineCount, bool useSystemPalette)
 {
+    Q_UNUSED(index)
     painter->save();
     painter->translate(horizalMargin, 0);
 
@@ -355,50 +400,84 @@ void IconViewTextHelper::paintText(QPainter *painter, const QStyleOptionViewItem
             painter->setPen(option.palette.text().color());
     }
 
-    int lineCount = 0;
-
     QString text = option.text;
     QFont font = option.font;
     QFontMetrics fontMetrics = option.fontMetrics;
     int lineSpacing = fontMetrics.lineSpacing();
-
-    QTextLayout textLayout(text, font);
-
-    QTextOption opt;
-    opt.setWrapMode(QTextOption::WrapAtWordBoundaryOrAnywhere);
-    opt.setAlignment(Qt::AlignHCenter);
-
-    textLayout.setTextOption(opt);
-    textLayout.beginLayout();
-
     int width = option.rect.width() - 2*horizalMargin;
+    int dpi = painter->device()? painter->device()->logicalDpiY(): 0;
+
+    QString key = QString("%1/%2/%3/%4/%5/%6/%7/%8").arg(font.key())
+            .arg(lineSpacing)
+            .arg(dpi)
+            .arg(width)
+            .arg(textMaxHeight)
+            .arg(maxLineCount)
+            .arg(horizalMargin)
+            .arg(text);
+
+    auto cache = textLayoutCache();
+    auto layout = cache->object(key);
+    if (!layout) {
+        layout = new IconViewTextLayout;
+
+        int lineCount = 0;
+
+        QTextLayout textLayout(text, font);
+
+        QTextOption opt;
+        opt.setWrapMode(QTextOption::WrapAtWordBoundaryOrAnywhere);
+        opt.setAlignment(Qt::AlignHCenter);
+
+        textLayout.setTextOption(opt);
+        textLayout.beginLayout();
+
+        int y = 0;
+        while (true) {
+            QTextLine line = textLayout.createLine();
+            if (!line.isValid())
+                break;
+
+            line.setLineWidth(width);
+            int nextLineY = y + lineSpacing;
+            lineCount++;
+
+            if (textMaxHeight >= nextLineY + lineSpacing && lineCount != maxLineCount) {
+                for (auto glyphRun : line.glyphRuns()) {
+                    layout->glyphRuns<<glyphRun;
+                    layout->origins<<QPointF(0, y);
+                }
+                y = nextLineY;
+            } else {
+                QString lastLine = option.text.mid(line.textStart());
+                QString elidedLastLine = fontMetrics.elidedText(lastLine, Qt::ElideRight, width);
+
+                QTextLayout elidedLayout(elidedLastLine, font);
+                QTextOption elidedOpt;
+                elidedOpt.setWrapMode(QTextOption::NoWrap);
+                elidedOpt.setAlignment(Qt::AlignHCenter);
+                elidedLayout.setTextOption(elidedOpt);
+                elidedLayout.beginLayout();
+                QTextLine elidedLine = elidedLayout.createLine();
+                if (elidedLine.isValid()) {
+                    elidedLine.setLineWidth(width);
+                    for (auto glyphRun : elidedLine.glyphRuns()) {
+                        layout->glyphRuns<<glyphRun;
+                        layout->origins<<QPointF(horizalMargin, y);
+                    }
+                }
+                elidedLayout.endLayout();
+                break;
+            }
+        }
+        textLayout.endLayout();
 
-    int y = 0;
-    while (true) {
-        QTextLine line = textLayout.createLine();
-        if (!line.isValid())
-            break;
+        cache->insert(key, layout);
+    }
 
-        line.setLineWidth(width);
-        int nextLineY = y + lineSpacing;
-        lineCount++;
-
-        if (textMaxHeight >= nextLineY + lineSpacing && lineCount != maxLineCount) {
-            line.draw(painter, QPoint(0, y));
-            y = nextLineY;
-        } else {
-            QString lastLine = option.text.mid(line.textStart());
-            QString elidedLastLine = fontMetrics.elidedText(lastLine, Qt::ElideRight, width);
-            auto rect = QRect(horizalMargin, y /*+ fontMetrics.ascent()*/, width, textMaxHeight);
-            //opt.setWrapMode(QTextOption::NoWrap);
-            opt.setWrapMode(QTextOption::NoWrap);
-            painter->drawText(rect, elidedLastLine, opt);
-            //painter->drawText(QPoint(0, y + fontMetrics.ascent()), elidedLastLine);
-            line = textLayout.createLine();
-            break;
-        }
+    for (int i = 0; i < layout->glyphRuns.count(); i++) {
+        painter->drawGlyphRun(layout->origins.at(i), layout->glyphRuns.at(i));
     }
-    textLayout.endLayout();
 
     painter->restore();
 }
@@ -37,7 +37,12 @@
 
 #include "file-info.h"
 #include "file-item-proxy-filter-sort-model.h"
+#include "flat-directory-model.h"
 #include "file-item.h"
+#include "file-item-model.h"
+#include "thumbnail-manager.h"
+#include "thumbnail-shadow.h"
+#include "theme-icon-cache.h"
 
 #include <QDebug>
 
@@ -75,10 +80,14 @@ IconViewIndexWidget::IconViewIndexWidget(const IconViewDelegate *delegate, const
     setMinimumSize(size);
 
     //extra emblems
-    auto proxy_model = static_cast<FileItemProxyFilterSortModel*>(delegate->getView()->model());
-    auto item = proxy_model->itemFromIndex(index);
-    if (item) {
-        m_info = item->info();
+    if (auto flatModel = qobject_cast<FlatDirectoryModel*>(delegate->getView()->model())) {
+        m_info = flatModel->infoAt(index.row());
+    } else {
+        auto proxy_model = static_cast<FileItemProxyFilterSortModel*>(delegate->getView()->model());
+        auto item = proxy_model->itemFromIndex(index);
+        if (item) {
+            m_info = item->info();
+        }
     }
 
     m_delegate->initStyleOption(&m_option, m_index);
@@ -137,6 +146,10 @@ void IconViewIndexWidget::paintEvent(QPaintEvent *e)
                                          &p,
                                          nullptr);
 
+    if (ThumbnailManager::getInstance()->hasShadow(m_index.data(FileItemModel::UriRole).toString())) {
+        ThumbnailShadow::paint(&p, opt);
+    }
+
     auto tmp = opt.text;
     opt.text = nullptr;
     QApplication::style()->drawControl(QStyle::CE_ItemViewItem, &opt, &p, opt.widget);
@@ -165,23 +178,23 @@ void IconViewIndexWidget::paintEvent(QPaintEvent *e)
     auto info = m_info.lock();
     //paint symbolic link emblems
     if (info->isSymbolLink()) {
-        QIcon icon = QIcon::fromTheme("emblem-symbolic-link");
+        QIcon icon = ThemeIconCache::getInstance()->icon("emblem-symbolic-link");
         //qDebug()<< "symbolic:" << info->symbolicIconName();
         icon.paint(&p, this->width() - 30, 10, 20, 20, Qt::AlignCenter);
     }
 
     //paint access emblems
     //NOTE: we can not query the file attribute in smb:///(samba) and network:///.
-    if (!info->uri().startsWith("file:")) {
+    if (!info->uri().startsWith("file:") || info->isEmptyInfo()) {
         return;
     }
 
     auto rect = this->rect();
     if (!info->canRead()) {
-        QIcon icon = QIcon::fromTheme("emblem-unreadable");
+        QIcon icon = ThemeIconCache::getInstance()->icon("emblem-unreadable");
         icon.paint(&p, rect.x() + 10, rect.y() + 10, 20, 20);
     } else if (!info->canWrite() && !info->canExecute()){
-        QIcon icon = QIcon::fromTheme("emblem-readonly");
+        QIcon icon = ThemeIconCache::getInstance()->icon("emblem-readonly");
         icon.paint(&p, rect.x() + 10, rect.y() + 10, 20, 20);
     }
 }
@@ -26,6 +26,7 @@
 #include "side-bar-proxy-filter-sort-model.h"
 #include "side-bar-abstract-item.h"
 #include "side-bar-separator-item.h"
+#include "theme-icon-cache.h"
 
 #include <QPainter>
 
@@ -102,10 +103,10 @@ void SideBarDelegate::paint(QPainter *painter, const QStyleOptionViewItem &optio
     iconRect.moveTo(iconRect.topLeft() + QPoint(6, 0));
     if (sideBarView->model()->hasChildren(index)) {
         if (sideBarView->isExpanded(index)) {
-            auto icon = QIcon::fromTheme("pan-down-symbolic", QIcon::fromTheme("go-down"));
+            auto icon = ThemeIconCache::getInstance()->icon("pan-down-symbolic", "go-down");
             icon.paint(painter, iconRect, Qt::AlignCenter);
         } else {
-            auto icon = QIcon::fromTheme("pan-end-symbolic",QIcon::fromTheme("go-next"));
+            auto icon = ThemeIconCache::getInstance()->icon("pan-end-symbolic", "go-next");
             icon.paint(painter, iconRect);
         }
     }
@@ -32,19 +32,48 @@
 #include "directory-view-factory-manager.h"
 
 #include "file-item-proxy-filter-sort-model.h"
+#include "flat-directory-model.h"
+#include "directory-model-registry.h"
 
 #include <QVBoxLayout>
 #include <QAction>
 
 #include <QApplication>
 
+//switching back to a tab soon should not reload it.
+#define SUSPEND_GRACE_PERIOD 30000
+
 using namespace Peony;
 
 DirectoryViewContainer::DirectoryViewContainer(QWidget *parent) : QWidget(parent)
 {
+    //an empty model, the shared model is acquired once a location is set.
     m_model = new FileItemModel(this);
     m_proxy_model = new FileItemProxyFilterSortModel(this);
     m_proxy_model->setSourceModel(m_model);
+    m_flat_model = new FlatDirectoryModel(this);
+    //switch to the flat model once the location is known to be large.
+    connect(m_flat_model, &FlatDirectoryModel::largeDirectoryChecked, this, [=](const QString &uri, bool isLarge){
+        if (!isLarge || uri != m_current_uri || m_use_flat_model)
+            return;
+        m_large_directory_uri = uri;
+        goToUri(uri, false, true);
+    });
+
+    m_suspend_timer.setSingleShot(true);
+    m_suspend_timer.setInterval(SUSPEND_GRACE_PERIOD);
+    connect(&m_suspend_timer, &QTimer::timeout, this, &DirectoryViewContainer::suspend);
+
+    //the root of a shared model might be changed by the model itself or
+    //from another view, such as the directory was deleted.
+    connect(DirectoryModelRegistry::getInstance(), &DirectoryModelRegistry::modelRootChanged,
+            this, [=](FileItemModel *model, const QString &uri){
+        if (model != m_model || m_use_flat_model || uri == m_current_uri)
+            return;
+        m_current_uri = uri;
+        if (m_view)
+            m_view->setDirectoryUri(uri);
+    });
 
     //m_proxy = new DirectoryView::StandardViewProxy;
 
@@ -70,6 +99,7 @@ DirectoryViewContainer::DirectoryViewContainer(QWidget *parent) : QWidget(parent
 
 DirectoryViewContainer::~DirectoryViewContainer()
 {
+    releaseModel();
 //    m_proxy->closeProxy();
 //    if (m_proxy->getView())
 //        m_proxy->getView()->closeView();
@@ -147,26 +177,36 @@ void DirectoryViewContainer::setSortFilter(int FileTypeIndex, int FileMTimeIndex
 {
     qDebug()<<"setSortFilter:"<<FileTypeIndex<<"MTime:"<<FileMTimeIndex<<"size:"<<FileSizeIndex;
     m_proxy_model->setFilterConditions(FileTypeIndex, FileMTimeIndex, FileSizeIndex);
+    m_has_filter_conditions = FileTypeIndex != 0 || FileMTimeIndex != 0 || FileSizeIndex != 0;
+    //flat model can not filter, reload with the proxy model.
+    if (m_use_flat_model && m_has_filter_conditions)
+        goToUri(m_current_uri, false, true);
 }
 
 void DirectoryViewContainer::setFilterLabelConditions(QString name)
 {
     m_proxy_model->setFilterLabelConditions(name);
+    m_has_label_filter = !name.isEmpty();
+    if (m_use_flat_model && m_has_label_filter)
+        goToUri(m_current_uri, false, true);
 }
 
 void DirectoryViewContainer::setShowHidden(bool showHidden)
 {
     m_proxy_model->setShowHidden(showHidden);
+    m_flat_model->setShowHidden(showHidden);
 }
 
 void DirectoryViewContainer::setUseDefaultNameSortOrder(bool use)
 {
     m_proxy_model->setUseDefaultNameSortOrder(use);
+    m_flat_model->setUseDefaultNameSortOrder(use);
 }
 
 void DirectoryViewContainer::setSortFolderFirst(bool folderFirst)
 {
     m_proxy_model->setFolderFirst(folderFirst);
+    m_flat_model->setFolderFirst(folderFirst);
 }
 
 void DirectoryViewContainer::goToUri(const QString &uri, bool addHistory, bool forceUpdate)
@@ -195,8 +235,47 @@ update:
         m_current_uri = m_current_uri.left(m_current_uri.length()-3);
 
     if (m_view) {
+        //the size of a directory is not known until it is checked asynchronously,
+        //it is shown with the shared model meanwhile.
+        bool canUseFlatModel = m_view->supportFlatModel() &&
+                !m_has_filter_conditions && !m_has_label_filter;
+        bool useFlatModel = canUseFlatModel && m_current_uri == m_large_directory_uri;
+        //views of the same directory share the model.
+        auto oldModel = m_model;
+        bool loaded = false;
+        if (!useFlatModel)
+            loaded = acquireModel(m_current_uri);
+        bool reloadShared = !useFlatModel && m_model == oldModel &&
+                DirectoryModelRegistry::getInstance()->isShared(m_model);
+
+        if (useFlatModel != m_use_flat_model) {
+            auto sortType = m_view->getSortType();
+            auto sortOrder = m_view->getSortOrder();
+            bindViewModel(m_view, useFlatModel);
+            m_view->setSortType(sortType);
+            m_view->setSortOrder(sortOrder);
+        } else if (!useFlatModel) {
+            bindViewModel(m_view, false);
+        }
+
+        if (useFlatModel)
+            releaseModel();
+        //the new location will be loaded and monitored anyway.
+        m_suspended = false;
+
         m_view->setDirectoryUri(m_current_uri);
-        m_view->beginLocationChange();
+        if (loaded) {
+            Q_EMIT directoryChanged();
+        } else if (reloadShared) {
+            //do not reset the other views of the model.
+            m_model->catchUp();
+            Q_EMIT directoryChanged();
+        } else {
+            m_view->beginLocationChange();
+        }
+
+        if (canUseFlatModel && !useFlatModel)
+            m_flat_model->checkLargeDirectory(m_current_uri);
         //m_active_view_prxoy->setDirectoryUri(uri);
     }
 }
@@ -234,7 +313,10 @@ void DirectoryViewContainer::switchViewType(const QString &viewId)
     m_view = view;
     view->setParent(this);
     //connect the view's signal.
-    view->bindModel(m_model, m_proxy_model);
+    //a view which doesn't support flat model have to load the directory again.
+    bool useFlatModel = m_use_flat_model && view->supportFlatModel();
+    bool needReload = m_use_flat_model && !useFlatModel;
+    bindViewModel(view, useFlatModel);
     //view->setProxy(m_proxy);
 
     view->setSortType(sortType);
@@ -284,13 +366,72 @@ void DirectoryViewContainer::switchViewType(const QString &viewId)
     });
     this->addAction(editAction);
 
+    if (needReload) {
+        view->setDirectoryUri(m_current_uri);
+        //the model shared with other views has been loaded.
+        if (DirectoryModelRegistry::getInstance()->isShared(m_model)) {
+            Q_EMIT directoryChanged();
+        } else {
+            view->beginLocationChange();
+        }
+    }
+
     Q_EMIT viewTypeChanged();
 }
 
+void DirectoryViewContainer::bindViewModel(DirectoryViewWidget *view, bool useFlatModel)
+{
+    //release the children of a large directory as soon as possible.
+    if (m_use_flat_model && !useFlatModel)
+        m_flat_model->clearChildren();
+
+    if (!useFlatModel && !m_model)
+        acquireModel(m_current_uri);
+
+    m_use_flat_model = useFlatModel;
+    if (useFlatModel) {
+        view->bindFlatModel(m_flat_model);
+    } else {
+        view->bindModel(m_model, m_proxy_model);
+    }
+}
+
+bool DirectoryViewContainer::acquireModel(const QString &uri)
+{
+    bool shared = false;
+    auto model = DirectoryModelRegistry::getInstance()->acquire(uri, &shared);
+    auto oldModel = m_model;
+    releaseModel();
+    m_model = model;
+    m_proxy_model->setSourceModel(m_model);
+
+    //reload the directory if we go to the same location again.
+    return shared && model != oldModel;
+}
+
+void DirectoryViewContainer::releaseModel()
+{
+    if (!m_model)
+        return;
+
+    if (m_model->parent() == this) {
+        //the empty model used before any location is set.
+        m_model->deleteLater();
+    } else {
+        DirectoryModelRegistry::getInstance()->release(m_model, m_suspended && !m_use_flat_model);
+    }
+    m_model = nullptr;
+}
+
 void DirectoryViewContainer::refresh()
 {
     if (!m_view)
         return;
+    //do not reset the other views of a shared model.
+    if (!m_use_flat_model && DirectoryModelRegistry::getInstance()->isShared(m_model)) {
+        m_model->catchUp();
+        return;
+    }
     m_view->beginLocationChange();
 }
 
@@ -325,7 +466,9 @@ const QStringList DirectoryViewContainer::getAllFileUris()
 void DirectoryViewContainer::stopLoading()
 {
     if (m_view) {
-        m_view->stopLocationChange();
+        //the other views of a shared model are still loading it.
+        if (m_use_flat_model || !DirectoryModelRegistry::getInstance()->isShared(m_model))
+            m_view->stopLocationChange();
         Q_EMIT this->directoryChanged();
     }
 }
@@ -386,3 +529,39 @@ void DirectoryViewContainer::onViewDoubleClicked(const QString& uri)
 {
 
 }
+
+void DirectoryViewContainer::setActive(bool active)
+{
+    if (active) {
+        m_suspend_timer.stop();
+        resume();
+    } else if (!m_suspended && !m_suspend_timer.isActive()) {
+        m_suspend_timer.start();
+    }
+}
+
+void DirectoryViewContainer::suspend()
+{
+    if (m_suspended)
+        return;
+
+    m_suspended = true;
+    if (m_use_flat_model) {
+        m_flat_model->suspend();
+    } else {
+        DirectoryModelRegistry::getInstance()->suspend(m_model);
+    }
+}
+
+void DirectoryViewContainer::resume()
+{
+    if (!m_suspended)
+        return;
+
+    m_suspended = false;
+    if (m_use_flat_model) {
+        m_flat_model->resume();
+    } else {
+        DirectoryModelRegistry::getInstance()->resume(m_model);
+    }
+}
@@ -30,12 +30,15 @@
 
 #include "file-item-model.h"
 
+#include <QTimer>
+
 class QVBoxLayout;
 
 namespace Peony {
 
 class FileItemModel;
 class FileItemProxyFilterSortModel;
+class FlatDirectoryModel;
 
 class DirectoryViewProxyIface;
 class DirectoryViewWidget;
@@ -113,6 +116,18 @@ public Q_SLOTS:
 
     void onViewDoubleClicked(const QString &uri);
 
+    /*!
+     * \brief setActive
+     * \param active
+     * \details
+     * A container which is not active, such as a background tab, suspends its
+     * model after a grace period, so that hidden tabs do not keep monitoring,
+     * loading and generating thumbnails. The model catches up with the changes
+     * once the container is active again.
+     * \see FileItemModel::suspend(), FlatDirectoryModel::suspend()
+     */
+    void setActive(bool active);
+
 protected:
     /*!
      * \brief bindNewProxy
@@ -122,6 +137,30 @@ protected:
      */
     void bindNewProxy(DirectoryViewProxyIface *proxy);
 
+    /*!
+     * \brief bindViewModel
+     * \param view
+     * \param useFlatModel
+     * \details
+     * Large local directories are shown with a FlatDirectoryModel,
+     * others with the FileItemModel and its proxy model.
+     * \see FlatDirectoryModel::checkLargeDirectory()
+     */
+    void bindViewModel(DirectoryViewWidget *view, bool useFlatModel);
+
+    /*!
+     * \brief acquireModel
+     * \param uri
+     * \return true if the model of uri is shared with other views and
+     * it doesn't need to be loaded.
+     * \see DirectoryModelRegistry
+     */
+    bool acquireModel(const QString &uri);
+    void releaseModel();
+
+    void suspend();
+    void resume();
+
 private:
     QString m_current_uri;
 
@@ -135,6 +174,17 @@ private:
 
     FileItemModel *m_model;
     FileItemProxyFilterSortModel *m_proxy_model;
+
+    FlatDirectoryModel *m_flat_model;
+    bool m_use_flat_model = false;
+    //the last location checked to be large.
+    QString m_large_directory_uri;
+    //flat model doesn't support the proxy model's filters.
+    bool m_has_filter_conditions = false;
+    bool m_has_label_filter = false;
+
+    QTimer m_suspend_timer;
+    bool m_suspended = false;
 };
 
 }
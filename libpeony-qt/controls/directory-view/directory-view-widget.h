@@ -31,6 +31,7 @@ class FileItemModel;
 class FileItemProxyFilterSortModel;
 class FileItemModel;
 class FileItemProxyFilterSortModel;
+class FlatDirectoryModel;
 
 /*!
  * \brief The DirectoryViewWidget class
@@ -110,6 +111,18 @@ public Q_SLOTS:
     virtual void editUris(const QStringList uris) {}
 
     virtual void repaintView() {}
+
+    //new virtual methods must be appended here, and DirectoryViewPluginIface2_iid bumped.
+public:
+    /*!
+     * \brief supportFlatModel
+     * \return true if the view can show a FlatDirectoryModel.
+     * \see bindFlatModel()
+     */
+    virtual bool supportFlatModel() {return false;}
+
+public Q_SLOTS:
+    virtual void bindFlatModel(FlatDirectoryModel *model) {}
 };
 
 }
@@ -0,0 +1,396 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2019, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "grid-layout-engine.h"
+
+#include <algorithm>
+
+using namespace Peony;
+
+GridLayoutEngine::GridLayoutEngine(Flow flow, Placement placement)
+{
+    m_flow = flow;
+    m_placement = placement;
+}
+
+bool GridLayoutEngine::setGridSize(const QSize &size)
+{
+    auto grid = size.expandedTo(QSize(1, 1));
+    if (grid == m_grid_size)
+        return false;
+
+    m_grid_size = grid;
+    return updateLineCount();
+}
+
+bool GridLayoutEngine::setViewportSize(const QSize &size)
+{
+    if (size == m_viewport_size)
+        return false;
+
+    m_viewport_size = size;
+    return updateLineCount();
+}
+
+bool GridLayoutEngine::updateLineCount()
+{
+    int length = m_flow == LeftToRight? m_viewport_size.width(): m_viewport_size.height();
+    int cell = m_flow == LeftToRight? m_grid_size.width(): m_grid_size.height();
+    int lineCount = qMax(1, length/cell);
+    if (lineCount == m_line_count)
+        return false;
+
+    m_line_count = lineCount;
+    if (m_placement == Free) {
+        //the items out of lines will be put into free cells when the index rebuilt.
+        for (int i = 0; i < m_cells.count(); i++) {
+            if (!isCellInLines(m_cells.at(i)))
+                m_cells[i] = QPoint(-1, -1);
+        }
+        m_index_dirty = true;
+    }
+    return true;
+}
+
+void GridLayoutEngine::reset(int count)
+{
+    m_count = qMax(0, count);
+    if (m_placement == Free) {
+        m_cells.fill(QPoint(-1, -1), m_count);
+        m_index_dirty = true;
+    }
+}
+
+void GridLayoutEngine::insertItems(int first, int count)
+{
+    if (count <= 0)
+        return;
+
+    first = qBound(0, first, m_count);
+    bool append = first == m_count;
+    m_count += count;
+    if (m_placement != Free)
+        return;
+
+    m_cells.insert(first, count, QPoint(-1, -1));
+    if (!append || m_index_dirty) {
+        //rows are shifted, rebuild the index on next query.
+        m_index_dirty = true;
+        return;
+    }
+
+    for (int item = first; item < m_count; item++) {
+        placeItem(item, m_free_hint);
+    }
+}
+
+void GridLayoutEngine::removeItems(int first, int count)
+{
+    if (first < 0 || count <= 0 || first >= m_count)
+        return;
+
+    count = qMin(count, m_count - first);
+    if (m_placement == Free) {
+        if (first + count == m_count && !m_index_dirty) {
+            for (int item = first; item < m_count; item++) {
+                takeCell(item);
+            }
+        } else {
+            m_index_dirty = true;
+        }
+        m_cells.remove(first, count);
+    }
+    m_count -= count;
+}
+
+bool GridLayoutEngine::isCellInLines(const QPoint &cell) const
+{
+    if (cell.x() < 0 || cell.y() < 0)
+        return false;
+    return (m_flow == LeftToRight? cell.x(): cell.y()) < m_line_count;
+}
+
+int GridLayoutEngine::linearIndex(const QPoint &cell) const
+{
+    if (m_flow == LeftToRight)
+        return cell.y()*m_line_count + cell.x();
+    return cell.x()*m_line_count + cell.y();
+}
+
+const QPoint GridLayoutEngine::cellFromLinear(int index) const
+{
+    if (m_flow == LeftToRight)
+        return QPoint(index%m_line_count, index/m_line_count);
+    return QPoint(index/m_line_count, index%m_line_count);
+}
+
+const QPoint GridLayoutEngine::cellOf(int item) const
+{
+    if (item < 0 || item >= m_count)
+        return QPoint(-1, -1);
+
+    if (m_placement == Sequential)
+        return cellFromLinear(item);
+
+    ensureIndex();
+    return m_cells.at(item);
+}
+
+const QPoint GridLayoutEngine::cellAt(const QPoint &pos) const
+{
+    if (pos.x() < 0 || pos.y() < 0)
+        return QPoint(-1, -1);
+    return QPoint(pos.x()/m_grid_size.width(), pos.y()/m_grid_size.height());
+}
+
+const QRect GridLayoutEngine::cellRect(const QPoint &cell) const
+{
+    if (cell.x() < 0 || cell.y() < 0)
+        return QRect();
+    return QRect(QPoint(cell.x()*m_grid_size.width(), cell.y()*m_grid_size.height()), m_grid_size);
+}
+
+int GridLayoutEngine::itemAtCell(const QPoint &cell) const
+{
+    if (cell.x() < 0 || cell.y() < 0)
+        return -1;
+
+    if (m_placement == Sequential) {
+        if (!isCellInLines(cell))
+            return -1;
+        int item = linearIndex(cell);
+        return item < m_count? item: -1;
+    }
+
+    ensureIndex();
+    return m_cell_index.value(cellKey(cell), -1);
+}
+
+const QRect GridLayoutEngine::itemRect(int item) const
+{
+    auto cell = cellOf(item);
+    if (cell.x() < 0)
+        return QRect();
+    return m_item_rect.translated(cellRect(cell).topLeft());
+}
+
+int GridLayoutEngine::itemAt(const QPoint &pos) const
+{
+    int item = itemAtCell(cellAt(pos));
+    if (item < 0 || !itemRect(item).contains(pos))
+        return -1;
+    return item;
+}
+
+QVector<int> GridLayoutEngine::itemsIn(const QRect &rect) const
+{
+    QVector<int> items;
+    auto area = rect.normalized();
+    if (m_count == 0 || area.isEmpty() || area.right() < 0 || area.bottom() < 0)
+        return items;
+
+    ensureIndex();
+    auto extent = this->extent();
+    auto topLeft = cellAt(QPoint(qMax(0, area.left()), qMax(0, area.top())));
+    auto bottomRight = cellAt(area.bottomRight());
+    bottomRight.setX(qMin(bottomRight.x(), extent.width() - 1));
+    bottomRight.setY(qMin(bottomRight.y(), extent.height() - 1));
+    if (bottomRight.x() < topLeft.x() || bottomRight.y() < topLeft.y())
+        return items;
+
+    qint64 cellCount = qint64(bottomRight.x() - topLeft.x() + 1)*(bottomRight.y() - topLeft.y() + 1);
+    if (m_placement == Free && cellCount > m_count) {
+        //the area is sparse, visiting items is cheaper than visiting cells.
+        for (int item = 0; item < m_count; item++) {
+            if (itemRect(item).intersects(area))
+                items<<item;
+        }
+        return items;
+    }
+
+    bool leftToRight = m_flow == LeftToRight;
+    int majorBegin = leftToRight? topLeft.y(): topLeft.x();
+    int majorEnd = leftToRight? bottomRight.y(): bottomRight.x();
+    int minorBegin = leftToRight? topLeft.x(): topLeft.y();
+    int minorEnd = leftToRight? bottomRight.x(): bottomRight.y();
+    for (int major = majorBegin; major <= majorEnd; major++) {
+        for (int minor = minorBegin; minor <= minorEnd; minor++) {
+            auto cell = leftToRight? QPoint(minor, major): QPoint(major, minor);
+            int item = itemAtCell(cell);
+            if (item >= 0 && itemRect(item).intersects(area))
+                items<<item;
+        }
+    }
+
+    if (m_placement == Free)
+        std::sort(items.begin(), items.end());
+    return items;
+}
+
+const QSize GridLayoutEngine::extent() const
+{
+    if (m_placement == Free) {
+        ensureIndex();
+        return QSize(m_column_counts.count(), m_row_counts.count());
+    }
+
+    if (m_count == 0)
+        return QSize();
+
+    int lines = (m_count + m_line_count - 1)/m_line_count;
+    int cells = qMin(m_count, m_line_count);
+    return m_flow == LeftToRight? QSize(cells, lines): QSize(lines, cells);
+}
+
+const QSize GridLayoutEngine::contentsSize() const
+{
+    auto extent = this->extent();
+    return QSize(extent.width()*m_grid_size.width(), extent.height()*m_grid_size.height());
+}
+
+void GridLayoutEngine::moveItem(int item, const QPoint &cell)
+{
+    if (m_placement != Free || item < 0 || item >= m_count || !isCellInLines(cell))
+        return;
+
+    ensureIndex();
+    auto oldCell = m_cells.at(item);
+    if (oldCell == cell)
+        return;
+
+    int other = m_cell_index.value(cellKey(cell), -1);
+    takeCell(item);
+    if (other >= 0) {
+        takeCell(other);
+        occupyCell(other, oldCell);
+    }
+    occupyCell(item, cell);
+}
+
+void GridLayoutEngine::moveItems(const QVector<int> &items, const QPoint &offset)
+{
+    if (m_placement != Free || offset.isNull())
+        return;
+
+    ensureIndex();
+    QVector<QPoint> targets;
+    for (auto item : items) {
+        if (item < 0 || item >= m_count || m_cells.at(item).x() < 0) {
+            targets<<QPoint(-1, -1);
+            continue;
+        }
+        auto target = m_cells.at(item) + offset;
+        target.setX(qMax(0, target.x()));
+        target.setY(qMax(0, target.y()));
+        if (m_flow == LeftToRight)
+            target.setX(qMin(target.x(), m_line_count - 1));
+        else
+            target.setY(qMin(target.y(), m_line_count - 1));
+        targets<<target;
+        takeCell(item);
+    }
+
+    for (int i = 0; i < items.count(); i++) {
+        if (targets.at(i).x() < 0)
+            continue;
+        placeItem(items.at(i), linearIndex(targets.at(i)));
+    }
+}
+
+void GridLayoutEngine::ensureIndex() const
+{
+    if (m_placement != Free || !m_index_dirty)
+        return;
+
+    m_index_dirty = false;
+    m_cell_index.clear();
+    m_cell_index.reserve(m_count);
+    m_column_counts.clear();
+    m_row_counts.clear();
+    m_free_hint = 0;
+
+    QVector<int> notPlacedItems;
+    for (int item = 0; item < m_count; item++) {
+        auto cell = m_cells.at(item);
+        auto key = cellKey(cell);
+        if (cell.x() < 0 || m_cell_index.contains(key)) {
+            notPlacedItems<<item;
+            continue;
+        }
+        occupyCell(item, cell);
+    }
+
+    for (auto item : notPlacedItems) {
+        placeItem(item, m_free_hint);
+    }
+}
+
+void GridLayoutEngine::placeItem(int item, int fromLinear) const
+{
+    int index = qMax(0, fromLinear);
+    if (index <= m_free_hint)
+        index = m_free_hint;
+
+    auto cell = cellFromLinear(index);
+    while (m_cell_index.contains(cellKey(cell))) {
+        index++;
+        cell = cellFromLinear(index);
+    }
+
+    if (index == m_free_hint)
+        m_free_hint = index + 1;
+
+    occupyCell(item, cell);
+}
+
+void GridLayoutEngine::occupyCell(int item, const QPoint &cell) const
+{
+    m_cells[item] = cell;
+    m_cell_index.insert(cellKey(cell), item);
+    if (m_column_counts.count() <= cell.x())
+        m_column_counts.resize(cell.x() + 1);
+    if (m_row_counts.count() <= cell.y())
+        m_row_counts.resize(cell.y() + 1);
+    m_column_counts[cell.x()]++;
+    m_row_counts[cell.y()]++;
+}
+
+void GridLayoutEngine::takeCell(int item) const
+{
+    auto cell = m_cells.at(item);
+    if (cell.x() < 0)
+        return;
+
+    auto key = cellKey(cell);
+    if (m_cell_index.value(key, -1) == item) {
+        m_cell_index.remove(key);
+        m_column_counts[cell.x()]--;
+        m_row_counts[cell.y()]--;
+        while (!m_column_counts.isEmpty() && m_column_counts.last() == 0)
+            m_column_counts.removeLast();
+        while (!m_row_counts.isEmpty() && m_row_counts.last() == 0)
+            m_row_counts.removeLast();
+    }
+    if (isCellInLines(cell))
+        m_free_hint = qMin(m_free_hint, linearIndex(cell));
+    m_cells[item] = QPoint(-1, -1);
+}
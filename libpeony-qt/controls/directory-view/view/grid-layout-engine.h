@@ -0,0 +1,199 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2019, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef GRIDLAYOUTENGINE_H
+#define GRIDLAYOUTENGINE_H
+
+#include "peony-core_global.h"
+
+#include <QVector>
+#include <QHash>
+#include <QRect>
+
+namespace Peony {
+
+/*!
+ * \brief The GridLayoutEngine class
+ * <br>
+ * GridLayoutEngine computes the geometries of the items in an icon view, whose
+ * items are all placed in the cells of a uniform grid. IconView and DesktopIconView
+ * use it instead of the internal layout of QListView, which relayouts all items
+ * for every rows insertion and does hit-testing by walking the items.
+ * </br>
+ * <br>
+ * With Sequential placement, items fill the cells in flow order, the cell of
+ * an item is computed from its row. Inserting or removing rows only changes
+ * the item count.
+ * </br>
+ * <br>
+ * With Free placement, each item keeps its own cell, which might be moved by user.
+ * The inserted items are put into the first free cells in flow order. A cell to item
+ * hash is used as the spatial index, and it is rebuilt lazily, so that a batch of
+ * insertions only costs one rebuilding. Cells are counted in grid units, so the
+ * layout is kept when the grid size is changed by zooming.
+ * </br>
+ * \note
+ * Coordinates are in contents space, views should translate them by their
+ * scroll offsets.
+ */
+class PEONYCORESHARED_EXPORT GridLayoutEngine
+{
+public:
+    enum Flow {
+        LeftToRight,
+        TopToBottom
+    };
+
+    enum Placement {
+        Sequential,
+        Free
+    };
+
+    explicit GridLayoutEngine(Flow flow = LeftToRight, Placement placement = Sequential);
+
+    Flow flow() const {return m_flow;}
+    Placement placement() const {return m_placement;}
+
+    const QSize gridSize() const {return m_grid_size;}
+    /*!
+     * \brief setGridSize
+     * \param size
+     * \return true if the count of cells in a line changed.
+     */
+    bool setGridSize(const QSize &size);
+    /*!
+     * \brief setViewportSize
+     * \param size
+     * \return true if the count of cells in a line changed.
+     */
+    bool setViewportSize(const QSize &size);
+
+    /*!
+     * \brief setItemRect
+     * \param rect, the geometry of an item relative to the top left of its cell.
+     */
+    void setItemRect(const QRect &rect) {m_item_rect = rect;}
+    const QRect itemRect() const {return m_item_rect;}
+
+    int count() const {return m_count;}
+    /*!
+     * \brief lineCount
+     * \return the count of cells in a line, which is columns count for
+     * LeftToRight flow and rows count for TopToBottom flow.
+     */
+    int lineCount() const {return m_line_count;}
+
+    /*!
+     * \brief reset
+     * \param count
+     * \details
+     * Layout all items in flow order again, the cells of free placed
+     * items are dropped.
+     */
+    void reset(int count);
+    void insertItems(int first, int count);
+    void removeItems(int first, int count);
+
+    /*!
+     * \brief cellOf
+     * \param item
+     * \return the cell of item, or (-1, -1) if item is invalid.
+     */
+    const QPoint cellOf(int item) const;
+    const QPoint cellAt(const QPoint &pos) const;
+    const QRect cellRect(const QPoint &cell) const;
+    int itemAtCell(const QPoint &cell) const;
+
+    const QRect itemRect(int item) const;
+    int itemAt(const QPoint &pos) const;
+    /*!
+     * \brief itemsIn
+     * \param rect
+     * \return the items intersecting rect in ascending order.
+     * \details
+     * Only the cells covered by rect are visited, which is used for painting,
+     * and rubber band selection.
+     */
+    QVector<int> itemsIn(const QRect &rect) const;
+
+    const QSize contentsSize() const;
+
+    /*!
+     * \brief moveItem
+     * \param item
+     * \param cell
+     * \details
+     * Move a free placed item to cell. If the cell is taken by another
+     * item, these two items are swapped.
+     */
+    void moveItem(int item, const QPoint &cell);
+    /*!
+     * \brief moveItems
+     * \param items
+     * \param offset
+     * \details
+     * Move free placed items by offset cells, an item will be put into the next free cell
+     * if its target cell is taken.
+     */
+    void moveItems(const QVector<int> &items, const QPoint &offset);
+
+private:
+    static quint64 cellKey(const QPoint &cell) {
+        return (quint64(quint32(cell.x())) << 32) | quint32(cell.y());
+    }
+
+    bool isCellInLines(const QPoint &cell) const;
+    int linearIndex(const QPoint &cell) const;
+    const QPoint cellFromLinear(int index) const;
+    const QSize extent() const;
+
+    bool updateLineCount();
+    void ensureIndex() const;
+    void placeItem(int item, int fromLinear) const;
+    void occupyCell(int item, const QPoint &cell) const;
+    void takeCell(int item) const;
+
+private:
+    Flow m_flow;
+    Placement m_placement;
+
+    QSize m_grid_size = QSize(96, 96);
+    QSize m_viewport_size;
+    QRect m_item_rect = QRect(0, 0, 96, 96);
+    int m_line_count = 1;
+    int m_count = 0;
+
+    //free placement, item to cell, (-1, -1) for a not placed item.
+    mutable QVector<QPoint> m_cells;
+    mutable QHash<quint64, int> m_cell_index;
+    mutable bool m_index_dirty = false;
+    //all the cells before this linear index are taken.
+    mutable int m_free_hint = 0;
+    //free placement, the counts of placed items in each column and row. the empty
+    //trailing ones are dropped, so the extent shrinks when items are removed.
+    mutable QVector<int> m_column_counts;
+    mutable QVector<int> m_row_counts;
+};
+
+}
+
+#endif // GRIDLAYOUTENGINE_H
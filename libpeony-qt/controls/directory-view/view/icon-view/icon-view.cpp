@@ -45,6 +45,9 @@
 #include <QVBoxLayout>
 
 #include <QHoverEvent>
+#include <QScrollBar>
+#include <QStyleOption>
+#include <QRubberBand>
 
 #include <QDebug>
 
@@ -73,6 +76,9 @@ IconView::IconView(QWidget *parent) : QListView(parent)
     setGridSize(QSize(115, 135));
     setIconSize(QSize(64, 64));
 
+    //all items have the same size hint, so they can be placed arithmetically.
+    m_layout.setItemRect(QRect(QPoint(15, 15), delegate->sizeHint(viewOptions(), QModelIndex())));
+
 
     m_renameTimer = new QTimer(this);
     m_renameTimer->setInterval(3000);
@@ -95,7 +101,7 @@ void IconView::setSelections(const QStringList &uris)
 {
     clearSelection();
     for (auto uri: uris) {
-        const QModelIndex index = m_sort_filter_proxy_model->indexFromUri(uri);
+        const QModelIndex index = indexFromUri(uri);
         if (index.isValid()) {
             selectionModel()->select(index, QItemSelectionModel::Select);
         }
@@ -107,8 +113,7 @@ const QStringList IconView::getSelections()
     QStringList uris;
     QModelIndexList selections = selectedIndexes();
     for (auto index : selections) {
-        auto item = m_sort_filter_proxy_model->itemFromIndex(index);
-        uris<<item->uri();
+        uris<<index.data(FileItemModel::UriRole).toString();
     }
     return uris;
 }
@@ -123,7 +128,7 @@ void IconView::invertSelections()
 
 void IconView::scrollToSelection(const QString &uri)
 {
-    auto index = m_sort_filter_proxy_model->indexFromUri(uri);
+    auto index = indexFromUri(uri);
     scrollTo(index);
 }
 
@@ -142,16 +147,26 @@ void IconView::setDirectoryUri(const QString &uri)
 
 const QString IconView::getDirectoryUri()
 {
+    if (m_flat_model)
+        return m_flat_model->getRootUri();
     return m_model->getRootUri();
 }
 
 void IconView::beginLocationChange()
 {
+    if (m_flat_model) {
+        m_flat_model->setRootUri(m_current_uri);
+        return;
+    }
     m_model->setRootUri(m_current_uri);
 }
 
 void IconView::stopLocationChange()
 {
+    if (m_flat_model) {
+        m_flat_model->cancelFindChildren();
+        return;
+    }
     m_model->cancelFindChildren();
 }
 
@@ -200,8 +215,15 @@ void IconView::dropEvent(QDropEvent *e)
     //m_edit_trigger_timer.stop();
     e->setDropAction(Qt::MoveAction);
     auto proxy_index = indexAt(e->pos());
-    auto index = m_sort_filter_proxy_model->mapToSource(proxy_index);
     qDebug()<<"dropEvent";
+    if (m_flat_model) {
+        //flat model has no proxy.
+        if (e->source() == this && !proxy_index.isValid())
+            return;
+        m_flat_model->dropMimeData(e->mimeData(), Qt::MoveAction, 0, 0, proxy_index);
+        return;
+    }
+    auto index = m_sort_filter_proxy_model->mapToSource(proxy_index);
     if (e->source() == this) {
         if (indexAt(e->pos()).isValid()) {
             m_model->dropMimeData(e->mimeData(), Qt::MoveAction, 0, 0, index);
@@ -218,6 +240,7 @@ void IconView::mousePressEvent(QMouseEvent *e)
 {
     qDebug()<<"moursePressEvent";
     m_editValid = true;
+    m_pressed_pos = e->pos() + QPoint(horizontalOffset(), verticalOffset());
     QListView::mousePressEvent(e);
 
     if (e->button() != Qt::LeftButton) {
@@ -245,10 +268,29 @@ void IconView::mousePressEvent(QMouseEvent *e)
 
 }
 
+void IconView::mouseMoveEvent(QMouseEvent *e)
+{
+    QListView::mouseMoveEvent(e);
+
+    if (state() != DragSelectingState)
+        return;
+
+    const QPoint offset(horizontalOffset(), verticalOffset());
+    auto rubberBand = QRect(m_pressed_pos, e->pos() + offset).normalized();
+    viewport()->update(rubberBand.united(m_rubber_band).translated(-offset).adjusted(-16, -16, 16, 16));
+    m_rubber_band = rubberBand;
+}
+
 void IconView::mouseReleaseEvent(QMouseEvent *e)
 {
     QListView::mouseReleaseEvent(e);
 
+    if (m_rubber_band.isValid()) {
+        const QPoint offset(horizontalOffset(), verticalOffset());
+        viewport()->update(m_rubber_band.translated(-offset).adjusted(-16, -16, 16, 16));
+        m_rubber_band = QRect();
+    }
+
     if (e->button() != Qt::LeftButton) {
         return;
     }
@@ -270,7 +312,56 @@ void IconView::paintEvent(QPaintEvent *e)
             this->repaint();
         });
     }
-    QListView::paintEvent(e);
+
+    if (!model())
+        return;
+
+    //only the items in exposed cells are painted.
+    const QPoint offset(horizontalOffset(), verticalOffset());
+    auto rows = m_layout.itemsIn(e->rect().translated(offset));
+
+    QStyleOptionViewItem option = viewOptions();
+    const QStyle::State state = option.state;
+    const bool enabled = (state & QStyle::State_Enabled) != 0;
+    const QModelIndex current = currentIndex();
+    const bool focus = (hasFocus() || viewport()->hasFocus()) && current.isValid();
+    for (auto row : rows) {
+        auto index = model()->index(row, modelColumn(), rootIndex());
+        if (!index.isValid())
+            continue;
+
+        option.rect = visualRect(index);
+        option.state = state;
+        if (selectionModel() && selectionModel()->isSelected(index))
+            option.state |= QStyle::State_Selected;
+        if (enabled) {
+            if (model()->flags(index) & Qt::ItemIsEnabled) {
+                option.palette.setCurrentColorGroup(QPalette::Normal);
+            } else {
+                option.state &= ~QStyle::State_Enabled;
+                option.palette.setCurrentColorGroup(QPalette::Disabled);
+            }
+        }
+        if (focus && index == current) {
+            option.state |= QStyle::State_HasFocus;
+            if (this->state() == EditingState)
+                option.state |= QStyle::State_Editing;
+        }
+        option.state.setFlag(QStyle::State_MouseOver, index == m_hover_index);
+
+        itemDelegate(index)->paint(&p, option, index);
+    }
+
+    if (m_rubber_band.isValid()) {
+        QStyleOptionRubberBand opt;
+        opt.initFrom(this);
+        opt.shape = QRubberBand::Rectangle;
+        opt.opaque = false;
+        opt.rect = m_rubber_band.translated(-offset).intersected(viewport()->rect().adjusted(-16, -16, 16, 16));
+        p.save();
+        style()->drawControl(QStyle::CE_RubberBand, &opt, &p);
+        p.restore();
+    }
 }
 
 void IconView::resizeEvent(QResizeEvent *e)
@@ -279,6 +370,12 @@ void IconView::resizeEvent(QResizeEvent *e)
     //but I have to reset the index widget in view's resize.
     QListView::resizeEvent(e);
     setIndexWidget(m_last_index, nullptr);
+
+    //reflow the cells at once, the delayed layout of QListView is not needed.
+    if (m_layout.setViewportSize(viewport()->size())) {
+        updateGeometries();
+        viewport()->update();
+    }
 }
 
 void IconView::wheelEvent(QWheelEvent *e)
@@ -288,6 +385,24 @@ void IconView::wheelEvent(QWheelEvent *e)
         this->viewport()->update();
 }
 
+bool IconView::viewportEvent(QEvent *e)
+{
+    //QAbstractItemView keeps its hover index private, track it for painting.
+    switch (e->type()) {
+    case QEvent::HoverEnter:
+    case QEvent::HoverMove:
+        m_hover_index = indexAt(static_cast<QHoverEvent *>(e)->pos());
+        break;
+    case QEvent::HoverLeave:
+    case QEvent::Leave:
+        m_hover_index = QModelIndex();
+        break;
+    default:
+        break;
+    }
+    return QListView::viewportEvent(e);
+}
+
 void IconView::slotRename()
 {
     //delay edit action to avoid doubleClick or dragEvent
@@ -308,8 +423,27 @@ void IconView::bindModel(FileItemModel *sourceModel, FileItemProxyFilterSortMode
 {
     m_model = sourceModel;
     m_sort_filter_proxy_model = proxyModel;
+    m_flat_model = nullptr;
+
+    //only the source model of the proxy model is changed.
+    if (model() == m_sort_filter_proxy_model)
+        return;
 
     setModel(m_sort_filter_proxy_model);
+    setupSelectionModel();
+}
+
+void IconView::bindFlatModel(FlatDirectoryModel *model)
+{
+    m_flat_model = model;
+
+    setModel(m_flat_model);
+    setupSelectionModel();
+}
+
+void IconView::setupSelectionModel()
+{
+    m_last_index = QModelIndex();
 
     //edit trigger
     connect(this->selectionModel(), &QItemSelectionModel::selectionChanged, [=](const QItemSelection &selection, const QItemSelection &deselection){
@@ -385,6 +519,10 @@ void IconView::resort()
         this->setIndexWidget(m_last_index, nullptr);
     }
 
+    //flat model keeps its children sorted itself.
+    if (m_flat_model)
+        return;
+
     if (m_sort_filter_proxy_model)
         m_sort_filter_proxy_model->sort(getSortType(), Qt::SortOrder(getSortOrder()));
 }
@@ -397,44 +535,207 @@ void IconView::reportViewDirectoryChanged()
 
 QRect IconView::visualRect(const QModelIndex &index) const
 {
-    auto rect = QListView::visualRect(index);
-    rect.setX(rect.x() + 10);
-    rect.setY(rect.y() + 15);
-    auto size = itemDelegate()->sizeHint(QStyleOptionViewItem(), index);
-    rect.setSize(size);
-    return rect;
+    if (!index.isValid() || index.parent() != rootIndex())
+        return QRect();
+
+    auto rect = m_layout.itemRect(index.row());
+    return rect.translated(-horizontalOffset(), -verticalOffset());
+}
+
+QModelIndex IconView::indexAt(const QPoint &point) const
+{
+    if (!model())
+        return QModelIndex();
+
+    int row = m_layout.itemAt(point + QPoint(horizontalOffset(), verticalOffset()));
+    if (row < 0)
+        return QModelIndex();
+    return model()->index(row, modelColumn(), rootIndex());
+}
+
+void IconView::doItemsLayout()
+{
+    m_layout.setGridSize(gridSize());
+    m_layout.setViewportSize(viewport()->size());
+    m_layout.reset(model()? model()->rowCount(rootIndex()): 0);
+
+    //skip the QListView's layout.
+    QAbstractItemView::doItemsLayout();
+}
+
+void IconView::rowsInserted(const QModelIndex &parent, int start, int end)
+{
+    //QListView relayouts all items here, we only need to append cells.
+    if (parent == rootIndex()) {
+        m_layout.insertItems(start, end - start + 1);
+        updateGeometries();
+        viewport()->update();
+    }
+    QAbstractItemView::rowsInserted(parent, start, end);
+}
+
+void IconView::rowsAboutToBeRemoved(const QModelIndex &parent, int start, int end)
+{
+    if (parent == rootIndex()) {
+        if (m_hover_index.isValid() && m_hover_index.row() >= start && m_hover_index.row() <= end)
+            m_hover_index = QModelIndex();
+        m_layout.removeItems(start, end - start + 1);
+        updateGeometries();
+        viewport()->update();
+    }
+    QAbstractItemView::rowsAboutToBeRemoved(parent, start, end);
+}
+
+void IconView::setSelection(const QRect &rect, QItemSelectionModel::SelectionFlags command)
+{
+    if (!model() || !selectionModel())
+        return;
+
+    auto rows = m_layout.itemsIn(rect.normalized().translated(horizontalOffset(), verticalOffset()));
+    int rowCount = model()->rowCount(rootIndex());
+
+    //merge the continuous rows into ranges.
+    QItemSelection selection;
+    int i = 0;
+    while (i < rows.count()) {
+        int first = rows.at(i);
+        int last = first;
+        while (i + 1 < rows.count() && rows.at(i + 1) == last + 1) {
+            i++;
+            last++;
+        }
+        i++;
+        if (first >= rowCount)
+            break;
+        last = qMin(last, rowCount - 1);
+        selection.select(model()->index(first, modelColumn(), rootIndex()),
+                         model()->index(last, modelColumn(), rootIndex()));
+    }
+    selectionModel()->select(selection, command);
+}
+
+QModelIndex IconView::moveCursor(CursorAction cursorAction, Qt::KeyboardModifiers modifiers)
+{
+    Q_UNUSED(modifiers)
+    if (!model())
+        return QModelIndex();
+
+    int rowCount = model()->rowCount(rootIndex());
+    if (rowCount <= 0)
+        return QModelIndex();
+
+    auto current = currentIndex();
+    if (!current.isValid())
+        return model()->index(0, modelColumn(), rootIndex());
+
+    int row = current.row();
+    int columns = m_layout.lineCount();
+    int pageRows = qMax(1, viewport()->height()/gridSize().height());
+    switch (cursorAction) {
+    case MoveLeft:
+    case MovePrevious:
+        row--;
+        break;
+    case MoveRight:
+    case MoveNext:
+        row++;
+        break;
+    case MoveUp:
+        row -= columns;
+        break;
+    case MoveDown:
+        //move to the last item if there is no item just below.
+        if (row + columns < rowCount)
+            row += columns;
+        else if (row/columns < (rowCount - 1)/columns)
+            row = rowCount - 1;
+        break;
+    case MovePageUp:
+        row -= columns*pageRows;
+        break;
+    case MovePageDown:
+        row += columns*pageRows;
+        break;
+    case MoveHome:
+        row = 0;
+        break;
+    case MoveEnd:
+        row = rowCount - 1;
+        break;
+    }
+
+    if (row < 0 && cursorAction != MovePageUp)
+        return current;
+    row = qBound(0, row, rowCount - 1);
+    return model()->index(row, modelColumn(), rootIndex());
+}
+
+void IconView::updateGeometries()
+{
+    auto contentsSize = m_layout.contentsSize();
+    auto viewportSize = viewport()->size();
+
+    horizontalScrollBar()->setSingleStep(gridSize().width());
+    horizontalScrollBar()->setPageStep(viewportSize.width());
+    horizontalScrollBar()->setRange(0, qMax(0, contentsSize.width() - viewportSize.width()));
+
+    verticalScrollBar()->setSingleStep(gridSize().height());
+    verticalScrollBar()->setPageStep(viewportSize.height());
+    verticalScrollBar()->setRange(0, qMax(0, contentsSize.height() - viewportSize.height()));
+
+    //skip the QListView's scroll bars updating, it depends on its own layout.
+    QAbstractItemView::updateGeometries();
 }
 
 int IconView::getSortType()
 {
-    int type = m_sort_filter_proxy_model->sortColumn();
+    int type = m_flat_model? m_flat_model->sortColumn(): m_sort_filter_proxy_model->sortColumn();
     return type<0? 0: type;
 }
 
 void IconView::setSortType(int sortType)
 {
+    if (m_flat_model) {
+        m_flat_model->sort(sortType, Qt::SortOrder(getSortOrder()));
+        return;
+    }
     m_sort_filter_proxy_model->sort(sortType, Qt::SortOrder(getSortOrder()));
 }
 
 int IconView::getSortOrder()
 {
+    if (m_flat_model)
+        return m_flat_model->sortOrder();
     return m_sort_filter_proxy_model->sortOrder();
 }
 
 void IconView::setSortOrder(int sortOrder)
 {
+    if (m_flat_model) {
+        m_flat_model->sort(getSortType(), Qt::SortOrder(sortOrder));
+        return;
+    }
     m_sort_filter_proxy_model->sort(getSortType(), Qt::SortOrder(sortOrder));
 }
 
 const QStringList IconView::getAllFileUris()
 {
+    if (m_flat_model)
+        return m_flat_model->getAllFileUris();
     return m_sort_filter_proxy_model->getAllFileUris();
 }
 
+const QModelIndex IconView::indexFromUri(const QString &uri)
+{
+    if (m_flat_model)
+        return m_flat_model->indexFromUri(uri);
+    return m_sort_filter_proxy_model->indexFromUri(uri);
+}
+
 void IconView::editUri(const QString &uri)
 {
-    setIndexWidget(m_sort_filter_proxy_model->indexFromUri(uri), nullptr);
-    edit(m_sort_filter_proxy_model->indexFromUri(uri));
+    setIndexWidget(indexFromUri(uri), nullptr);
+    edit(indexFromUri(uri));
 }
 
 void IconView::editUris(const QStringList uris)
@@ -445,8 +746,11 @@ void IconView::editUris(const QStringList uris)
 
 void IconView::clearIndexWidget()
 {
-    for (int i = 0; i < m_sort_filter_proxy_model->rowCount(); i++) {
-        auto index = m_sort_filter_proxy_model->index(i, 0);
+    if (!model())
+        return;
+
+    for (int i = 0; i < model()->rowCount(); i++) {
+        auto index = model()->index(i, 0);
         setIndexWidget(index, nullptr);
     }
 }
@@ -461,6 +765,23 @@ IconView2::IconView2(QWidget *parent) : DirectoryViewWidget(parent)
     layout->addWidget(m_view);
 
     setLayout(layout);
+
+    //the view might be rebound between models, connect the view's
+    //own signals only once.
+    connect(m_view, &IconView::doubleClicked, this, [=](const QModelIndex &index){
+        Q_EMIT this->viewDoubleClicked(index.data(Qt::UserRole).toString());
+    });
+
+    connect(m_view, &IconView::customContextMenuRequested, this, [=](const QPoint &pos){
+        if (!m_view->indexAt(pos).isValid())
+            m_view->clearSelection();
+
+        //NOTE: we have to ensure that we have cleared the
+        //selection if menu request at blank pos.
+        QTimer::singleShot(1, [=](){
+            Q_EMIT this->menuRequest(QCursor::pos());
+        });
+    });
 }
 
 IconView2::~IconView2()
@@ -470,8 +791,7 @@ IconView2::~IconView2()
 
 void IconView2::bindModel(FileItemModel *model, FileItemProxyFilterSortModel *proxyModel)
 {
-    disconnect(m_model);
-    disconnect(m_proxy_model);
+    unbindModels();
     m_model = model;
     m_proxy_model = proxyModel;
 
@@ -483,29 +803,46 @@ void IconView2::bindModel(FileItemModel *model, FileItemProxyFilterSortModel *pr
     connect(m_view->selectionModel(), &QItemSelectionModel::selectionChanged,
             this, &DirectoryViewWidget::viewSelectionChanged);
 
-    connect(m_view, &IconView::doubleClicked, this, [=](const QModelIndex &index){
-        Q_EMIT this->viewDoubleClicked(index.data(Qt::UserRole).toString());
+    connect(m_proxy_model, &FileItemProxyFilterSortModel::layoutChanged, this, [=](){
+        Q_EMIT this->sortOrderChanged(Qt::SortOrder(getSortOrder()));
     });
+    connect(m_proxy_model, &FileItemProxyFilterSortModel::layoutChanged, this, [=](){
+        Q_EMIT this->sortTypeChanged(getSortType());
+    });
+}
 
-    connect(m_view, &IconView::customContextMenuRequested, this, [=](const QPoint &pos){
-        if (!m_view->indexAt(pos).isValid())
-            m_view->clearSelection();
+void IconView2::bindFlatModel(FlatDirectoryModel *model)
+{
+    unbindModels();
+    m_flat_model = model;
 
-        //NOTE: we have to ensure that we have cleared the
-        //selection if menu request at blank pos.
-        QTimer::singleShot(1, [=](){
-            Q_EMIT this->menuRequest(QCursor::pos());
-        });
-    });
+    m_view->bindFlatModel(model);
+    connect(m_flat_model, &FlatDirectoryModel::findChildrenFinished, this, &DirectoryViewWidget::viewDirectoryChanged);
 
-    connect(m_proxy_model, &FileItemProxyFilterSortModel::layoutChanged, this, [=](){
+    connect(m_view->selectionModel(), &QItemSelectionModel::selectionChanged,
+            this, &DirectoryViewWidget::viewSelectionChanged);
+
+    connect(m_flat_model, &FlatDirectoryModel::layoutChanged, this, [=](){
         Q_EMIT this->sortOrderChanged(Qt::SortOrder(getSortOrder()));
-    });
-    connect(m_proxy_model, &FileItemProxyFilterSortModel::layoutChanged, this, [=](){
         Q_EMIT this->sortTypeChanged(getSortType());
     });
 }
 
+void IconView2::unbindModels()
+{
+    //do not disconnect the models from m_view, the view connects
+    //the model's signals itself in setModel().
+    for (QObject *model : QList<QObject*>()<<m_model<<m_proxy_model<<m_flat_model) {
+        if (model)
+            model->disconnect(this);
+    }
+    if (m_model)
+        disconnect(m_model, &FileItemModel::updated, m_view, &IconView::resort);
+    m_model = nullptr;
+    m_proxy_model = nullptr;
+    m_flat_model = nullptr;
+}
+
 void IconView2::repaintView()
 {
     m_view->update();
@@ -27,6 +27,8 @@
 #include "directory-view-plugin-iface.h"
 #include "file-item-model.h"
 #include "file-item-proxy-filter-sort-model.h"
+#include "flat-directory-model.h"
+#include "grid-layout-engine.h"
 
 #include "directory-view-widget.h"
 
@@ -60,6 +62,7 @@ public:
     const QString viewId() override {return tr("Icon View");}
 
     void bindModel(FileItemModel *sourceModel, FileItemProxyFilterSortModel *proxyModel) override;
+    void bindFlatModel(FlatDirectoryModel *model) override;
     void setProxy(DirectoryViewProxyIface *proxy) override;
 
     /*!
@@ -81,6 +84,15 @@ public:
     const QStringList getAllFileUris() override;
 
     QRect visualRect(const QModelIndex &index) const override;
+    QModelIndex indexAt(const QPoint &point) const override;
+
+    /*!
+     * \brief doItemsLayout
+     * \details
+     * IconView doesn't use the item layout of QListView, items are placed
+     * by a GridLayoutEngine, see GridLayoutEngine.
+     */
+    void doItemsLayout() override;
 
 public Q_SLOTS:
     //location
@@ -125,16 +137,29 @@ protected:
     void mousePressEvent(QMouseEvent *e) override;
     void mouseReleaseEvent(QMouseEvent *e) override;
 
+    void mouseMoveEvent(QMouseEvent *e) override;
     void mouseDoubleClickEvent(QMouseEvent *event) override;
 
     void paintEvent(QPaintEvent *e) override;
     void resizeEvent(QResizeEvent *e) override;
 
     void wheelEvent(QWheelEvent *e) override;
+    bool viewportEvent(QEvent *e) override;
+
+    void rowsInserted(const QModelIndex &parent, int start, int end) override;
+    void rowsAboutToBeRemoved(const QModelIndex &parent, int start, int end) override;
+
+    void setSelection(const QRect &rect, QItemSelectionModel::SelectionFlags command) override;
+    QModelIndex moveCursor(CursorAction cursorAction, Qt::KeyboardModifiers modifiers) override;
+    void updateGeometries() override;
 
 private Q_SLOTS:
     void slotRename();
 
+private:
+    void setupSelectionModel();
+    const QModelIndex indexFromUri(const QString &uri);
+
 private:
     QTimer m_repaint_timer;
 
@@ -143,11 +168,25 @@ private:
 
     QModelIndex m_last_index;
 
+    GridLayoutEngine m_layout;
+    QPersistentModelIndex m_hover_index;
+    //rubber band and pressed position are in contents coordinates.
+    QRect m_rubber_band;
+    QPoint m_pressed_pos;
+
     DirectoryViewProxyIface *m_proxy = nullptr;
 
     FileItemModel *m_model = nullptr;
     FileItemProxyFilterSortModel *m_sort_filter_proxy_model = nullptr;
 
+    /*!
+     * \brief m_flat_model
+     * \details
+     * If it is not null, the view is showing a large flat directory with this
+     * model, and m_model and m_sort_filter_proxy_model are not used.
+     */
+    FlatDirectoryModel *m_flat_model = nullptr;
+
     QString m_current_uri = nullptr;
 
     /*!
@@ -180,8 +219,11 @@ public:
     int getSortType() {return m_view->getSortType();}
     Qt::SortOrder getSortOrder() {return Qt::SortOrder(m_view->getSortOrder());}
 
+    bool supportFlatModel() {return true;}
+
 public Q_SLOTS:
     void bindModel(FileItemModel *model, FileItemProxyFilterSortModel *proxyModel);
+    void bindFlatModel(FlatDirectoryModel *model);
 
     //location
     //void open(const QStringList &uris, bool newWindow);
@@ -208,10 +250,14 @@ public Q_SLOTS:
 
     void repaintView();
 
+private:
+    void unbindModels();
+
 private:
     IconView *m_view = nullptr;
     FileItemModel *m_model = nullptr;
     FileItemProxyFilterSortModel *m_proxy_model = nullptr;
+    FlatDirectoryModel *m_flat_model = nullptr;
 };
 
 }
@@ -23,6 +23,7 @@
 #include "list-view.h"
 #include "file-item-model.h"
 #include "file-item-proxy-filter-sort-model.h"
+#include "flat-directory-model.h"
 
 #include "list-view-delegate.h"
 
@@ -51,6 +52,25 @@ ListView::ListView(QWidget *parent) : QTreeView(parent)
     setExpandsOnDoubleClick(false);
     setSortingEnabled(true);
 
+    //the model might be shared with other tree views, the children of a
+    //folder are kept until all of them collapsed it.
+    connect(this, &QTreeView::expanded, this, [=](const QModelIndex &index){
+        if (m_flat_model || !m_proxy_model)
+            return;
+        auto item = m_proxy_model->itemFromIndex(index);
+        if (item && !m_expanded_items.contains(item)) {
+            m_expanded_items<<item;
+            item->addExpandedView();
+        }
+    });
+    connect(this, &QTreeView::collapsed, this, [=](const QModelIndex &index){
+        if (m_flat_model || !m_proxy_model)
+            return;
+        auto item = m_proxy_model->itemFromIndex(index);
+        if (item && m_expanded_items.removeOne(item))
+            item->removeExpandedView();
+    });
+
     setEditTriggers(QTreeView::NoEditTriggers);
     setDragEnabled(true);
     setDragDropMode(QTreeView::DragDrop);
@@ -64,17 +84,59 @@ ListView::ListView(QWidget *parent) : QTreeView(parent)
     m_editValid = false;
 }
 
+ListView::~ListView()
+{
+    releaseExpandedItems();
+}
+
+void ListView::releaseExpandedItems()
+{
+    for (auto item : m_expanded_items) {
+        //the item might have been deleted with its parent or the model.
+        if (item)
+            item->removeExpandedView();
+    }
+    m_expanded_items.clear();
+}
+
 void ListView::bindModel(FileItemModel *sourceModel, FileItemProxyFilterSortModel *proxyModel)
 {
     if (!sourceModel || !proxyModel)
         return;
+    //the items of the previous model are not shown any more.
+    if (sourceModel != m_model)
+        releaseExpandedItems();
     m_model = sourceModel;
     m_proxy_model = proxyModel;
+    m_flat_model = nullptr;
     m_proxy_model->setSourceModel(m_model);
+    //only the source model of the proxy model is changed.
+    if (model() == proxyModel)
+        return;
+
     setModel(proxyModel);
     //adjust columns layout.
     adjustColumnsSize();
 
+    setupSelectionModel();
+}
+
+void ListView::bindFlatModel(FlatDirectoryModel *model)
+{
+    if (!model)
+        return;
+    releaseExpandedItems();
+    m_flat_model = model;
+    setModel(model);
+    adjustColumnsSize();
+
+    setupSelectionModel();
+}
+
+void ListView::setupSelectionModel()
+{
+    m_last_index = QModelIndex();
+
     //edit trigger
     connect(this->selectionModel(), &QItemSelectionModel::selectionChanged, [=](const QItemSelection &selection, const QItemSelection &deselection){
         qDebug()<<"selection changed";
@@ -220,6 +282,9 @@ void ListView::setProxy(DirectoryViewProxyIface *proxy)
 
 void ListView::resort()
 {
+    //flat model keeps its children sorted itself.
+    if (m_flat_model)
+        return;
     m_proxy_model->sort(getSortType(), Qt::SortOrder(getSortOrder()));
 }
 
@@ -259,6 +324,8 @@ DirectoryViewProxyIface *ListView::getProxy()
 
 const QString ListView::getDirectoryUri()
 {
+    if (m_flat_model)
+        return m_flat_model->getRootUri();
     if (!m_model)
         return nullptr;
     return m_model->getRootUri();
@@ -284,7 +351,7 @@ void ListView::setSelections(const QStringList &uris)
 {
     clearSelection();
     for (auto uri: uris) {
-        const QModelIndex index = m_proxy_model->indexFromUri(uri);
+        const QModelIndex index = indexFromUri(uri);
         if (index.isValid()) {
             auto flags = QItemSelectionModel::Select|QItemSelectionModel::Rows;
             selectionModel()->select(index, flags);
@@ -294,9 +361,18 @@ void ListView::setSelections(const QStringList &uris)
 
 const QStringList ListView::getAllFileUris()
 {
+    if (m_flat_model)
+        return m_flat_model->getAllFileUris();
     return m_proxy_model->getAllFileUris();
 }
 
+const QModelIndex ListView::indexFromUri(const QString &uri)
+{
+    if (m_flat_model)
+        return m_flat_model->indexFromUri(uri);
+    return m_proxy_model->indexFromUri(uri);
+}
+
 void ListView::open(const QStringList &uris, bool newWindow)
 {
     return;
@@ -304,12 +380,22 @@ void ListView::open(const QStringList &uris, bool newWindow)
 
 void ListView::beginLocationChange()
 {
+    //flat model inserts its children batch by batch, do not
+    //unset the model of view.
+    if (m_flat_model) {
+        m_flat_model->setRootUri(m_current_uri);
+        return;
+    }
     setModel(nullptr);
     m_model->setRootUri(m_current_uri);
 }
 
 void ListView::stopLocationChange()
 {
+    if (m_flat_model) {
+        m_flat_model->cancelFindChildren();
+        return;
+    }
     m_model->cancelFindChildren();
 }
 
@@ -328,7 +414,7 @@ void ListView::invertSelections()
 
 void ListView::scrollToSelection(const QString &uri)
 {
-    auto index = m_proxy_model->indexFromUri(uri);
+    auto index = indexFromUri(uri);
     scrollTo(index);
 }
 
@@ -339,29 +425,39 @@ void ListView::setCutFiles(const QStringList &uris)
 
 int ListView::getSortType()
 {
-    int type = m_proxy_model->sortColumn();
+    int type = m_flat_model? m_flat_model->sortColumn(): m_proxy_model->sortColumn();
     return type<0? 0: type;
 }
 
 void ListView::setSortType(int sortType)
 {
+    if (m_flat_model) {
+        m_flat_model->sort(sortType, Qt::SortOrder(getSortOrder()));
+        return;
+    }
     m_proxy_model->sort(sortType, Qt::SortOrder(getSortOrder()));
 }
 
 int ListView::getSortOrder()
 {
+    if (m_flat_model)
+        return m_flat_model->sortOrder();
     return m_proxy_model->sortOrder();
 }
 
 void ListView::setSortOrder(int sortOrder)
 {
+    if (m_flat_model) {
+        m_flat_model->sort(getSortType(), Qt::SortOrder(sortOrder));
+        return;
+    }
     m_proxy_model->sort(getSortType(), Qt::SortOrder(sortOrder));
 }
 
 void ListView::editUri(const QString &uri)
 {
-    setIndexWidget(m_proxy_model->indexFromUri(uri), nullptr);
-    edit(m_proxy_model->indexFromUri(uri));
+    setIndexWidget(indexFromUri(uri), nullptr);
+    edit(indexFromUri(uri));
 }
 
 void ListView::editUris(const QStringList uris)
@@ -380,29 +476,9 @@ ListView2::ListView2(QWidget *parent) : DirectoryViewWidget(parent)
     layout->addWidget(m_view);
 
     setLayout(layout);
-}
-
-ListView2::~ListView2()
-{
-    m_model->setPositiveResponse(true);
-}
-
-void ListView2::bindModel(FileItemModel *model, FileItemProxyFilterSortModel *proxyModel)
-{
-    disconnect(m_model);
-    disconnect(m_proxy_model);
-    m_model = model;
-    m_proxy_model = proxyModel;
-
-    m_model->setPositiveResponse(false);
-
-    m_view->bindModel(model, proxyModel);
-    connect(model, &FileItemModel::findChildrenFinished, this, &DirectoryViewWidget::viewDirectoryChanged);
-    connect(m_model, &FileItemModel::updated, m_view, &ListView::resort);
-
-    connect(m_view->selectionModel(), &QItemSelectionModel::selectionChanged,
-            this, &DirectoryViewWidget::viewSelectionChanged);
 
+    //the view might be rebound between models, connect the view's
+    //own signals only once.
     connect(m_view, &ListView::doubleClicked, this, [=](const QModelIndex &index){
         qDebug()<<index.data(Qt::UserRole).toString();
         Q_EMIT this->viewDoubleClicked(index.data(Qt::UserRole).toString());
@@ -441,6 +517,29 @@ void ListView2::bindModel(FileItemModel *model, FileItemProxyFilterSortModel *pr
             Q_EMIT this->menuRequest(QCursor::pos());
         });
     });
+}
+
+ListView2::~ListView2()
+{
+    if (m_model)
+        m_model->removeTreeView();
+}
+
+void ListView2::bindModel(FileItemModel *model, FileItemProxyFilterSortModel *proxyModel)
+{
+    unbindModels();
+    m_model = model;
+    m_proxy_model = proxyModel;
+
+    //sub folders are loaded lazily when they are expanded.
+    m_model->addTreeView();
+
+    m_view->bindModel(model, proxyModel);
+    connect(model, &FileItemModel::findChildrenFinished, this, &DirectoryViewWidget::viewDirectoryChanged);
+    connect(m_model, &FileItemModel::updated, m_view, &ListView::resort);
+
+    connect(m_view->selectionModel(), &QItemSelectionModel::selectionChanged,
+            this, &DirectoryViewWidget::viewSelectionChanged);
 
     connect(m_proxy_model, &FileItemProxyFilterSortModel::layoutChanged, this, [=](){
         Q_EMIT this->sortOrderChanged(Qt::SortOrder(getSortOrder()));
@@ -452,9 +551,46 @@ void ListView2::bindModel(FileItemModel *model, FileItemProxyFilterSortModel *pr
     connect(m_model, &FileItemModel::findChildrenFinished, this, [=](){
         //delay a while for proxy model sorting.
         QTimer::singleShot(100, this, [=](){
+            //the view might have been bound to a flat model.
+            if (!m_proxy_model)
+                return;
             m_view->setModel(m_proxy_model);
             //adjust columns layout.
             m_view->adjustColumnsSize();
         });
     });
 }
+
+void ListView2::bindFlatModel(FlatDirectoryModel *model)
+{
+    unbindModels();
+    m_flat_model = model;
+
+    m_view->bindFlatModel(model);
+    connect(m_flat_model, &FlatDirectoryModel::findChildrenFinished, this, &DirectoryViewWidget::viewDirectoryChanged);
+
+    connect(m_view->selectionModel(), &QItemSelectionModel::selectionChanged,
+            this, &DirectoryViewWidget::viewSelectionChanged);
+
+    connect(m_flat_model, &FlatDirectoryModel::layoutChanged, this, [=](){
+        Q_EMIT this->sortOrderChanged(Qt::SortOrder(getSortOrder()));
+        Q_EMIT this->sortTypeChanged(getSortType());
+    });
+}
+
+void ListView2::unbindModels()
+{
+    //do not disconnect the models from m_view, the view connects
+    //the model's signals itself in setModel().
+    for (QObject *model : QList<QObject*>()<<m_model<<m_proxy_model<<m_flat_model) {
+        if (model)
+            model->disconnect(this);
+    }
+    if (m_model) {
+        disconnect(m_model, &FileItemModel::updated, m_view, &ListView::resort);
+        m_model->removeTreeView();
+    }
+    m_model = nullptr;
+    m_proxy_model = nullptr;
+    m_flat_model = nullptr;
+}
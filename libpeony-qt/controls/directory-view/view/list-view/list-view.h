@@ -30,11 +30,14 @@
 #include "directory-view-widget.h"
 
 #include <QTimer>
+#include <QPointer>
 
 namespace Peony {
 
+class FileItem;
 class FileItemModel;
 class FileItemProxyFilterSortModel;
+class FlatDirectoryModel;
 
 namespace DirectoryView {
 
@@ -49,10 +52,12 @@ class PEONYCORESHARED_EXPORT ListView : public QTreeView, public DirectoryViewIf
     Q_OBJECT
 public:
     explicit ListView(QWidget *parent = nullptr);
+    ~ListView() override;
 
     const QString viewId() override {return tr("List View");}
 
     void bindModel(FileItemModel *sourceModel, FileItemProxyFilterSortModel *proxyModel) override;
+    void bindFlatModel(FlatDirectoryModel *model) override;
     void setProxy(DirectoryViewProxyIface *proxy) override;
 
     DirectoryViewProxyIface *getProxy() override;
@@ -108,9 +113,18 @@ protected:
 
 private Q_SLOTS:
     void slotRename();
+private:
+    void setupSelectionModel();
+    const QModelIndex indexFromUri(const QString &uri);
+    void releaseExpandedItems();
+
 private:
     FileItemModel *m_model = nullptr;
     FileItemProxyFilterSortModel *m_proxy_model = nullptr;
+    //if it is not null, m_model and m_proxy_model are not used.
+    FlatDirectoryModel *m_flat_model = nullptr;
+    //the items expanded in this view, see FileItem::addExpandedView().
+    QList<QPointer<FileItem>> m_expanded_items;
 
     QTimer* m_renameTimer;
     bool  m_editValid;
@@ -145,8 +159,11 @@ public:
     int getSortType() {return m_view->getSortType();}
     Qt::SortOrder getSortOrder() {return Qt::SortOrder(m_view->getSortOrder());}
 
+    bool supportFlatModel() {return true;}
+
 public Q_SLOTS:
     void bindModel(FileItemModel *model, FileItemProxyFilterSortModel *proxyModel);
+    void bindFlatModel(FlatDirectoryModel *model);
 
     //location
     //void open(const QStringList &uris, bool newWindow);
@@ -171,10 +188,14 @@ public Q_SLOTS:
     void editUri(const QString &uri) {m_view->editUri(uri);}
     void editUris(const QStringList uris) {m_view->editUris(uris);}
 
+private:
+    void unbindModels();
+
 private:
     ListView *m_view = nullptr;
     FileItemModel *m_model = nullptr;
     FileItemProxyFilterSortModel *m_proxy_model = nullptr;
+    FlatDirectoryModel *m_flat_model = nullptr;
 };
 
 }
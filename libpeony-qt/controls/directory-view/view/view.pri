@@ -4,7 +4,9 @@ include(icon-view/icon-view.pri)
 include(list-view/list-view.pri)
 
 HEADERS += \
-    $$PWD/standard-view-proxy.h
+    $$PWD/standard-view-proxy.h \
+    $$PWD/grid-layout-engine.h
 
 SOURCES += \
-    $$PWD/standard-view-proxy.cpp
+    $$PWD/standard-view-proxy.cpp \
+    $$PWD/grid-layout-engine.cpp
@@ -534,8 +534,7 @@ const QList<QAction *> DirectoryViewMenu::constructTrashActions()
                                                                                           "Once you start a deletion, the files deleting will never be "
                                                                                           "restored again."));
                 if (result == QMessageBox::Yes) {
-                    auto uris = m_top_window->getCurrentAllFileUris();
-                    FileOperationUtils::remove(uris);
+                    FileOperationUtils::emptyTrash();
                 }
             });
         } else {
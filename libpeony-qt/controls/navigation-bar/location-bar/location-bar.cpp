@@ -24,6 +24,7 @@
 
 #include "path-bar-model.h"
 #include "file-utils.h"
+#include "theme-icon-cache.h"
 
 #include "search-vfs-uri-parser.h"
 
@@ -98,7 +99,7 @@ void LocationBar::addButton(const QString &uri, bool setIcon, bool setMenu)
     QUrl url = uri;
     auto parent = FileUtils::getParentUri(uri);
     if (setIcon) {
-        QIcon icon = QIcon::fromTheme(Peony::FileUtils::getFileIconName(uri), QIcon::fromTheme("folder"));
+        QIcon icon = ThemeIconCache::getInstance()->icon(Peony::FileUtils::getFileIconName(uri), "folder");
         action->setIcon(icon);
     }
 
@@ -25,11 +25,14 @@
 #include "file-info.h"
 #include "file-info-job.h"
 #include "file-utils.h"
+#include "file-trash-engine.h"
 #include <QFormLayout>
 #include <QPushButton>
 #include <QLineEdit>
 #include <QLabel>
 #include <QUrl>
+#include <QFutureWatcher>
+#include <QtConcurrent>
 
 using namespace Peony;
 
@@ -61,7 +64,24 @@ RecentAndTrashPropertiesPage::RecentAndTrashPropertiesPage(const QStringList &ur
 
     if (startWithTrash) {
         if (m_uri == "trash:///") {
-
+            //the folder sizes are cached by the trash directories, only the
+            //folders missing in the caches are walked, out of the ui thread.
+            auto sizeLabel = new QLabel(this);
+            m_layout->addRow(tr("Size: "), sizeLabel);
+            auto watcher = new QFutureWatcher<qint64>(this);
+            connect(watcher, &QFutureWatcher<qint64>::finished, sizeLabel, [=](){
+                char *formatSize = g_format_size(quint64(watcher->result()));
+                sizeLabel->setText(formatSize);
+                g_free(formatSize);
+                watcher->deleteLater();
+            });
+            watcher->setFuture(QtConcurrent::run([](){
+                qint64 total = 0;
+                for (auto path : FileTrashEngine::trashDirectories()) {
+                    total += FileTrashEngine::trashSize(path);
+                }
+                return total;
+            }));
         } else {
             GFile *file = g_file_new_for_uri(m_uri.toUtf8().constData());
             GFileInfo *info = g_file_query_info(file,
@@ -25,6 +25,7 @@
 #include <QClipboard>
 #include <QMimeData>
 #include <QUrl>
+#include <QSet>
 
 #include "file-operation-manager.h"
 #include "file-move-operation.h"
@@ -45,6 +46,16 @@ static ClipboardUtils *global_instance = nullptr;
  */
 static QString m_clipboard_parent_uri = nullptr;
 
+/*!
+ * \brief m_cut_uris
+ * \note
+ * Views query whether an item is cut for every item they paint. Reading the
+ * clipboard mime data and comparing the uris each time would cost
+ * O(clipboard size) per item, so the cut uris are cached here and only rebuilt
+ * when the clipboard data changed.
+ */
+static QSet<QString> m_cut_uris;
+
 ClipboardUtils *ClipboardUtils::getInstance()
 {
     if (!global_instance) {
@@ -55,13 +66,17 @@ ClipboardUtils *ClipboardUtils::getInstance()
 
 ClipboardUtils::ClipboardUtils(QObject *parent) : QObject(parent)
 {
-    connect(QApplication::clipboard(), &QClipboard::dataChanged, this, &ClipboardUtils::clipboardChanged);
-    connect(QApplication::clipboard(), &QClipboard::dataChanged, [=](){
+    //emit clipboardChanged() after the cut uris are rebuilt, so views repainting
+    //on it see the new cut state.
+    connect(QApplication::clipboard(), &QClipboard::dataChanged, this, [=](){
         auto data = QApplication::clipboard()->mimeData();
         if (!data->hasFormat("peony-qt/is-cut")) {
             m_clipboard_parent_uri = nullptr;
         }
+        updateCutFiles();
+        Q_EMIT clipboardChanged();
     });
+    updateCutFiles();
 }
 
 ClipboardUtils::~ClipboardUtils()
@@ -129,6 +144,27 @@ QStringList ClipboardUtils::getClipboardFilesUris()
     return l;
 }
 
+bool ClipboardUtils::isCutFile(const QString &uri)
+{
+    if (!global_instance) {
+        global_instance = new ClipboardUtils;
+    }
+    return m_cut_uris.contains(uri);
+}
+
+void ClipboardUtils::updateCutFiles()
+{
+    m_cut_uris.clear();
+    if (!isClipboardFilesBeCut())
+        return;
+
+    auto urls = QApplication::clipboard()->mimeData()->urls();
+    m_cut_uris.reserve(urls.count());
+    for (auto url : urls) {
+        m_cut_uris.insert(url.toString());
+    }
+}
+
 void ClipboardUtils::pasteClipboardFiles(const QString &targetDirUri)
 {
     if (!isClipboardHasFiles()) {
@@ -42,7 +42,7 @@ class ClipboardUtils : public QObject
 {
     Q_OBJECT
 public:
-    ClipboardUtils *getInstance();
+    static ClipboardUtils *getInstance();
     void release();
 
     /*!
@@ -65,6 +65,16 @@ public:
      */
     static bool isClipboardFilesBeCut();
     static QStringList getClipboardFilesUris();
+    /*!
+     * \brief isCutFile
+     * \param uri
+     * \return true if the file is in clipboard and was cut.
+     * \details
+     * The cut uris are cached in a set which is only rebuilt when
+     * clipboard data changed, so this method is cheap enough to be
+     * called for every painted item in views.
+     */
+    static bool isCutFile(const QString &uri);
     static void pasteClipboardFiles(const QString &targetDirUri);
     static void clearClipboard();
     static const QString getClipedFilesParentUri();
@@ -75,6 +85,8 @@ Q_SIGNALS:
 private:
     explicit ClipboardUtils(QObject *parent = nullptr);
     ~ClipboardUtils();
+
+    static void updateCutFiles();
 };
 
 }
@@ -28,6 +28,7 @@
 #include "file-trash-operation.h"
 #include "file-rename-operation.h"
 #include "file-delete-operation.h"
+#include "file-empty-trash-operation.h"
 #include "file-link-operation.h"
 
 #include "file-untrash-operation.h"
@@ -126,6 +127,13 @@ void FileOperationUtils::remove(const QStringList &uris)
     fileOpMgr->startOperation(removeOp);
 }
 
+void FileOperationUtils::emptyTrash()
+{
+    auto fileOpMgr = FileOperationManager::getInstance();
+    auto emptyTrashOp = new FileEmptyTrashOperation;
+    fileOpMgr->startOperation(emptyTrashOp);
+}
+
 void FileOperationUtils::link(const QString &srcUri, const QString &destUri, bool addHistory)
 {
     auto fileOpMgr = FileOperationManager::getInstance();
@@ -42,6 +42,12 @@ public:
     static void copy(const QStringList &srcUris, const QString &destUri, bool addHistory);
     static void trash(const QStringList &uris, bool addHistory);
     static void remove(const QStringList &uris);
+    /*!
+     * \brief emptyTrash
+     * \details
+     * Delete all the files in trash with FileEmptyTrashOperation.
+     */
+    static void emptyTrash();
     static void rename(const QString &uri, const QString &newName, bool addHistory);
     static void link(const QString &srcUri, const QString &destUri, bool addHistory);
     static void restore(const QString &uriInTrash);
@@ -0,0 +1,116 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "thumbnail-shadow.h"
+
+#include <QPainter>
+#include <QImage>
+#include <QStyle>
+#include <QStyleOptionViewItem>
+#include <QApplication>
+
+//qt's global function
+extern void qt_blurImage(QImage &blurImage, qreal radius, bool quality, int transposed);
+
+QHash<QString, QPixmap> ThumbnailShadow::m_frame_cache;
+
+void ThumbnailShadow::paint(QPainter *painter, const QRect &thumbnailRect, int radius)
+{
+    if (!painter || thumbnailRect.isEmpty() || radius <= 0)
+        return;
+
+    qreal dpr = painter->device()? painter->device()->devicePixelRatioF(): 1.0;
+    auto shadow = frame(radius, dpr);
+
+    //the frame is split into 3x3 patches, the corners are 2*radius wide,
+    //one radius outside the thumbnail and one inside it.
+    int corner = 2 * radius;
+    int middle = 2 * radius + 1;
+    QRect target = thumbnailRect.adjusted(-radius, -radius, radius, radius);
+    if (target.width() < 2 * corner || target.height() < 2 * corner) {
+        painter->drawPixmap(target, shadow);
+        return;
+    }
+
+    int targetMiddleWidth = target.width() - 2 * corner;
+    int targetMiddleHeight = target.height() - 2 * corner;
+
+    int xs[3] = {0, corner, corner + middle};
+    int ws[3] = {corner, middle, corner};
+    int targetXs[3] = {target.x(), target.x() + corner, target.right() + 1 - corner};
+    int targetWs[3] = {corner, targetMiddleWidth, corner};
+    int targetYs[3] = {target.y(), target.y() + corner, target.bottom() + 1 - corner};
+    int targetHs[3] = {corner, targetMiddleHeight, corner};
+
+    painter->save();
+    painter->setRenderHint(QPainter::SmoothPixmapTransform, false);
+    for (int row = 0; row < 3; row++) {
+        for (int column = 0; column < 3; column++) {
+            //the center patch is always covered by the opaque thumbnail.
+            if (row == 1 && column == 1)
+                continue;
+            QRectF source(xs[column] * dpr, xs[row] * dpr, ws[column] * dpr, ws[row] * dpr);
+            QRectF dest(targetXs[column], targetYs[row], targetWs[column], targetHs[row]);
+            painter->drawPixmap(dest, shadow, source);
+        }
+    }
+    painter->restore();
+}
+
+void ThumbnailShadow::paint(QPainter *painter, const QStyleOptionViewItem &option, int radius)
+{
+    auto style = option.widget? option.widget->style(): QApplication::style();
+    auto decorationRect = style->subElementRect(QStyle::SE_ItemViewItemDecoration, &option, option.widget);
+    auto pixmapSize = option.icon.actualSize(option.decorationSize);
+    paint(painter, QStyle::alignedRect(option.direction, Qt::AlignCenter, pixmapSize, decorationRect), radius);
+}
+
+const QPixmap ThumbnailShadow::frame(int radius, qreal devicePixelRatio)
+{
+    QString key = QString("%1@%2").arg(radius).arg(devicePixelRatio);
+    if (m_frame_cache.contains(key))
+        return m_frame_cache.value(key);
+
+    //the rect inside must be large enough that its blurred center is not
+    //affected by the opposite edges. keep the middle patch size in sync
+    //with paint().
+    int corner = 2 * radius;
+    int size = 2 * corner + 2 * radius + 1;
+
+    QImage image(QSize(size, size) * devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    image.setDevicePixelRatio(devicePixelRatio);
+
+    QPainter p(&image);
+    p.setPen(Qt::transparent);
+    p.setBrush(Qt::gray);
+    p.drawRect(QRect(radius, radius, size - 2 * radius, size - 2 * radius));
+    p.end();
+
+    qt_blurImage(image, radius * devicePixelRatio, false, false);
+
+    auto pixmap = QPixmap::fromImage(image);
+    pixmap.setDevicePixelRatio(devicePixelRatio);
+    m_frame_cache.insert(key, pixmap);
+    return pixmap;
+}
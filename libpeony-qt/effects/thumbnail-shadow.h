@@ -0,0 +1,70 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef THUMBNAILSHADOW_H
+#define THUMBNAILSHADOW_H
+
+#include <QPixmap>
+#include <QHash>
+
+class QPainter;
+class QStyleOptionViewItem;
+
+/*!
+ * \brief The ThumbnailShadow class
+ * \details
+ * This class paints the drop shadow behind opaque thumbnails.
+ *
+ * The shadow used to be blurred into every thumbnail when it was
+ * generated. Because the blurred frame only depends on the blur radius
+ * and the device pixel ratio, it is now rendered once as a nine-patch
+ * and stretched around the thumbnail rect by the delegates at paint time.
+ * The thumbnails themselves stay raw scaled images.
+ *
+ * \note
+ * The cache is not thread safe, only paint from the gui thread.
+ */
+class ThumbnailShadow
+{
+public:
+    /*!
+     * \brief paint
+     * \param painter
+     * \param thumbnailRect the rect where the thumbnail will be painted.
+     * \param radius the blur radius, the shadow overflows the rect by this size.
+     */
+    static void paint(QPainter *painter, const QRect &thumbnailRect, int radius = 4);
+    /*!
+     * \brief paint
+     * \param painter
+     * \param option the item option which will be passed to QStyle::CE_ItemViewItem,
+     * the shadow is painted behind the decoration of this option.
+     */
+    static void paint(QPainter *painter, const QStyleOptionViewItem &option, int radius = 4);
+
+private:
+    static const QPixmap frame(int radius, qreal devicePixelRatio);
+
+    static QHash<QString, QPixmap> m_frame_cache;
+};
+
+#endif // THUMBNAILSHADOW_H
@@ -0,0 +1,497 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2019, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "file-copy-engine.h"
+
+#include <QByteArray>
+#include <QList>
+#include <QPair>
+
+#include <functional>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/xattr.h>
+#include <linux/fs.h>
+
+//the progress is not reported for every chunk.
+#define PROGRESS_CHUNK_SIZE (8*1024*1024)
+//one copy_file_range() call, small enough to check the cancellation.
+#define RANGE_CHUNK_SIZE (16*1024*1024)
+#define COPY_BUFFER_SIZE (1024*1024)
+//the mkstemp() template of the temporary file, appended to the hidden name.
+#define TEMPORARY_SUFFIX ".peony-XXXXXX"
+
+using namespace Peony;
+
+static gboolean set_error_from_errno(GError **error, int errsv)
+{
+    g_set_error_literal(error, G_IO_ERROR, g_io_error_from_errno(errsv), g_strerror(errsv));
+    return FALSE;
+}
+
+static bool write_all(int fd, const char *data, ssize_t size)
+{
+    while (size > 0) {
+        ssize_t written = write(fd, data, size_t(size));
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+static bool pwrite_all(int fd, const char *data, ssize_t size, off_t offset)
+{
+    while (size > 0) {
+        ssize_t written = pwrite(fd, data, size_t(size), offset);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        data += written;
+        size -= written;
+        offset += written;
+    }
+    return true;
+}
+
+static bool range_not_supported(int errsv)
+{
+    return errsv == EXDEV || errsv == EINVAL || errsv == ENOSYS ||
+            errsv == EOPNOTSUPP || errsv == EBADF || errsv == EPERM;
+}
+
+/*!
+ * \brief find_data_extents
+ * \param fd
+ * \param size
+ * \param extents, the offsets and lengths of the data in file.
+ * \return false if the file system can not tell the holes.
+ */
+static bool find_data_extents(int fd, off_t size, QList<QPair<off_t, off_t>> *extents)
+{
+    off_t offset = 0;
+    while (offset < size) {
+        off_t data = lseek(fd, offset, SEEK_DATA);
+        if (data < 0) {
+            //there is no data after offset.
+            if (errno == ENXIO)
+                break;
+            return false;
+        }
+        off_t hole = lseek(fd, data, SEEK_HOLE);
+        if (hole < 0)
+            return false;
+        if (hole > size)
+            hole = size;
+        if (hole > data)
+            extents->append(qMakePair(data, hole - data));
+        offset = hole;
+    }
+    return true;
+}
+
+/*!
+ * \brief copy_extent
+ * \details
+ * Copy the bytes at the same offset of the destination, with copy_file_range()
+ * while it is supported, or pread() and pwrite().
+ * \return 0, or the errno.
+ */
+static int copy_extent(int sourceFd, int destFd, off_t offset, off_t length,
+                       GCancellable *cancellable, bool *useRange, QByteArray &buffer,
+                       const std::function<void (ssize_t)> &progressed)
+{
+    off_t end = offset + length;
+    while (offset < end) {
+        if (g_cancellable_is_cancelled(cancellable))
+            return ECANCELED;
+
+        size_t chunk = size_t(qMin(end - offset, off_t(RANGE_CHUNK_SIZE)));
+        ssize_t size = -1;
+#ifdef SYS_copy_file_range
+        if (*useRange) {
+            loff_t sourceOffset = offset;
+            loff_t destOffset = offset;
+            size = syscall(SYS_copy_file_range, sourceFd, &sourceOffset, destFd, &destOffset, chunk, 0);
+            if (size < 0 && range_not_supported(errno)) {
+                *useRange = false;
+                continue;
+            }
+        }
+#endif
+        if (!*useRange) {
+            if (buffer.isEmpty())
+                buffer.resize(COPY_BUFFER_SIZE);
+            size = pread(sourceFd, buffer.data(), qMin(chunk, size_t(buffer.size())), offset);
+            if (size > 0 && !pwrite_all(destFd, buffer.constData(), size, offset))
+                size = -1;
+        }
+
+        if (size < 0) {
+            if (errno == EINTR)
+                continue;
+            return errno;
+        }
+        //the source is truncated while copying.
+        if (size == 0)
+            break;
+
+        offset += size;
+        progressed(size);
+    }
+    return 0;
+}
+
+/*!
+ * \brief temporary_path
+ * \return a mkstemp() template next to path, so it can be renamed over path.
+ * The name is truncated to keep the template within NAME_MAX.
+ */
+static QByteArray temporary_path(const char *path)
+{
+    QByteArray tmp = path;
+    int index = tmp.lastIndexOf('/');
+    QByteArray name = tmp.mid(index + 1);
+    int maxLength = NAME_MAX - 1 - int(sizeof(TEMPORARY_SUFFIX) - 1);
+    if (name.length() > maxLength) {
+        //do not split a utf-8 character.
+        int length = maxLength;
+        while (length > 0 && (uchar(name.at(length)) & 0xc0) == 0x80)
+            length--;
+        name.truncate(length);
+    }
+    return tmp.left(index + 1) + "." + name + TEMPORARY_SUFFIX;
+}
+
+static void copy_xattrs(int sourceFd, int destFd)
+{
+    //best effort, like gio does with G_FILE_COPY_ALL_METADATA.
+    ssize_t size = flistxattr(sourceFd, nullptr, 0);
+    if (size <= 0)
+        return;
+
+    QByteArray names(int(size), Qt::Uninitialized);
+    size = flistxattr(sourceFd, names.data(), size_t(size));
+    if (size <= 0)
+        return;
+
+    QByteArray value;
+    for (auto name : names.left(int(size)).split('\0')) {
+        if (!name.startsWith("user."))
+            continue;
+        ssize_t valueSize = fgetxattr(sourceFd, name.constData(), nullptr, 0);
+        if (valueSize < 0)
+            continue;
+        value.resize(int(valueSize));
+        valueSize = fgetxattr(sourceFd, name.constData(), value.data(), size_t(valueSize));
+        if (valueSize >= 0)
+            fsetxattr(destFd, name.constData(), value.constData(), size_t(valueSize), 0);
+    }
+}
+
+goffset FileCopyEngine::transferSize(goffset size, goffset allocatedSize)
+{
+    //some file systems do not report the allocated size.
+    if (allocatedSize <= 0 || allocatedSize >= size)
+        return size;
+    return allocatedSize;
+}
+
+struct ScaledProgress
+{
+    GFileProgressCallback callback = nullptr;
+    gpointer data = nullptr;
+    goffset size = 0;
+    goffset transferSize = 0;
+};
+
+static void scaled_progress_callback(goffset current_num_bytes, goffset total_num_bytes, gpointer user_data)
+{
+    auto scaled = static_cast<ScaledProgress *>(user_data);
+    Q_UNUSED(total_num_bytes)
+    goffset current = scaled->size > 0? goffset(double(current_num_bytes)/scaled->size*scaled->transferSize): 0;
+    scaled->callback(qMin(current, scaled->transferSize), scaled->transferSize, scaled->data);
+}
+
+/*!
+ * \brief query_scaled_progress
+ * \return true if the transfer size of source is less than its size.
+ */
+static bool query_scaled_progress(GFile *source, GFileCopyFlags flags, ScaledProgress *scaled)
+{
+    auto queryFlags = (flags & G_FILE_COPY_NOFOLLOW_SYMLINKS)? G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS: G_FILE_QUERY_INFO_NONE;
+    GFileInfo *info = g_file_query_info(source,
+                                        G_FILE_ATTRIBUTE_STANDARD_SIZE "," G_FILE_ATTRIBUTE_STANDARD_ALLOCATED_SIZE,
+                                        queryFlags,
+                                        nullptr,
+                                        nullptr);
+    if (!info)
+        return false;
+    scaled->size = g_file_info_get_size(info);
+    scaled->transferSize = FileCopyEngine::transferSize(scaled->size,
+                                                        goffset(g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_STANDARD_ALLOCATED_SIZE)));
+    g_object_unref(info);
+    return scaled->transferSize < scaled->size;
+}
+
+gboolean FileCopyEngine::copy(GFile *source,
+                              GFile *destination,
+                              GFileCopyFlags flags,
+                              GCancellable *cancellable,
+                              GFileProgressCallback progress_callback,
+                              gpointer progress_callback_data,
+                              GError **error)
+{
+    if (!canCopyNatively(source, destination, flags)) {
+        //gio reports the progress against the size, rescale it to the transfer size.
+        ScaledProgress scaled;
+        if (progress_callback && query_scaled_progress(source, flags, &scaled)) {
+            scaled.callback = progress_callback;
+            scaled.data = progress_callback_data;
+            return g_file_copy(source, destination, flags, cancellable,
+                               scaled_progress_callback, &scaled, error);
+        }
+        return g_file_copy(source, destination, flags, cancellable,
+                           progress_callback, progress_callback_data, error);
+    }
+
+    char *sourcePath = g_file_get_path(source);
+    char *destinationPath = g_file_get_path(destination);
+    auto result = copyNatively(sourcePath, destinationPath, flags, cancellable,
+                               progress_callback, progress_callback_data, error);
+    g_free(sourcePath);
+    g_free(destinationPath);
+    return result;
+}
+
+bool FileCopyEngine::canCopyNatively(GFile *source, GFile *destination, GFileCopyFlags flags)
+{
+    if (flags & G_FILE_COPY_BACKUP)
+        return false;
+
+    if (!g_file_is_native(source) || !g_file_is_native(destination))
+        return false;
+
+    char *sourcePath = g_file_get_path(source);
+    if (!sourcePath)
+        return false;
+
+    struct stat st;
+    int ret = (flags & G_FILE_COPY_NOFOLLOW_SYMLINKS)? lstat(sourcePath, &st): stat(sourcePath, &st);
+    g_free(sourcePath);
+
+    //let gio report the errors and handle the special files.
+    return ret == 0 && S_ISREG(st.st_mode);
+}
+
+gboolean FileCopyEngine::copyNatively(const char *sourcePath,
+                                      const char *destinationPath,
+                                      GFileCopyFlags flags,
+                                      GCancellable *cancellable,
+                                      GFileProgressCallback progress_callback,
+                                      gpointer progress_callback_data,
+                                      GError **error)
+{
+    if (g_cancellable_set_error_if_cancelled(cancellable, error))
+        return FALSE;
+
+    int openFlags = O_RDONLY|O_CLOEXEC;
+    if (flags & G_FILE_COPY_NOFOLLOW_SYMLINKS)
+        openFlags |= O_NOFOLLOW;
+    int sourceFd = open(sourcePath, openFlags);
+    if (sourceFd < 0)
+        return set_error_from_errno(error, errno);
+
+    struct stat st;
+    if (fstat(sourceFd, &st) < 0) {
+        int errsv = errno;
+        close(sourceFd);
+        return set_error_from_errno(error, errsv);
+    }
+
+    //an existing destination is replaced by a temporary file in its directory
+    //once the copy succeeded, it is never truncated or written through a link.
+    bool overwrite = flags & G_FILE_COPY_OVERWRITE;
+    QByteArray writtenPath = destinationPath;
+    int destFd = -1;
+    struct stat destSt;
+    if (overwrite && lstat(destinationPath, &destSt) == 0) {
+        int errsv = 0;
+        if (S_ISDIR(destSt.st_mode)) {
+            g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_IS_DIRECTORY, "Can not copy over a directory");
+        } else if (destSt.st_dev == st.st_dev && destSt.st_ino == st.st_ino) {
+            g_set_error_literal(error, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT, "Can not copy a file over itself");
+        } else {
+            writtenPath = temporary_path(destinationPath);
+            destFd = mkostemp(writtenPath.data(), O_CLOEXEC);
+            if (destFd < 0)
+                errsv = errno;
+        }
+        if (destFd < 0) {
+            close(sourceFd);
+            return errsv? set_error_from_errno(error, errsv): FALSE;
+        }
+    } else {
+        //O_EXCL does not follow a symbolic link either.
+        destFd = open(destinationPath, O_WRONLY|O_CREAT|O_EXCL|O_CLOEXEC, 0600);
+        if (destFd < 0) {
+            int errsv = errno;
+            close(sourceFd);
+            return set_error_from_errno(error, errsv);
+        }
+    }
+
+    int errsv = 0;
+    //the same size as FileNode::transferSize(), the holes are not counted.
+    goffset total = transferSize(st.st_size, goffset(st.st_blocks)*512);
+    goffset copied = 0;
+    goffset reported = 0;
+
+    bool cloned = false;
+#ifdef FICLONE
+    //a reflink shares the extents of the source file, it is instant.
+    if (!errsv && st.st_size > 0 && ioctl(destFd, FICLONE, sourceFd) == 0) {
+        cloned = true;
+    }
+#endif
+
+    //a file with less allocated blocks than its size might have holes.
+    QList<QPair<off_t, off_t>> extents;
+    bool sparse = !errsv && !cloned && qint64(st.st_blocks)*512 < qint64(st.st_size)
+            && find_data_extents(sourceFd, st.st_size, &extents);
+    if (progress_callback)
+        progress_callback(0, total, progress_callback_data);
+
+    //the data extents and the compressed files might be larger than the allocated size.
+    auto progressed = [&](ssize_t size) {
+        copied = qMin(goffset(copied + size), total);
+        if (progress_callback && copied - reported >= PROGRESS_CHUNK_SIZE) {
+            reported = copied;
+            progress_callback(copied, total, progress_callback_data);
+        }
+    };
+
+#ifdef SYS_copy_file_range
+    bool useRange = true;
+#else
+    bool useRange = false;
+#endif
+    QByteArray buffer;
+
+    if (cloned) {
+        copied = total;
+    } else if (sparse) {
+        //the holes are recreated by extending the file, only the data extents are written.
+        if (ftruncate(destFd, st.st_size) < 0)
+            errsv = errno;
+        for (auto extent : extents) {
+            if (errsv)
+                break;
+            errsv = copy_extent(sourceFd, destFd, extent.first, extent.second,
+                                cancellable, &useRange, buffer, progressed);
+        }
+    } else if (!errsv) {
+        posix_fadvise(sourceFd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+        while (true) {
+            if (g_cancellable_is_cancelled(cancellable)) {
+                errsv = ECANCELED;
+                break;
+            }
+
+            ssize_t size = -1;
+#ifdef SYS_copy_file_range
+            if (useRange) {
+                size = syscall(SYS_copy_file_range, sourceFd, nullptr, destFd, nullptr, size_t(RANGE_CHUNK_SIZE), 0);
+                if (size < 0 && range_not_supported(errno)) {
+                    //not supported between these file systems, the file offsets
+                    //are not changed, continue with read() and write().
+                    useRange = false;
+                    continue;
+                }
+            }
+#endif
+            if (!useRange) {
+                if (buffer.isEmpty())
+                    buffer.resize(COPY_BUFFER_SIZE);
+                size = read(sourceFd, buffer.data(), size_t(buffer.size()));
+                if (size > 0 && !write_all(destFd, buffer.constData(), size))
+                    size = -1;
+            }
+
+            if (size < 0) {
+                if (errno == EINTR)
+                    continue;
+                errsv = errno;
+                break;
+            }
+            if (size == 0)
+                break;
+
+            progressed(size);
+        }
+    }
+
+    if (!errsv) {
+        //gio copies the permissions anyway, and the others with all metadata.
+        fchmod(destFd, st.st_mode & 07777);
+        if (flags & G_FILE_COPY_ALL_METADATA) {
+            copy_xattrs(sourceFd, destFd);
+            struct timespec times[2] = {st.st_atim, st.st_mtim};
+            futimens(destFd, times);
+        }
+    }
+
+    close(sourceFd);
+    if (close(destFd) < 0 && !errsv)
+        errsv = errno;
+
+    //replace the destination only with a complete copy.
+    if (!errsv && writtenPath != destinationPath && rename(writtenPath.constData(), destinationPath) < 0)
+        errsv = errno;
+
+    if (errsv) {
+        //do not leave a partial file, only the file created here is removed.
+        unlink(writtenPath.constData());
+        if (errsv == ECANCELED && g_cancellable_set_error_if_cancelled(cancellable, error))
+            return FALSE;
+        return set_error_from_errno(error, errsv);
+    }
+
+    if (progress_callback && reported != total)
+        progress_callback(total, total, progress_callback_data);
+    return TRUE;
+}
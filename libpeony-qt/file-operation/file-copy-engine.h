@@ -0,0 +1,93 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2019, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef FILECOPYENGINE_H
+#define FILECOPYENGINE_H
+
+#include <gio/gio.h>
+
+namespace Peony {
+
+/*!
+ * \brief The FileCopyEngine class
+ * <br>
+ * FileCopyEngine copies a regular file between local file systems with native
+ * system calls. It tries a reflink (FICLONE) first, which shares the extents
+ * and finishes immediately on btrfs and xfs. Then copy_file_range(), which copies
+ * in kernel without passing the data through the user space, and a read/write
+ * loop with a large buffer at last.
+ * </br>
+ * <br>
+ * A sparse file is copied by its data extents found with SEEK_DATA and SEEK_HOLE,
+ * and the holes are recreated by extending the destination, so a thin disk image
+ * stays thin. Its progress is reported against the bytes of data, see
+ * FileNode::transferSize().
+ * </br>
+ * <br>
+ * Other files, such as symbolic links, special files and files of remote schemes,
+ * are copied with g_file_copy(). The errors are reported as GIOErrorEnum,
+ * so the callers can handle them in the same way as g_file_copy().
+ * </br>
+ */
+class FileCopyEngine
+{
+public:
+    /*!
+     * \brief copy
+     * \details
+     * This function has the same signature and semantic as g_file_copy(), except
+     * that G_FILE_COPY_BACKUP is always handled by gio. The progress of native
+     * copying is reported in coarse chunks.
+     * With G_FILE_COPY_OVERWRITE, the file is copied to a temporary file next to
+     * the destination, which is renamed over the destination on success. A failed
+     * or cancelled copy leaves the destination untouched.
+     */
+    static gboolean copy(GFile *source,
+                         GFile *destination,
+                         GFileCopyFlags flags,
+                         GCancellable *cancellable,
+                         GFileProgressCallback progress_callback,
+                         gpointer progress_callback_data,
+                         GError **error);
+
+    static bool canCopyNatively(GFile *source, GFile *destination, GFileCopyFlags flags);
+
+    /*!
+     * \brief transferSize
+     * \return the bytes a copy of the file transfers, which the progress is reported
+     * against. It is the allocated size for a sparse file and the size for others.
+     */
+    static goffset transferSize(goffset size, goffset allocatedSize);
+
+private:
+    static gboolean copyNatively(const char *sourcePath,
+                                 const char *destinationPath,
+                                 GFileCopyFlags flags,
+                                 GCancellable *cancellable,
+                                 GFileProgressCallback progress_callback,
+                                 gpointer progress_callback_data,
+                                 GError **error);
+};
+
+}
+
+#endif // FILECOPYENGINE_H
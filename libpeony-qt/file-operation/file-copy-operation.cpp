@@ -24,17 +24,109 @@
 
 #include "file-node-reporter.h"
 #include "file-node.h"
+#include "file-node-scanner.h"
 #include "file-enumerator.h"
 #include "file-info.h"
 
 #include "file-utils.h"
 
 #include "file-operation-manager.h"
+#include "file-copy-engine.h"
 
 #include <QDebug>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+//copying these files is bound by the latency rather than the bandwidth.
+#define SMALL_FILE_SIZE (1024*1024)
+#define SMALL_FILE_COPY_THREADS 16
 
 using namespace Peony;
 
+namespace Peony {
+
+struct SmallFileCopyTask
+{
+    FileNode *node = nullptr;
+    QFuture<void> future;
+    GError *err = nullptr;
+};
+
+}
+
+static QThreadPool *small_file_copy_pool()
+{
+    static QThreadPool *pool = nullptr;
+    static QMutex mutex;
+    QMutexLocker locker(&mutex);
+    if (!pool) {
+        pool = new QThreadPool;
+        pool->setMaxThreadCount(SMALL_FILE_COPY_THREADS);
+    }
+    return pool;
+}
+
+static int device_concurrency(dev_t dev)
+{
+    //network and virtual file systems have no block device.
+    if (major(dev) == 0)
+        return 4;
+
+    //a partition doesn't have the queue of its disk.
+    auto sysPath = QString("/sys/dev/block/%1:%2").arg(major(dev)).arg(minor(dev));
+    for (auto path : QStringList()<<sysPath + "/queue/rotational"<<sysPath + "/../queue/rotational") {
+        QFile file(path);
+        if (file.open(QIODevice::ReadOnly)) {
+            //seeking between files on a hard disk is slower than copying them in order.
+            return file.readAll().trimmed() == "1"? 1: 8;
+        }
+    }
+    return 4;
+}
+
+/*!
+ * \brief device_semaphore
+ * \param destDirUri
+ * \return the semaphore which bounds the concurrent copies to the device of
+ * destDirUri, it is shared by all the operations. nullptr if the files should
+ * not be copied concurrently.
+ */
+static QSemaphore *device_semaphore(const QString &destDirUri)
+{
+    static QMutex mutex;
+    static QHash<dev_t, QSemaphore*> semaphores;
+
+    GFile *destDir = g_file_new_for_uri(destDirUri.toUtf8().constData());
+    char *path = g_file_get_path(destDir);
+    g_object_unref(destDir);
+    if (!path)
+        return nullptr;
+
+    struct stat st;
+    int ret = stat(path, &st);
+    g_free(path);
+    if (ret != 0)
+        return nullptr;
+
+    QMutexLocker locker(&mutex);
+    auto semaphore = semaphores.value(st.st_dev);
+    if (!semaphore) {
+        int concurrency = device_concurrency(st.st_dev);
+        if (concurrency <= 1)
+            return nullptr;
+        semaphore = new QSemaphore(concurrency);
+        semaphores.insert(st.st_dev, semaphore);
+    }
+    return semaphore;
+}
+
 static void handleDuplicate(FileNode *node) {
     QString name = node->destBaseName();
     QRegExp regExp("\\(\\d+\\)");
@@ -100,7 +192,11 @@ FileCopyOperation::FileCopyOperation(QStringList sourceUris, QString destDirUri,
     m_source_uris = sourceUris;
     m_dest_dir_uri = destDirUri;
     m_reporter = new FileNodeReporter;
-    connect(m_reporter, &FileNodeReporter::nodeFound, this, &FileOperation::operationPreparedOne);
+    //the holes of sparse files are not copied, they are not counted in progress.
+    m_reporter->setTransferSizeReported(true);
+    //the nodes are found in the operation thread, do not post an event per node.
+    connect(m_reporter, &FileNodeReporter::nodeFound, this, &FileOperation::operationPreparedOne, Qt::DirectConnection);
+    connect(m_reporter, &FileNodeReporter::treeMemoryChanged, this, &FileOperation::operationTreeMemoryChanged, Qt::DirectConnection);
 
     m_info = std::make_shared<FileOperationInfo>(sourceUris, destDirUri, FileOperationInfo::Copy);
 }
@@ -128,7 +224,6 @@ void FileCopyOperation::progress_callback(goffset current_num_bytes,
 {
     auto currnet = p_this->m_current_offset + current_num_bytes;
     auto total = p_this->m_total_szie;
-    qDebug()<<currnet*1.0/total;
     Q_EMIT p_this->FileProgressCallback(p_this->m_current_src_uri,
                                         p_this->m_current_dest_dir_uri,
                                         currnet,
@@ -136,6 +231,16 @@ void FileCopyOperation::progress_callback(goffset current_num_bytes,
 }
 
 void FileCopyOperation::copyRecursively(FileNode *node)
+{
+    copyOne(node);
+    if (node->isFolder()) {
+        for (auto child : node->children()) {
+            copyRecursively(child);
+        }
+    }
+}
+
+void FileCopyOperation::copyOne(FileNode *node)
 {
     if (isCancelled())
         return;
@@ -229,21 +334,21 @@ fallback_retry:
             node->setState(FileNode::Handled);
         }
         //assume that make dir finished anyway
-        m_current_offset += node->size();
-        Q_EMIT operationProgressedOne(node->uri(), node->destUri(), node->size());
-        for (auto child : *(node->children())) {
-            copyRecursively(child);
-        }
+        m_current_offset += node->transferSize();
+        Q_EMIT operationProgressedOne(node->uri(), node->destUri(), node->transferSize());
+    } else if (m_copy_semaphore && !m_copying_serially && node->size() <= SMALL_FILE_SIZE) {
+        copyInParallel(node);
     } else {
         GError *err = nullptr;
         GFileWrapperPtr sourceFile = wrapGFile(g_file_new_for_uri(node->uri().toUtf8().constData()));
-        g_file_copy(sourceFile.get()->get(),
-                    destFile.get()->get(),
-                    m_default_copy_flag,
-                    getCancellable().get()->get(),
-                    GFileProgressCallback(progress_callback),
-                    this,
-                    &err);
+        //local files are copied with native system calls.
+        FileCopyEngine::copy(sourceFile.get()->get(),
+                             destFile.get()->get(),
+                             m_default_copy_flag,
+                             getCancellable().get()->get(),
+                             GFileProgressCallback(progress_callback),
+                             this,
+                             &err);
 
         if (err) {
             if (err->code == G_IO_ERROR_CANCELLED) {
@@ -271,25 +376,25 @@ fallback_retry:
                 break;
             }
             case OverWriteOne: {
-                g_file_copy(sourceFile.get()->get(),
-                            destFile.get()->get(),
-                            GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_OVERWRITE),
-                            getCancellable().get()->get(),
-                            GFileProgressCallback(progress_callback),
-                            this,
-                            nullptr);
+                FileCopyEngine::copy(sourceFile.get()->get(),
+                                     destFile.get()->get(),
+                                     GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_OVERWRITE),
+                                     getCancellable().get()->get(),
+                                     GFileProgressCallback(progress_callback),
+                                     this,
+                                     nullptr);
                 node->setState(FileNode::Handled);
                 node->setErrorResponse(OverWriteOne);
                 break;
             }
             case OverWriteAll: {
-                g_file_copy(sourceFile.get()->get(),
-                            destFile.get()->get(),
-                            GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_OVERWRITE),
-                            getCancellable().get()->get(),
-                            GFileProgressCallback(progress_callback),
-                            this,
-                            nullptr);
+                FileCopyEngine::copy(sourceFile.get()->get(),
+                                     destFile.get()->get(),
+                                     GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_OVERWRITE),
+                                     getCancellable().get()->get(),
+                                     GFileProgressCallback(progress_callback),
+                                     this,
+                                     nullptr);
                 node->setState(FileNode::Handled);
                 node->setErrorResponse(OverWriteOne);
                 m_prehandle_hash.insert(err->code, OverWriteOne);
@@ -326,12 +431,78 @@ fallback_retry:
         } else {
             node->setState(FileNode::Handled);
         }
-        m_current_offset += node->size();
-        Q_EMIT operationProgressedOne(node->uri(), node->destUri(), node->size());
+        m_current_offset += node->transferSize();
+        Q_EMIT operationProgressedOne(node->uri(), node->destUri(), node->transferSize());
     }
     destFile.reset();
 }
 
+void FileCopyOperation::copyInParallel(FileNode *node)
+{
+    //wait for a free slot of the device.
+    m_copy_semaphore->acquire();
+
+    auto task = std::make_shared<SmallFileCopyTask>();
+    task->node = node;
+    auto semaphore = m_copy_semaphore;
+    auto cancellable = getCancellable();
+    auto flags = m_default_copy_flag;
+    auto sourceUri = node->uri();
+    auto destUri = node->destUri();
+    task->future = QtConcurrent::run(small_file_copy_pool(), [=](){
+        GFile *sourceFile = g_file_new_for_uri(sourceUri.toUtf8().constData());
+        GFile *destFile = g_file_new_for_uri(destUri.toUtf8().constData());
+        FileCopyEngine::copy(sourceFile,
+                             destFile,
+                             flags,
+                             cancellable.get()->get(),
+                             nullptr,
+                             nullptr,
+                             &task->err);
+        g_object_unref(sourceFile);
+        g_object_unref(destFile);
+        semaphore->release();
+    });
+    m_copy_tasks<<task;
+
+    finishCopyTasks(false);
+}
+
+void FileCopyOperation::finishCopyTasks(bool wait)
+{
+    //the tasks are finished in the order they were started,
+    //so that the progress is reported in order.
+    while (!m_copy_tasks.isEmpty()) {
+        auto task = m_copy_tasks.first();
+        if (!wait && !task->future.isFinished())
+            return;
+
+        task->future.waitForFinished();
+        m_copy_tasks.removeFirst();
+
+        auto node = task->node;
+        if (!task->err) {
+            node->setState(FileNode::Handled);
+            m_current_offset += node->transferSize();
+            Q_EMIT operationProgressedOne(node->uri(), node->destUri(), node->transferSize());
+            continue;
+        }
+
+        bool cancelled = task->err->code == G_IO_ERROR_CANCELLED;
+        g_error_free(task->err);
+        if (cancelled || isCancelled()) {
+            //nothing was copied, do not delete the destination when rolling back.
+            node->setState(FileNode::Unhandled);
+            continue;
+        }
+
+        //copy it again serially, the error will be handled there.
+        m_copying_serially = true;
+        copyOne(node);
+        m_copying_serially = false;
+    }
+}
+
 void FileCopyOperation::rollbackNodeRecursively(FileNode *node)
 {
     switch (node->state()) {
@@ -344,7 +515,7 @@ void FileCopyOperation::rollbackNodeRecursively(FileNode *node)
 
         if (node->isFolder()) {
             auto children = node->children();
-            for (auto child : *children) {
+            for (auto child : children) {
                 rollbackNodeRecursively(child);
             }
             GFile *dest_file = g_file_new_for_uri(node->destUri().toUtf8().constData());
@@ -356,7 +527,7 @@ void FileCopyOperation::rollbackNodeRecursively(FileNode *node)
                 FileEnumerator e;
                 e.setEnumerateDirectory(node->destUri());
                 e.enumerateSync();
-                for (auto folder_child : *node->children()) {
+                for (auto folder_child : node->children()) {
                     if (!folder_child->destUri().isEmpty()) {
                         GFile *tmp_file = g_file_new_for_uri(folder_child->destUri().toUtf8().constData());
                         g_file_delete(tmp_file, nullptr, nullptr);
@@ -378,7 +549,7 @@ void FileCopyOperation::rollbackNodeRecursively(FileNode *node)
         //make sure all nodes were rollbacked.
         if (node->isFolder()) {
             auto children = node->children();
-            for (auto child : *children) {
+            for (auto child : children) {
                 rollbackNodeRecursively(child);
             }
         }
@@ -396,23 +567,31 @@ void FileCopyOperation::run()
 
     Q_EMIT operationRequestShowWizard();
 
-    goffset *total_size = new goffset(0);
+    FileNodeScanner scanner(m_source_uris, m_reporter);
+    scanner.start();
 
-    QList<FileNode*> nodes;
+    //a folder copied into itself would be scanned endlessly, prepare it at first.
+    bool streaming = true;
     for (auto uri : m_source_uris) {
-        FileNode *node = new FileNode(uri, nullptr, m_reporter);
-        node->findChildrenRecursively();
-        node->computeTotalSize(total_size);
-        nodes<<node;
+        if (m_dest_dir_uri == uri || m_dest_dir_uri.startsWith(uri + "/"))
+            streaming = false;
     }
+    if (!streaming)
+        scanner.waitForFinished();
+
+    //the files are copied while scanning, the total size grows until the scanner finished.
     Q_EMIT operationPrepared();
 
-    m_total_szie = *total_size;
-    delete total_size;
+    m_copy_semaphore = device_semaphore(m_dest_dir_uri);
 
-    for (auto node : nodes) {
-        copyRecursively(node);
+    while (auto node = scanner.take()) {
+        m_total_szie = scanner.totalSize();
+        copyOne(node);
     }
+    finishCopyTasks(true);
+
+    auto nodes = scanner.waitForFinished();
+    m_total_szie = scanner.totalSize();
     Q_EMIT operationProgressed();
 
     if (isCancelled()) {
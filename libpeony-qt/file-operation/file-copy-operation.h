@@ -27,10 +27,15 @@
 
 #include "file-operation.h"
 
+#include <QFuture>
+
+class QSemaphore;
+
 namespace Peony {
 
 class FileNodeReporter;
 class FileNode;
+struct SmallFileCopyTask;
 
 /*!
  * \brief The FileCopyOperation class
@@ -61,6 +66,32 @@ protected:
      * \see FileMoveOperation::copyRecursively()
      */
     void copyRecursively(FileNode *node);
+    /*!
+     * \brief copyOne
+     * \param node
+     * \details
+     * Copy the file, or make the folder without its children. The parent folder
+     * must have been handled.
+     */
+    void copyOne(FileNode *node);
+
+    /*!
+     * \brief copyInParallel
+     * \param node
+     * \details
+     * Small files are bound by the latency of open, create and metadata rather
+     * than the bandwidth. They are copied by a worker pool, while the directories
+     * are still created in order by copyOne(). The concurrent copies are
+     * bounded per destination device.
+     * A file failed to copy is copied again serially in finishCopyTasks(),
+     * so the errors are handled and rollbacked in the same way as before.
+     */
+    void copyInParallel(FileNode *node);
+    /*!
+     * \brief finishCopyTasks
+     * \param wait, if false, only the finished tasks at the front are handled.
+     */
+    void finishCopyTasks(bool wait);
     /*!
      * \brief rollbackNodeRecursively
      * \param node
@@ -102,6 +133,10 @@ private:
 
     FileNodeReporter *m_reporter = nullptr;
 
+    QSemaphore *m_copy_semaphore = nullptr;
+    QList<std::shared_ptr<SmallFileCopyTask>> m_copy_tasks;
+    bool m_copying_serially = false;
+
     /*!
      * \brief m_prehandle_hash
      * \details
@@ -0,0 +1,272 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2019, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#include "file-delete-engine.h"
+
+#include <QList>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <dirent.h>
+#include <string.h>
+#include <sys/stat.h>
+
+//deleting is bound by the metadata latency rather than the bandwidth.
+#define DELETE_THREADS 8
+//report the progress of a huge folder before it is done.
+#define PROGRESS_BATCH_SIZE 1024
+
+using namespace Peony;
+
+QThreadPool *FileDeleteEngine::threadPool()
+{
+    static QThreadPool *pool = nullptr;
+    static QMutex mutex;
+    QMutexLocker locker(&mutex);
+    if (!pool) {
+        pool = new QThreadPool;
+        pool->setMaxThreadCount(DELETE_THREADS);
+    }
+    return pool;
+}
+
+FileDeleteEngine::FileDeleteEngine(GCancellable *cancellable)
+{
+    m_cancellable = cancellable;
+}
+
+bool FileDeleteEngine::canDeleteNatively(const QString &uri)
+{
+    GFile *file = g_file_new_for_uri(uri.toUtf8().constData());
+    bool native = g_file_is_native(file);
+    g_object_unref(file);
+    return native;
+}
+
+bool FileDeleteEngine::isStopped()
+{
+    return m_stopped.load() || g_cancellable_is_cancelled(m_cancellable);
+}
+
+void FileDeleteEngine::handleError(const QByteArray &path, int errsv)
+{
+    //one error dialog at a time.
+    QMutexLocker locker(&m_error_mutex);
+    if (isStopped())
+        return;
+
+    GError *err = g_error_new_literal(G_IO_ERROR, g_io_error_from_errno(errsv), g_strerror(errsv));
+    char *uri = g_filename_to_uri(path.constData(), nullptr, nullptr);
+    bool goOn = true;
+    if (m_error_handler) {
+        goOn = m_error_handler(uri, err);
+    } else {
+        g_error_free(err);
+    }
+    g_free(uri);
+
+    if (!goOn)
+        m_stopped.store(1);
+}
+
+void FileDeleteEngine::reportProgress(const QByteArray &path, qint64 found, qint64 deleted)
+{
+    if (!m_progress_handler || (found == 0 && deleted == 0))
+        return;
+
+    char *uri = g_filename_to_uri(path.constData(), nullptr, nullptr);
+    if (!m_progress_handler(uri, found, deleted))
+        m_stopped.store(1);
+    g_free(uri);
+}
+
+bool FileDeleteEngine::deleteRecursively(const QString &uri)
+{
+    GFile *file = g_file_new_for_uri(uri.toUtf8().constData());
+    char *path = g_file_get_path(file);
+    g_object_unref(file);
+    if (!path)
+        return false;
+
+    QByteArray filePath = path;
+    g_free(path);
+    while (filePath.length() > 1 && filePath.endsWith('/'))
+        filePath.chop(1);
+
+    int index = filePath.lastIndexOf('/');
+    QByteArray parentPath = index > 0? filePath.left(index): "/";
+    QByteArray name = filePath.mid(index + 1);
+
+    int parentFd = open(parentPath.constData(), O_RDONLY|O_DIRECTORY|O_CLOEXEC);
+    if (parentFd < 0) {
+        handleError(filePath, errno);
+        return !isStopped();
+    }
+
+    bool deleted = deleteEntry(parentFd, filePath, name, DT_UNKNOWN);
+    close(parentFd);
+    reportProgress(filePath, 1, deleted? 1: 0);
+
+    return !isStopped();
+}
+
+bool FileDeleteEngine::deleteChildren(const QString &uri)
+{
+    GFile *file = g_file_new_for_uri(uri.toUtf8().constData());
+    char *path = g_file_get_path(file);
+    g_object_unref(file);
+    if (!path)
+        return false;
+
+    QByteArray folderPath = path;
+    g_free(path);
+
+    //the path is absolute, so it is opened relative to nothing.
+    deleteDirectory(AT_FDCWD, folderPath, folderPath);
+    return !isStopped();
+}
+
+bool FileDeleteEngine::deleteEntry(int parentFd, const QByteArray &path, const QByteArray &name, unsigned char type)
+{
+    if (isStopped())
+        return false;
+
+    if (type == DT_UNKNOWN) {
+        struct stat st;
+        if (fstatat(parentFd, name.constData(), &st, AT_SYMLINK_NOFOLLOW) != 0) {
+            if (errno != ENOENT)
+                handleError(path, errno);
+            return false;
+        }
+        type = S_ISDIR(st.st_mode)? DT_DIR: DT_REG;
+    }
+
+    if (type != DT_DIR) {
+        if (unlinkat(parentFd, name.constData(), 0) == 0 || errno == ENOENT)
+            return true;
+        //the type from readdir() might be stale.
+        if (errno != EISDIR) {
+            handleError(path, errno);
+            return false;
+        }
+    }
+
+    deleteDirectory(parentFd, path, name);
+    if (isStopped())
+        return false;
+
+    if (unlinkat(parentFd, name.constData(), AT_REMOVEDIR) == 0 || errno == ENOENT)
+        return true;
+    handleError(path, errno);
+    return false;
+}
+
+void FileDeleteEngine::deleteDirectory(int parentFd, const QByteArray &path, const QByteArray &name)
+{
+    int fd = openat(parentFd, name.constData(), O_RDONLY|O_DIRECTORY|O_NOFOLLOW|O_CLOEXEC);
+    if (fd < 0) {
+        if (errno != ENOENT)
+            handleError(path, errno);
+        return;
+    }
+
+    DIR *dir = fdopendir(fd);
+    if (!dir) {
+        handleError(path, errno);
+        close(fd);
+        return;
+    }
+
+    QList<QByteArray> subDirs;
+    QByteArray lastPath;
+    qint64 found = 0;
+    qint64 deleted = 0;
+
+    struct dirent *entry = nullptr;
+    while (!isStopped() && (entry = readdir(dir))) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+            continue;
+
+        found++;
+        QByteArray childName = entry->d_name;
+        //the sub folders are deleted after all the files, maybe in parallel.
+        if (entry->d_type == DT_DIR) {
+            subDirs<<childName;
+            continue;
+        }
+
+        lastPath = path + "/" + childName;
+        if (deleteEntry(fd, lastPath, childName, entry->d_type))
+            deleted++;
+
+        if (deleted >= PROGRESS_BATCH_SIZE) {
+            reportProgress(lastPath, found, deleted);
+            found = 0;
+            deleted = 0;
+        }
+    }
+    reportProgress(lastPath, found, deleted);
+
+    //the sub folders are removed relative to this directory, so a parent that is
+    //swapped for a symlink during the deletion can not lead us out of the tree.
+    //only the fd is kept for them, the buffer of the stream is released here.
+    int childrenFd = subDirs.isEmpty()? -1: dup(fd);
+    closedir(dir);
+    if (subDirs.isEmpty())
+        return;
+    if (childrenFd < 0) {
+        handleError(path, errno);
+        return;
+    }
+
+    QList<QFuture<bool>> futures;
+    for (int i = 0; i < subDirs.count(); i++) {
+        if (isStopped())
+            break;
+
+        auto childName = subDirs.at(i);
+        auto childPath = path + "/" + childName;
+        //keep the last one for this thread, and do not queue more than the pool can run.
+        auto pool = threadPool();
+        if (i < subDirs.count() - 1 && pool->activeThreadCount() < pool->maxThreadCount()) {
+            futures<<QtConcurrent::run(pool, [=](){
+                bool result = deleteEntry(childrenFd, childPath, childName, DT_DIR);
+                reportProgress(childPath, 0, result? 1: 0);
+                return result;
+            });
+        } else {
+            bool result = deleteEntry(childrenFd, childPath, childName, DT_DIR);
+            reportProgress(childPath, 0, result? 1: 0);
+        }
+    }
+
+    //the workers use the fd, it is closed after all of them are done.
+    for (auto future : futures) {
+        future.waitForFinished();
+    }
+    close(childrenFd);
+}
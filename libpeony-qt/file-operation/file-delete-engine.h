@@ -0,0 +1,126 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2019, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#ifndef FILEDELETEENGINE_H
+#define FILEDELETEENGINE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QMutex>
+#include <QAtomicInt>
+#include <gio/gio.h>
+
+#include <functional>
+
+class QThreadPool;
+
+namespace Peony {
+
+/*!
+ * \brief The FileDeleteEngine class
+ * <br>
+ * FileDeleteEngine deletes local files recursively with native system calls, like
+ * rm -rf. The directories are walked with openat() and readdir(), and the files
+ * are removed with unlinkat() relative to the directory fds, so there is no GFile,
+ * path lookup or FileNode tree for each file. The sub folders are opened and removed
+ * relative to the fd of their parent, too, so the deletion never follows a symlink
+ * out of the tree even if a parent is replaced while it runs. The stream of a
+ * directory is released once its entries are read, only its fd is kept for the sub
+ * folders. The sibling sub folders are deleted in parallel by a worker pool.
+ * </br>
+ * <br>
+ * The files of remote schemes, such as trash:/// and smb://, should be deleted by
+ * gio in FileDeleteOperation.
+ * </br>
+ * \note
+ * The handlers are called by the worker threads. The error handler is never called
+ * concurrently.
+ */
+class FileDeleteEngine
+{
+public:
+    /*!
+     * \brief ErrorHandler
+     * \return false if the deletion should stop. The handler takes the ownership of err.
+     */
+    typedef std::function<bool (const QString &uri, GError *err)> ErrorHandler;
+    /*!
+     * \brief ProgressHandler
+     * \details
+     * The progress is reported in batches, found and deleted are the counts of
+     * entries since the last report, uri is the last deleted one.
+     * \return false if the deletion should stop.
+     */
+    typedef std::function<bool (const QString &uri, qint64 found, qint64 deleted)> ProgressHandler;
+
+    explicit FileDeleteEngine(GCancellable *cancellable);
+
+    void setErrorHandler(const ErrorHandler &handler) {m_error_handler = handler;}
+    void setProgressHandler(const ProgressHandler &handler) {m_progress_handler = handler;}
+
+    static bool canDeleteNatively(const QString &uri);
+    /*!
+     * \brief threadPool
+     * \return the worker pool of deletion. The callers deleting several trees at
+     * once should run them in it, so the deletion never takes more threads than it.
+     * A worker never waits for a queued task, the sub folders are deleted in the
+     * calling thread when the pool is busy.
+     */
+    static QThreadPool *threadPool();
+
+    /*!
+     * \brief deleteRecursively
+     * \param uri
+     * \return false if it is stopped by a handler or cancelled.
+     */
+    bool deleteRecursively(const QString &uri);
+    /*!
+     * \brief deleteChildren
+     * \param uri, a local folder.
+     * \return false if it is stopped by a handler or cancelled.
+     * \details
+     * Delete the contents of the folder and keep itself, it is used to empty the
+     * files and info directories of trash.
+     */
+    bool deleteChildren(const QString &uri);
+
+private:
+    bool deleteEntry(int parentFd, const QByteArray &path, const QByteArray &name, unsigned char type);
+    void deleteDirectory(int parentFd, const QByteArray &path, const QByteArray &name);
+
+    void handleError(const QByteArray &path, int errsv);
+    void reportProgress(const QByteArray &path, qint64 found, qint64 deleted);
+    bool isStopped();
+
+private:
+    GCancellable *m_cancellable = nullptr;
+    ErrorHandler m_error_handler;
+    ProgressHandler m_progress_handler;
+
+    QMutex m_error_mutex;
+    QAtomicInt m_stopped = 0;
+};
+
+}
+
+#endif // FILEDELETEENGINE_H
@@ -24,6 +24,8 @@
 #include "file-operation-manager.h"
 #include "file-node.h"
 #include "file-node-reporter.h"
+#include "file-node-scanner.h"
+#include "file-delete-engine.h"
 
 using namespace Peony;
 
@@ -32,7 +34,9 @@ FileDeleteOperation::FileDeleteOperation(QStringList sourceUris, QObject *parent
     m_source_uris = sourceUris;
     m_reporter = new FileNodeReporter;
     m_info = std::make_shared<FileOperationInfo>(sourceUris, nullptr, FileOperationInfo::Delete);
-    connect(m_reporter, &FileNodeReporter::nodeFound, this, &FileOperation::operationPreparedOne);
+    //the nodes are found in the operation thread, do not post an event per node.
+    connect(m_reporter, &FileNodeReporter::nodeFound, this, &FileOperation::operationPreparedOne, Qt::DirectConnection);
+    connect(m_reporter, &FileNodeReporter::treeMemoryChanged, this, &FileOperation::operationTreeMemoryChanged, Qt::DirectConnection);
 }
 
 FileDeleteOperation::~FileDeleteOperation()
@@ -50,44 +54,67 @@ void FileDeleteOperation::deleteRecursively(FileNode *node)
     if (isCancelled())
         return;
 
-    GFile *file = g_file_new_for_uri(node->uri().toUtf8().constData());
     if (node->isFolder()) {
-        for (auto child : *(node->children())) {
+        for (auto child : node->children()) {
             deleteRecursively(child);
         }
-        GError *err = nullptr;
-        g_file_delete(file,
-                      getCancellable().get()->get(),
-                      &err);
-        if (err) {
-            //if delete a file get into error, it might be a critical error.
-            auto response = errored(node->uri(), nullptr, GErrorWrapper::wrapFrom(err), true);
-            qDebug()<<response;
-            auto responseType = response.value<ResponseType>();
-            if (responseType == Cancel) {
-                cancel();
-            }
-        }
-    } else {
-        GError *err = nullptr;
-        g_file_delete(file,
-                      getCancellable().get()->get(),
-                      &err);
-        if (err) {
-            //if delete a file get into error, it might be a critical error.
-            auto response = errored(node->uri(), nullptr, GErrorWrapper::wrapFrom(err), true);
-            qDebug()<<response;
-            auto responseType = response.value<ResponseType>();
-            if (responseType == Cancel) {
-                cancel();
-            }
+    }
+
+    //the files might have been deleted while scanning.
+    if (node->state() != FileNode::Handled)
+        deleteOne(node);
+}
+
+void FileDeleteOperation::deleteOne(FileNode *node)
+{
+    if (isCancelled())
+        return;
+
+    GFile *file = g_file_new_for_uri(node->uri().toUtf8().constData());
+    GError *err = nullptr;
+    g_file_delete(file,
+                  getCancellable().get()->get(),
+                  &err);
+    if (err) {
+        //if delete a file get into error, it might be a critical error.
+        auto response = errored(node->uri(), nullptr, GErrorWrapper::wrapFrom(err), true);
+        qDebug()<<response;
+        auto responseType = response.value<ResponseType>();
+        if (responseType == Cancel) {
+            cancel();
         }
     }
     g_object_unref(file);
-    qDebug()<<"deleted";
+    node->setState(FileNode::Handled);
     operationAfterProgressedOne(node->uri());
 }
 
+void FileDeleteOperation::deleteNatively(const QStringList &uris)
+{
+    FileDeleteEngine engine(getCancellable().get()->get());
+    engine.setErrorHandler([=](const QString &uri, GError *err){
+        //if delete a file get into error, it might be a critical error.
+        auto response = errored(uri, nullptr, GErrorWrapper::wrapFrom(err), true);
+        auto responseType = response.value<ResponseType>();
+        if (responseType == Cancel) {
+            cancel();
+            return false;
+        }
+        return true;
+    });
+    engine.setProgressHandler([=](const QString &uri, qint64 found, qint64 deleted){
+        reportPreparedFiles(found, 0);
+        reportClearedFiles(uri, deleted);
+        //the workers stop here while the operation is paused.
+        return !isCancelled();
+    });
+
+    for (auto uri : uris) {
+        if (!engine.deleteRecursively(uri))
+            break;
+    }
+}
+
 void FileDeleteOperation::run()
 {
     if (isCancelled())
@@ -97,27 +124,48 @@ void FileDeleteOperation::run()
 
     Q_EMIT operationRequestShowWizard();
 
-    goffset *total_size = new goffset(0);
+    //the files are deleted while scanning, so the clearing stage starts at once.
+    operationPrepared();
+    operationProgressed();
 
-    QList<FileNode*> nodes;
+    //local files are deleted natively without a FileNode tree.
+    QStringList uris;
+    QStringList nativeUris;
     for (auto uri : m_source_uris) {
-        FileNode *node = new FileNode(uri, nullptr, m_reporter);
-        node->findChildrenRecursively();
-        node->computeTotalSize(total_size);
-        nodes<<node;
+        if (FileDeleteEngine::canDeleteNatively(uri)) {
+            nativeUris<<uri;
+        } else {
+            uris<<uri;
+        }
+    }
+    if (!nativeUris.isEmpty())
+        deleteNatively(nativeUris);
+
+    if (uris.isEmpty() || isCancelled()) {
+        Q_EMIT operationFinished();
+        return;
     }
-    operationPrepared();
 
-    m_total_szie = *total_size;
-    delete total_size;
+    FileNodeScanner scanner(uris, m_reporter);
+    scanner.start();
 
-    //jump to the clearing stage.
-    operationProgressed();
+    //the folders are deleted after their children, once the scanner finished.
+    while (auto node = scanner.take()) {
+        if (!node->isFolder())
+            deleteOne(node);
+    }
+
+    auto nodes = scanner.waitForFinished();
+    m_total_szie = scanner.totalSize();
 
     for (auto node : nodes) {
         deleteRecursively(node);
     }
 
+    for (auto node : nodes) {
+        delete node;
+    }
+
     Q_EMIT operationFinished();
 }
 
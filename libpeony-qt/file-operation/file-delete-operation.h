@@ -42,6 +42,21 @@ public:
     std::shared_ptr<FileOperationInfo> getOperationInfo() override;
 
     void deleteRecursively(FileNode *node);
+    /*!
+     * \brief deleteOne
+     * \param node
+     * \details
+     * Delete the file or the empty folder of node, and mark it handled.
+     */
+    void deleteOne(FileNode *node);
+    /*!
+     * \brief deleteNatively
+     * \param uris, the local files.
+     * \details
+     * Delete the local files with FileDeleteEngine. The failed entries are handled
+     * by the error handler as deleteOne() does.
+     */
+    void deleteNatively(const QStringList &uris);
     void run() override;
 
     void cancel() override;
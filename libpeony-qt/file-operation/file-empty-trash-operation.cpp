@@ -0,0 +1,98 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2019, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#include "file-empty-trash-operation.h"
+#include "file-operation-manager.h"
+#include "file-delete-engine.h"
+#include "file-trash-engine.h"
+
+#include <QtConcurrent>
+
+using namespace Peony;
+
+FileEmptyTrashOperation::FileEmptyTrashOperation(QObject *parent) : FileOperation (parent)
+{
+    m_trash_directories = FileTrashEngine::trashDirectories();
+
+    //the trash directories are the sources, so that the operation is scheduled by their devices.
+    QStringList uris;
+    for (auto path : m_trash_directories) {
+        uris<<QUrl::fromLocalFile(path).toString();
+    }
+    m_info = std::make_shared<FileOperationInfo>(uris, nullptr, FileOperationInfo::Delete);
+}
+
+void FileEmptyTrashOperation::emptyTrashDirectory(const QString &path)
+{
+    FileDeleteEngine engine(getCancellable().get()->get());
+    engine.setErrorHandler([=](const QString &uri, GError *err){
+        auto response = errored(uri, nullptr, GErrorWrapper::wrapFrom(err), true);
+        auto responseType = response.value<ResponseType>();
+        if (responseType == Cancel) {
+            cancel();
+            return false;
+        }
+        return true;
+    });
+    engine.setProgressHandler([=](const QString &uri, qint64 found, qint64 deleted){
+        reportPreparedFiles(found, 0);
+        reportClearedFiles(uri, deleted);
+        return !isCancelled();
+    });
+
+    engine.deleteChildren(QUrl::fromLocalFile(path + "/files").toString());
+
+    //only the trash info of the deleted files is removed, the files left by
+    //errors or cancellation can still be restored.
+    FileTrashEngine::removeOrphanedTrashInfo(path);
+
+    //drop the directorysizes entries of the deleted folders.
+    FileTrashEngine::trashSize(path);
+}
+
+void FileEmptyTrashOperation::run()
+{
+    if (isCancelled())
+        return;
+
+    Q_EMIT operationStarted();
+
+    Q_EMIT operationRequestShowWizard();
+
+    //the files are counted while deleting, so the clearing stage starts at once.
+    operationPrepared();
+    operationProgressed();
+
+    //the trash directories share the pool of the engine with their sub folders.
+    QList<QFuture<void>> futures;
+    for (auto path : m_trash_directories) {
+        futures<<QtConcurrent::run(FileDeleteEngine::threadPool(), [=](){
+            emptyTrashDirectory(path);
+        });
+    }
+    for (auto future : futures) {
+        future.waitForFinished();
+    }
+
+    Q_EMIT operationFinished();
+}
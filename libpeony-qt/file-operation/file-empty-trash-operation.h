@@ -0,0 +1,60 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2019, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#ifndef FILEEMPTYTRASHOPERATION_H
+#define FILEEMPTYTRASHOPERATION_H
+
+#include "peony-core_global.h"
+#include "file-operation.h"
+
+namespace Peony {
+
+/*!
+ * \brief The FileEmptyTrashOperation class
+ * <br>
+ * This class deletes all the files in trash. Instead of deleting the items of
+ * trash:/// one by one through the trash backend, it empties the files and info
+ * directories of every trash directory natively with FileDeleteEngine. The trash
+ * directories are emptied in parallel.
+ * </br>
+ * \see FileTrashEngine::trashDirectories().
+ */
+class PEONYCORESHARED_EXPORT FileEmptyTrashOperation : public FileOperation
+{
+    Q_OBJECT
+public:
+    explicit FileEmptyTrashOperation(QObject *parent = nullptr);
+
+    std::shared_ptr<FileOperationInfo> getOperationInfo() override {return m_info;}
+    void run() override;
+
+private:
+    void emptyTrashDirectory(const QString &path);
+
+    QStringList m_trash_directories;
+    std::shared_ptr<FileOperationInfo> m_info = nullptr;
+};
+
+}
+
+#endif // FILEEMPTYTRASHOPERATION_H
@@ -27,6 +27,7 @@
 #include "file-info.h"
 
 #include "file-operation-manager.h"
+#include "file-copy-engine.h"
 
 using namespace Peony;
 
@@ -351,7 +352,7 @@ void FileMoveOperation::rollbackNodeRecursively(FileNode *node)
 
         if (node->isFolder()) {
             auto children = node->children();
-            for (auto child : *children) {
+            for (auto child : children) {
                 rollbackNodeRecursively(child);
             }
             GFile *dest_file = g_file_new_for_uri(node->destUri().toUtf8().constData());
@@ -373,7 +374,7 @@ void FileMoveOperation::rollbackNodeRecursively(FileNode *node)
                 g_file_make_directory(src_file, nullptr, nullptr);
                 g_object_unref(src_file);
                 auto children = node->children();
-                for (auto child : *children) {
+                for (auto child : children) {
                     rollbackNodeRecursively(child);
                 }
                 //try deleting the dest directory
@@ -411,7 +412,7 @@ void FileMoveOperation::rollbackNodeRecursively(FileNode *node)
                 g_file_make_directory(src_file, nullptr, nullptr);
                 g_object_unref(src_file);
                 auto children = node->children();
-                for (auto child : *children) {
+                for (auto child : children) {
                     rollbackNodeRecursively(child);
                 }
                 GFile *dest_file = g_file_new_for_uri(node->destUri().toUtf8().constData());
@@ -447,7 +448,7 @@ void FileMoveOperation::rollbackNodeRecursively(FileNode *node)
         //make sure all nodes were rollbacked.
         if (node->isFolder()) {
             auto children = node->children();
-            for (auto child : *children) {
+            for (auto child : children) {
                 rollbackNodeRecursively(child);
             }
         }
@@ -562,19 +563,19 @@ fallback_retry:
                                     m_current_offset,
                                     m_total_szie);
         Q_EMIT operationProgressedOne(node->uri(), node->destUri(), node->size());
-        for (auto child : *(node->children())) {
+        for (auto child : node->children()) {
             copyRecursively(child);
         }
     } else {
         GError *err = nullptr;
         GFileWrapperPtr sourceFile = wrapGFile(g_file_new_for_uri(node->uri().toUtf8().constData()));
-        g_file_copy(sourceFile.get()->get(),
-                    destFile.get()->get(),
-                    m_default_copy_flag,
-                    getCancellable().get()->get(),
-                    GFileProgressCallback(progress_callback),
-                    this,
-                    &err);
+        FileCopyEngine::copy(sourceFile.get()->get(),
+                             destFile.get()->get(),
+                             m_default_copy_flag,
+                             getCancellable().get()->get(),
+                             GFileProgressCallback(progress_callback),
+                             this,
+                             &err);
 
         if (err) {
             if (err->code == G_IO_ERROR_CANCELLED) {
@@ -602,50 +603,50 @@ fallback_retry:
                 break;
             }
             case OverWriteOne: {
-                g_file_copy(sourceFile.get()->get(),
-                            destFile.get()->get(),
-                            GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_OVERWRITE),
-                            getCancellable().get()->get(),
-                            GFileProgressCallback(progress_callback),
-                            this,
-                            nullptr);
+                FileCopyEngine::copy(sourceFile.get()->get(),
+                                     destFile.get()->get(),
+                                     GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_OVERWRITE),
+                                     getCancellable().get()->get(),
+                                     GFileProgressCallback(progress_callback),
+                                     this,
+                                     nullptr);
                 node->setState(FileNode::Handled);
                 node->setErrorResponse(OverWriteOne);
                 break;
             }
             case OverWriteAll: {
-                g_file_copy(sourceFile.get()->get(),
-                            destFile.get()->get(),
-                            GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_OVERWRITE),
-                            getCancellable().get()->get(),
-                            GFileProgressCallback(progress_callback),
-                            this,
-                            nullptr);
+                FileCopyEngine::copy(sourceFile.get()->get(),
+                                     destFile.get()->get(),
+                                     GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_OVERWRITE),
+                                     getCancellable().get()->get(),
+                                     GFileProgressCallback(progress_callback),
+                                     this,
+                                     nullptr);
                 node->setState(FileNode::Handled);
                 node->setErrorResponse(OverWriteOne);
                 m_prehandle_hash.insert(err->code, OverWriteOne);
                 break;
             }
             case BackupOne: {
-                g_file_copy(sourceFile.get()->get(),
-                            destFile.get()->get(),
-                            GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_BACKUP),
-                            getCancellable().get()->get(),
-                            GFileProgressCallback(progress_callback),
-                            this,
-                            nullptr);
+                FileCopyEngine::copy(sourceFile.get()->get(),
+                                     destFile.get()->get(),
+                                     GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_BACKUP),
+                                     getCancellable().get()->get(),
+                                     GFileProgressCallback(progress_callback),
+                                     this,
+                                     nullptr);
                 node->setState(FileNode::Handled);
                 node->setErrorResponse(BackupOne);
                 break;
             }
             case BackupAll: {
-                g_file_copy(sourceFile.get()->get(),
-                            destFile.get()->get(),
-                            GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_BACKUP),
-                            getCancellable().get()->get(),
-                            GFileProgressCallback(progress_callback),
-                            this,
-                            nullptr);
+                FileCopyEngine::copy(sourceFile.get()->get(),
+                                     destFile.get()->get(),
+                                     GFileCopyFlags(m_default_copy_flag | G_FILE_COPY_BACKUP),
+                                     getCancellable().get()->get(),
+                                     GFileProgressCallback(progress_callback),
+                                     this,
+                                     nullptr);
                 node->setState(FileNode::Handled);
                 node->setErrorResponse(BackupOne);
                 m_prehandle_hash.insert(err->code, BackupOne);
@@ -665,9 +666,9 @@ fallback_retry:
         } else {
             node->setState(FileNode::Handled);
         }
-        m_current_offset += node->size();
+        m_current_offset += node->transferSize();
         Q_EMIT FileProgressCallback(node->uri(), node->destUri(), m_current_offset, m_total_szie);
-        Q_EMIT operationProgressedOne(node->uri(), node->destUri(), node->size());
+        Q_EMIT operationProgressedOne(node->uri(), node->destUri(), node->transferSize());
     }
     destFile.reset();
     destRoot.reset();
@@ -680,7 +681,7 @@ void FileMoveOperation::deleteRecursively(FileNode *node)
 
     GFile *file = g_file_new_for_uri(node->uri().toUtf8().constData());
     if (node->isFolder()) {
-        for (auto child : *(node->children())) {
+        for (auto child : node->children()) {
             deleteRecursively(child);
         }
         g_file_delete(file,
@@ -705,7 +706,11 @@ void FileMoveOperation::moveForceUseFallback()
 
     Q_EMIT operationRequestShowWizard();
     m_reporter = new FileNodeReporter;
-    connect(m_reporter, &FileNodeReporter::nodeFound, this, &FileMoveOperation::operationPreparedOne);
+    //the files are copied by FileCopyEngine, which skips the holes of sparse files.
+    m_reporter->setTransferSizeReported(true);
+    //the nodes are found in the operation thread, do not post an event per node.
+    connect(m_reporter, &FileNodeReporter::nodeFound, this, &FileMoveOperation::operationPreparedOne, Qt::DirectConnection);
+    connect(m_reporter, &FileNodeReporter::treeMemoryChanged, this, &FileOperation::operationTreeMemoryChanged, Qt::DirectConnection);
 
     //FIXME: total size should not compute twice. I should get it from ui-thread.
     goffset *total_size = new goffset(0);
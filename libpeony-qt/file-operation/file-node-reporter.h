@@ -50,11 +50,38 @@ public:
         Q_EMIT nodeFound(uri, offset);
     }
 
+    /*!
+     * \brief sendTreeMemoryAllocated
+     * \param bytes
+     * \details
+     * It is called by the arena of FileNode trees when a block is allocated.
+     */
+    void sendTreeMemoryAllocated(const qint64 &bytes) {
+        m_tree_memory += bytes;
+        Q_EMIT treeMemoryChanged(m_tree_memory);
+    }
+    qint64 treeMemory() {return m_tree_memory;}
+
+    /*!
+     * \brief setTransferSizeReported
+     * \param reported
+     * \details
+     * Report FileNode::transferSize() instead of the size of found nodes, the copy
+     * operations estimate their progress with it.
+     */
+    void setTransferSizeReported(bool reported) {m_transfer_size_reported = reported;}
+    bool isTransferSizeReported() {return m_transfer_size_reported;}
+
     void cancel() {m_cancelled = true;}
     bool isOperationCancelled() {return m_cancelled;}
 
 Q_SIGNALS:
     void nodeFound(const QString &uri, const qint64 &offset);
+    /*!
+     * \brief treeMemoryChanged
+     * \param bytes, the memory allocated by the trees of this reporter.
+     */
+    void treeMemoryChanged(const qint64 &bytes);
     /*!
      * \brief enumerateNodeFinished
      * \deprecated
@@ -71,6 +98,8 @@ Q_SIGNALS:
 
 private:
     bool m_cancelled = false;
+    bool m_transfer_size_reported = false;
+    qint64 m_tree_memory = 0;
 };
 
 }
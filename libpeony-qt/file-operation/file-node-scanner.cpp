@@ -0,0 +1,132 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2019, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#include "file-node-scanner.h"
+#include "file-node.h"
+#include "file-node-reporter.h"
+#include "file-operation-manager.h"
+
+#include <QtConcurrent>
+#include <QDebug>
+
+using namespace Peony;
+
+FileNodeScanner::FileNodeScanner(const QStringList &uris, FileNodeReporter *reporter, int capacity)
+{
+    m_uris = uris;
+    m_reporter = reporter;
+    m_capacity = capacity;
+}
+
+FileNodeScanner::~FileNodeScanner()
+{
+    //the scanner thread might be waiting for a free slot.
+    m_mutex.lock();
+    m_capacity = INT_MAX;
+    m_not_full.wakeAll();
+    m_mutex.unlock();
+    m_future.waitForFinished();
+}
+
+void FileNodeScanner::start()
+{
+    m_future = QtConcurrent::run(FileOperationManager::getInstance()->scannerThreadPool(), [=](){
+        for (auto uri : m_uris) {
+            FileNode *node = new FileNode(uri, nullptr, m_reporter);
+            m_root_nodes<<node;
+            scanRecursively(node);
+        }
+
+        if (m_reporter) {
+            qDebug()<<"file node scanner:"<<m_node_count<<"nodes,"<<m_reporter->treeMemory()<<"bytes allocated";
+        }
+
+        m_mutex.lock();
+        m_finished = true;
+        m_not_empty.wakeAll();
+        m_mutex.unlock();
+    });
+}
+
+void FileNodeScanner::scanRecursively(FileNode *node)
+{
+    enqueue(node);
+
+    if (m_reporter && m_reporter->isOperationCancelled())
+        return;
+
+    node->findChildren();
+    for (auto child : node->children()) {
+        scanRecursively(child);
+    }
+}
+
+void FileNodeScanner::enqueue(FileNode *node)
+{
+    QMutexLocker locker(&m_mutex);
+    while (m_queue.count() >= m_capacity) {
+        m_not_full.wait(&m_mutex);
+    }
+    m_queue.enqueue(node);
+    m_node_count++;
+    m_total_size += node->transferSize();
+    m_not_empty.wakeOne();
+}
+
+FileNode *FileNodeScanner::take()
+{
+    QMutexLocker locker(&m_mutex);
+    while (m_queue.isEmpty() && !m_finished) {
+        m_not_empty.wait(&m_mutex);
+    }
+    if (m_queue.isEmpty())
+        return nullptr;
+
+    auto node = m_queue.dequeue();
+    m_not_full.wakeOne();
+    return node;
+}
+
+const QList<FileNode *> FileNodeScanner::waitForFinished()
+{
+    //the rest nodes are queued without limitation.
+    m_mutex.lock();
+    m_capacity = INT_MAX;
+    m_not_full.wakeAll();
+    m_mutex.unlock();
+
+    m_future.waitForFinished();
+    return m_root_nodes;
+}
+
+goffset FileNodeScanner::totalSize()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_total_size;
+}
+
+bool FileNodeScanner::isFinished()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_finished;
+}
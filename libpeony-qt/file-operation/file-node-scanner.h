@@ -0,0 +1,110 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2019, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#ifndef FILENODESCANNER_H
+#define FILENODESCANNER_H
+
+#include <QStringList>
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QFuture>
+#include <gio/gio.h>
+
+namespace Peony {
+
+class FileNode;
+class FileNodeReporter;
+
+/*!
+ * \brief The FileNodeScanner class
+ * <br>
+ * FileNodeScanner builds the FileNode trees of the source uris in a thread of
+ * FileOperationManager::scannerThreadPool(), and queues every node once it is
+ * found. A file operation takes the nodes from the queue and handles them while
+ * the rest of trees are still being scanned, so that the first file is handled
+ * immediately rather than after the whole trees are prepared.
+ * </br>
+ * <br>
+ * The nodes are queued in pre-order, a folder is always taken before its children.
+ * The queue is bounded, the scanner waits when the operation falls behind.
+ * </br>
+ * \note
+ * The trees are owned by the operation, it should delete the root nodes after the
+ * scanner finished. Do not access the children of a node before that.
+ */
+class FileNodeScanner
+{
+public:
+    explicit FileNodeScanner(const QStringList &uris, FileNodeReporter *reporter, int capacity = 4096);
+    ~FileNodeScanner();
+
+    void start();
+
+    /*!
+     * \brief take
+     * \return the next node, it blocks until a node is found. nullptr if
+     * all the nodes have been taken.
+     */
+    FileNode *take();
+
+    /*!
+     * \brief waitForFinished
+     * \return the root nodes in the order of uris.
+     * \details
+     * The queue is no longer bounded once it is called, the nodes which have
+     * not been taken can still be taken after it returned.
+     */
+    const QList<FileNode *> waitForFinished();
+
+    /*!
+     * \brief totalSize
+     * \return the transfer size of the nodes found so far, it grows while scanning.
+     */
+    goffset totalSize();
+    bool isFinished();
+
+private:
+    void scanRecursively(FileNode *node);
+    void enqueue(FileNode *node);
+
+private:
+    QStringList m_uris;
+    FileNodeReporter *m_reporter = nullptr;
+    int m_capacity;
+
+    QList<FileNode *> m_root_nodes;
+    QFuture<void> m_future;
+
+    QQueue<FileNode *> m_queue;
+    goffset m_total_size = 0;
+    qint64 m_node_count = 0;
+    bool m_finished = false;
+    QMutex m_mutex;
+    QWaitCondition m_not_empty;
+    QWaitCondition m_not_full;
+};
+
+}
+
+#endif // FILENODESCANNER_H
@@ -20,118 +20,536 @@
  *
  */
 
+
 #include "file-node.h"
-#include "file-enumerator.h"
-#include "file-info.h"
+#include "file-copy-engine.h"
 #include "file-node-reporter.h"
 
+#include <QHash>
+#include <QMutex>
+#include <QVarLengthArray>
+#include <QDebug>
+
+#include <string.h>
+
+#define CHILDREN_QUERY_ATTRIBUTES G_FILE_ATTRIBUTE_STANDARD_NAME "," \
+                                  G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
+                                  G_FILE_ATTRIBUTE_STANDARD_SIZE "," \
+                                  G_FILE_ATTRIBUTE_STANDARD_ALLOCATED_SIZE
+
+#define NODES_PER_BLOCK 1024
+#define STRING_BLOCK_SIZE (64*1024)
+
+namespace Peony {
+
+/*!
+ * \brief The FileNodeArena class
+ * <br>
+ * FileNodeArena allocates the nodes and names of a tree in blocks, they are never
+ * moved or freed until the root node is deleted. So the nodes can be linked by raw
+ * pointers, and the operation thread can access the nodes which have been found
+ * while the scanner thread is still allocating new ones.
+ * </br>
+ * <br>
+ * The dest names and uris are rarely different from the source ones, they are kept
+ * in hashes only when they are set. These members are only accessed by the operation
+ * thread.
+ * </br>
+ */
+class FileNodeArena
+{
+public:
+    explicit FileNodeArena(const QByteArray &rootUri, FileNodeReporter *reporter);
+    ~FileNodeArena();
+
+    FileNode *newNode(const char *name, const char *uriName, bool isFolder, goffset size, FileNode *parent);
+    const char *copyString(const char *str, int length);
+    void adopt(FileNode *node) {m_adopted_nodes<<node;}
+
+    const QByteArray overriddenUri(FileNode *node);
+    void setOverriddenUri(FileNode *node, const QByteArray &uri);
+
+    goffset allocatedSize(FileNode *node);
+    void setAllocatedSize(FileNode *node, goffset size);
+
+    const QByteArray destName(FileNode *node);
+    const QString resolveDestUri(FileNode *node, const QString &destRootDir);
+
+    qint64 memoryUsage();
+    qint64 nodeCount() {return m_node_count;}
+
+private:
+    void allocated(qint64 bytes);
+
+public:
+    QByteArray m_root_uri;
+    FileNodeReporter *m_reporter = nullptr;
+
+    QHash<FileNode *, QString> m_dest_names;
+    QHash<FileNode *, QString> m_dest_uris;
+
+    //the last resolved dest uri, its parent path is kept in buffer for the siblings.
+    QString m_dest_root;
+    QByteArray m_dest_buffer;
+    FileNode *m_dest_dir = nullptr;
+    int m_dest_dir_length = 0;
+    FileNode *m_last_resolved_node = nullptr;
+    QString m_last_resolved_uri;
+
+private:
+    QList<char *> m_node_blocks;
+    int m_node_block_used = NODES_PER_BLOCK;
+    QList<char *> m_string_blocks;
+    int m_string_block_used = STRING_BLOCK_SIZE;
+    QList<FileNode *> m_adopted_nodes;
+    qint64 m_node_count = 0;
+    qint64 m_memory_usage = 0;
+
+    //the uris which could not be built from the parent uri, such as the uris
+    //of some virtual file systems. they are written by the scanner thread.
+    QMutex m_mutex;
+    QHash<FileNode *, QByteArray> m_uris;
+    //the allocated sizes of sparse files, they are written by the scanner thread too.
+    QHash<FileNode *, goffset> m_allocated_sizes;
+};
+
+}
+
 using namespace Peony;
 
-FileNode::FileNode(QString uri, FileNode *parent, FileNodeReporter *reporter)
+FileNodeArena::FileNodeArena(const QByteArray &rootUri, FileNodeReporter *reporter)
 {
-    m_uri = uri;
-    m_parent = parent;
+    m_root_uri = rootUri;
     m_reporter = reporter;
-    GFile *file = g_file_new_for_uri(uri.toUtf8().constData());
+}
+
+FileNodeArena::~FileNodeArena()
+{
+    for (auto node : m_adopted_nodes) {
+        delete node;
+    }
+    //the nodes in blocks own nothing, so they are not destructed one by one.
+    for (auto block : m_node_blocks) {
+        delete[] block;
+    }
+    for (auto block : m_string_blocks) {
+        delete[] block;
+    }
+}
+
+void FileNodeArena::allocated(qint64 bytes)
+{
+    m_memory_usage += bytes;
+    if (m_reporter) {
+        m_reporter->sendTreeMemoryAllocated(bytes);
+    }
+}
+
+FileNode *FileNodeArena::newNode(const char *name, const char *uriName, bool isFolder, goffset size, FileNode *parent)
+{
+    if (m_node_block_used == NODES_PER_BLOCK) {
+        m_node_blocks<<new char[sizeof(FileNode)*NODES_PER_BLOCK];
+        m_node_block_used = 0;
+        allocated(sizeof(FileNode)*NODES_PER_BLOCK);
+    }
+    void *memory = m_node_blocks.last() + sizeof(FileNode)*m_node_block_used;
+    m_node_block_used++;
+    m_node_count++;
+
+    auto node = new (memory) FileNode(name, uriName, isFolder, size, parent);
+    node->m_arena = this;
+    return node;
+}
+
+const char *FileNodeArena::copyString(const char *str, int length)
+{
+    //a very long name takes a block of its own.
+    if (length + 1 > STRING_BLOCK_SIZE) {
+        char *block = new char[length + 1];
+        memcpy(block, str, size_t(length));
+        block[length] = '\0';
+        m_string_blocks.prepend(block);
+        allocated(length + 1);
+        return block;
+    }
+
+    if (m_string_block_used + length + 1 > STRING_BLOCK_SIZE) {
+        m_string_blocks<<new char[STRING_BLOCK_SIZE];
+        m_string_block_used = 0;
+        allocated(STRING_BLOCK_SIZE);
+    }
+    char *string = m_string_blocks.last() + m_string_block_used;
+    memcpy(string, str, size_t(length));
+    string[length] = '\0';
+    m_string_block_used += length + 1;
+    return string;
+}
+
+const QByteArray FileNodeArena::overriddenUri(FileNode *node)
+{
+    QMutexLocker locker(&m_mutex);
+    return m_uris.value(node);
+}
+
+void FileNodeArena::setOverriddenUri(FileNode *node, const QByteArray &uri)
+{
+    QMutexLocker locker(&m_mutex);
+    m_uris.insert(node, uri);
+}
+
+goffset FileNodeArena::allocatedSize(FileNode *node)
+{
+    QMutexLocker locker(&m_mutex);
+    return m_allocated_sizes.value(node, node->m_size);
+}
+
+void FileNodeArena::setAllocatedSize(FileNode *node, goffset size)
+{
+    QMutexLocker locker(&m_mutex);
+    m_allocated_sizes.insert(node, size);
+}
+
+const QByteArray FileNodeArena::destName(FileNode *node)
+{
+    auto it = m_dest_names.constFind(node);
+    if (it != m_dest_names.constEnd())
+        return it.value().toUtf8();
+    return QByteArray::fromRawData(node->m_name, int(strlen(node->m_name)));
+}
+
+const QString FileNodeArena::resolveDestUri(FileNode *node, const QString &destRootDir)
+{
+    if (destRootDir != m_dest_root) {
+        m_dest_root = destRootDir;
+        m_dest_dir = nullptr;
+    }
+
+    //the siblings share the path of their parent in buffer.
+    auto parent = node->m_parent;
+    if (!parent || parent != m_dest_dir) {
+        QVarLengthArray<FileNode *, 32> ancestors;
+        for (auto n = parent; n; n = n->m_parent) {
+            ancestors.append(n);
+        }
+        m_dest_buffer = destRootDir.toUtf8();
+        for (int i = ancestors.count() - 1; i >= 0; i--) {
+            m_dest_buffer.append('/');
+            m_dest_buffer.append(destName(ancestors.at(i)));
+        }
+        m_dest_dir = parent;
+        m_dest_dir_length = m_dest_buffer.length();
+    } else {
+        m_dest_buffer.truncate(m_dest_dir_length);
+    }
+    m_dest_buffer.append('/');
+    m_dest_buffer.append(destName(node));
+
+    m_last_resolved_node = node;
+    m_last_resolved_uri = QString::fromUtf8(m_dest_buffer);
+    return m_last_resolved_uri;
+}
+
+qint64 FileNodeArena::memoryUsage()
+{
+    qint64 usage = m_memory_usage + qint64(sizeof(FileNodeArena));
+    //roughly, a hash node and the string data.
+    for (auto name : m_dest_names) {
+        usage += 32 + name.size()*2;
+    }
+    for (auto uri : m_dest_uris) {
+        usage += 32 + uri.size()*2;
+    }
+    QMutexLocker locker(&m_mutex);
+    for (auto uri : m_uris) {
+        usage += 32 + uri.size();
+    }
+    usage += 32*m_allocated_sizes.count();
+    return usage;
+}
+
+FileNode::FileNode(QString uri, FileNode *parent, FileNodeReporter *reporter)
+{
+    auto rawUri = uri.toUtf8();
+    GFile *file = g_file_new_for_uri(rawUri.constData());
     char *basename = g_file_get_basename(file);
-    m_basename = basename;
-    m_dest_basename = basename;
+    QByteArray name = basename? basename: "";
     g_free(basename);
 
+    m_parent = parent;
+    if (m_parent) {
+        m_arena = m_parent->m_arena;
+        m_arena->adopt(this);
+        m_name = m_arena->copyString(name.constData(), name.length());
+        //keep the raw uri, the node is not created by enumeration.
+        m_uri_name = "";
+        m_uri_overridden = true;
+        m_arena->setOverriddenUri(this, rawUri);
+        m_parent->appendChild(this);
+    } else {
+        m_arena = new FileNodeArena(rawUri, reporter);
+        m_name = m_arena->copyString(name.constData(), name.length());
+        m_uri_name = m_name;
+    }
+
     //use G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS to avoid unnecessary recursion.
-    m_is_folder = g_file_query_file_type(file, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, nullptr) == G_FILE_TYPE_DIRECTORY;
     GFileInfo *info = g_file_query_info(file,
-                                        G_FILE_ATTRIBUTE_STANDARD_SIZE,
-                                        G_FILE_QUERY_INFO_NONE,
+                                        G_FILE_ATTRIBUTE_STANDARD_TYPE "," G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+                                        G_FILE_ATTRIBUTE_STANDARD_ALLOCATED_SIZE,
+                                        G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
                                         nullptr,
                                         nullptr);
     g_object_unref(file);
-    m_size = g_file_info_get_size(info);
-    g_object_unref(info);
+    if (info) {
+        m_is_folder = g_file_info_get_file_type(info) == G_FILE_TYPE_DIRECTORY;
+        m_size = g_file_info_get_size(info);
+        if (!m_is_folder)
+            setAllocatedSize(goffset(g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_STANDARD_ALLOCATED_SIZE)));
+        g_object_unref(info);
+    }
 
-    if (m_reporter) {
-        m_reporter->sendNodeFound(m_uri, m_size);
+    if (reporter) {
+        reporter->sendNodeFound(uri, reporter->isTransferSizeReported()? transferSize(): m_size);
     }
+}
 
-    m_children = new QList<FileNode*>();
+FileNode::FileNode(const char *name, const char *uriName, bool isFolder, goffset size, FileNode *parent)
+{
+    m_name = name;
+    m_uri_name = uriName;
+    m_is_folder = isFolder;
+    m_size = size;
+    m_parent = parent;
 }
 
 FileNode::~FileNode() {
-    qDebug()<<"delete node:"<<m_uri;
-    m_uri.clear();
-    m_basename.clear();
-    m_dest_uri.clear();
+    //the root node owns the whole tree.
+    if (!m_parent) {
+        delete m_arena;
+    }
+}
 
-    for (auto child : *m_children) {
-        delete child;
+void FileNode::appendChild(FileNode *child)
+{
+    if (!m_first_child) {
+        m_first_child = child;
+        return;
+    }
+    auto last = m_first_child;
+    while (last->m_next_sibling) {
+        last = last->m_next_sibling;
     }
-    m_children->clear();
-    delete m_children;
+    last->m_next_sibling = child;
 }
 
 void FileNode::findChildrenRecursively()
 {
-    if (m_reporter) {
-        if (m_reporter->isOperationCancelled())
+    findChildren();
+    for (auto child : children()) {
+        child->findChildrenRecursively();
+    }
+}
+
+void FileNode::findChildren()
+{
+    auto reporter = m_arena->m_reporter;
+    if (reporter) {
+        if (reporter->isOperationCancelled())
             return;
     }
 
     if (!m_is_folder)
         return;
-    else {
-        FileEnumerator e;
-        e.setEnumerateDirectory(m_uri);
-        e.enumerateSync();
-        auto infos = e.getChildren();
-        for (auto info: infos) {
-            FileNode *node = new FileNode(info->uri(), this, m_reporter);
-            m_children->append(node);
-            node->findChildrenRecursively();
+
+    auto parentUri = uri().toUtf8();
+    //the child uri is usually the parent uri with an escaped name.
+    int prefixLength = parentUri.endsWith('/')? parentUri.length(): parentUri.length() + 1;
+
+    GFile *file = g_file_new_for_uri(parentUri.constData());
+    GFileEnumerator *enumerator = g_file_enumerate_children(file,
+                                                            CHILDREN_QUERY_ATTRIBUTES,
+                                                            G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                                            nullptr,
+                                                            nullptr);
+    if (!enumerator) {
+        g_object_unref(file);
+        return;
+    }
+
+    FileNode *last = m_first_child;
+    while (last && last->m_next_sibling) {
+        last = last->m_next_sibling;
+    }
+
+    GFileInfo *info = nullptr;
+    while ((info = g_file_enumerator_next_file(enumerator, nullptr, nullptr))) {
+        const char *rawName = g_file_info_get_name(info);
+        GFile *child = g_file_get_child(file, rawName);
+        char *childUri = g_file_get_uri(child);
+        g_object_unref(child);
+
+        const char *name = m_arena->copyString(rawName, int(strlen(rawName)));
+        const char *uriName = "";
+        bool overridden = true;
+        if (strncmp(childUri, parentUri.constData(), size_t(parentUri.length())) == 0
+                && (parentUri.endsWith('/') || childUri[parentUri.length()] == '/')) {
+            const char *segment = childUri + prefixLength;
+            uriName = strcmp(segment, rawName) == 0? name: m_arena->copyString(segment, int(strlen(segment)));
+            overridden = false;
+        }
+
+        FileNode *node = m_arena->newNode(name,
+                                          uriName,
+                                          g_file_info_get_file_type(info) == G_FILE_TYPE_DIRECTORY,
+                                          g_file_info_get_size(info),
+                                          this);
+        if (overridden) {
+            node->m_uri_overridden = true;
+            m_arena->setOverriddenUri(node, childUri);
         }
+        if (!node->m_is_folder)
+            node->setAllocatedSize(goffset(g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_STANDARD_ALLOCATED_SIZE)));
+
+        if (last) {
+            last->m_next_sibling = node;
+        } else {
+            m_first_child = node;
+        }
+        last = node;
+
+        if (reporter) {
+            reporter->sendNodeFound(QString::fromUtf8(childUri),
+                                    reporter->isTransferSizeReported()? node->transferSize(): node->m_size);
+        }
+
+        g_free(childUri);
+        g_object_unref(info);
+
+        if (reporter && reporter->isOperationCancelled())
+            break;
     }
+
+    g_file_enumerator_close(enumerator, nullptr, nullptr);
+    g_object_unref(enumerator);
+    g_object_unref(file);
+}
+
+goffset FileNode::transferSize()
+{
+    return m_is_sparse? m_arena->allocatedSize(this): m_size;
+}
+
+void FileNode::setAllocatedSize(goffset size)
+{
+    if (FileCopyEngine::transferSize(m_size, size) == m_size)
+        return;
+    m_arena->setAllocatedSize(this, size);
+    m_is_sparse = true;
 }
 
 void FileNode::computeTotalSize(goffset *offset)
 {
-    *offset += m_size;
-    for (auto child : *m_children) {
+    *offset += transferSize();
+    for (auto child : children()) {
         child->computeTotalSize(offset);
     }
 }
 
-QString FileNode::getRelativePath()
+QString FileNode::uri()
 {
-    FileNode *n = this;
-    while (n->m_parent) {
-        n = n->m_parent;
+    QVarLengthArray<FileNode *, 32> path;
+    QByteArray uri;
+    for (auto node = this; ; node = node->m_parent) {
+        if (!node->m_parent) {
+            uri = m_arena->m_root_uri;
+            break;
+        }
+        if (node->m_uri_overridden) {
+            uri = m_arena->overriddenUri(node);
+            break;
+        }
+        path.append(node);
     }
-    GFile *root_file = g_file_new_for_uri(n->m_uri.toUtf8().constData());
-    GFile *root_file_parent = g_file_get_parent(root_file);
-    GFile *this_file = g_file_new_for_uri(m_uri.toUtf8().constData());
 
-    char *relative_path = g_file_get_relative_path(root_file_parent, this_file);
-    QString relativePath = relative_path;
+    for (int i = path.count() - 1; i >= 0; i--) {
+        if (!uri.endsWith('/'))
+            uri.append('/');
+        uri.append(path.at(i)->m_uri_name);
+    }
+    return QString::fromUtf8(uri);
+}
+
+QString FileNode::destUri()
+{
+    auto it = m_arena->m_dest_uris.constFind(this);
+    if (it != m_arena->m_dest_uris.constEnd())
+        return it.value();
 
-    g_free(relative_path);
-    g_object_unref(root_file);
-    g_object_unref(root_file_parent);
-    g_object_unref(this_file);
+    if (!m_dest_resolved)
+        return nullptr;
 
-    return relativePath;
+    if (m_arena->m_last_resolved_node == this)
+        return m_arena->m_last_resolved_uri;
+    return m_arena->resolveDestUri(this, m_arena->m_dest_root);
 }
 
-const QString FileNode::resoveDestFileUri(const QString &destRootDir)
+void FileNode::setDestUri(QString uri)
+{
+    //the dest uri which was just resolved is rebuilt when it is required,
+    //rather than kept by every node.
+    if (m_arena->m_last_resolved_node == this && m_arena->m_last_resolved_uri == uri) {
+        m_dest_resolved = true;
+        m_arena->m_dest_uris.remove(this);
+        return;
+    }
+    m_dest_resolved = false;
+    m_arena->m_dest_uris.insert(this, uri);
+}
+
+const QString FileNode::destBaseName()
 {
-    QStringList relativePathList;
-    relativePathList.prepend(m_dest_basename);
-    FileNode *parent = this->parent();
-    while (parent) {
-        relativePathList.prepend(parent->m_dest_basename);
-        parent = parent->parent();
+    return QString::fromUtf8(m_arena->destName(this));
+}
+
+void FileNode::setDestFileName(const QString &name)
+{
+    if (name == baseName()) {
+        m_arena->m_dest_names.remove(this);
+    } else {
+        m_arena->m_dest_names.insert(this, name);
     }
-    QString relativePath = relativePathList.join("/");
-    if (relativePath.endsWith("/")) {
-        relativePath.chop(1);
+    //the cached paths might contain the old name.
+    m_arena->m_dest_dir = nullptr;
+    m_arena->m_last_resolved_node = nullptr;
+}
+
+qint64 FileNode::treeMemoryUsage()
+{
+    return m_arena->memoryUsage();
+}
+
+qint64 FileNode::treeNodeCount()
+{
+    //the root node is not allocated by arena.
+    return m_arena->nodeCount() + 1;
+}
+
+QString FileNode::getRelativePath()
+{
+    QVarLengthArray<FileNode *, 32> path;
+    for (auto node = this; node; node = node->m_parent) {
+        path.append(node);
+    }
+
+    QByteArray relativePath;
+    for (int i = path.count() - 1; i >= 0; i--) {
+        relativePath.append(path.at(i)->m_name);
+        if (i > 0)
+            relativePath.append('/');
     }
-    return destRootDir + "/" + relativePath;
+    return QString::fromUtf8(relativePath);
+}
+
+const QString FileNode::resoveDestFileUri(const QString &destRootDir)
+{
+    return m_arena->resolveDestUri(this, destRootDir);
 }
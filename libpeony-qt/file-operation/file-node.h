@@ -33,6 +33,7 @@
 namespace Peony {
 
 class FileNodeReporter;
+class FileNodeArena;
 
 /*!
  * \brief The FileNode class
@@ -54,11 +55,18 @@ class FileNodeReporter;
  * of file node enumeration. Actually, a FileNode instance always be with a FileNodeReproter
  * instance at its initialization.
  * </br>
+ * <br>
+ * A tree might contain millions of nodes, so the nodes are kept compact. The children of a
+ * root node are allocated in blocks by a FileNodeArena owned by the root, and a node only
+ * holds its name. The uris are reconstructed from the names when they are required, and
+ * deleting the root node releases the whole tree at once.
+ * </br>
  * \see FileNodeReporter.
  */
 class PEONYCORESHARED_EXPORT FileNode
 {
     friend class FileNodeReporter;
+    friend class FileNodeArena;
 public:
     enum State {
         Unhandled,
@@ -68,24 +76,90 @@ public:
         Invalid
     };
 
+    /*!
+     * \brief The Children class
+     * <br>
+     * A lightweight range of the children linked by the node, it is used as
+     * for (auto child : node->children()) {...}.
+     * </br>
+     */
+    class Children
+    {
+    public:
+        class const_iterator
+        {
+        public:
+            explicit const_iterator(FileNode *node) : m_node(node) {}
+            FileNode *operator*() const {return m_node;}
+            const_iterator &operator++() {m_node = m_node->m_next_sibling; return *this;}
+            bool operator!=(const const_iterator &other) const {return m_node != other.m_node;}
+        private:
+            FileNode *m_node;
+        };
+
+        explicit Children(FileNode *first) : m_first(first) {}
+        const_iterator begin() const {return const_iterator(m_first);}
+        const_iterator end() const {return const_iterator(nullptr);}
+        bool isEmpty() const {return !m_first;}
+
+    private:
+        FileNode *m_first;
+    };
+
+    /*!
+     * \brief FileNode
+     * \param uri
+     * \param parent, the node should be a root node if it is nullptr. Otherwise
+     * the node will be owned by the tree of parent.
+     * \param reporter
+     */
     FileNode(QString uri, FileNode* parent, FileNodeReporter *reporter = nullptr);
     ~FileNode();
 
     //FIXME: do i need add cancel function?
     void findChildrenRecursively();
+    /*!
+     * \brief findChildren
+     * \details
+     * Enumerate the direct children of this folder. The type and size of
+     * children are queried by the enumeration itself, rather than one query
+     * per child.
+     */
+    void findChildren();
+    /*!
+     * \brief computeTotalSize
+     * \param offset, the transfer sizes of the tree are added to it.
+     */
     void computeTotalSize(goffset *offset);
 
-    QString uri() {return m_uri;}
-    QString destUri() {return m_dest_uri;}
-    State state() {return m_state;}
-    FileOperation::ResponseType responseType() {return m_err_response;}
-    QString baseName() {return m_basename;}
-    const QString destBaseName() {return m_dest_basename;}
+    QString uri();
+    QString destUri();
+    State state() {return State(m_state);}
+    FileOperation::ResponseType responseType() {return FileOperation::ResponseType(m_err_response);}
+    QString baseName() {return QString::fromUtf8(m_name);}
+    const QString destBaseName();
     FileNode *parent() {return m_parent;}
-    QList<FileNode*> *children() {return m_children;}
+    Children children() {return Children(m_first_child);}
     qint64 size() {return m_size;}
+    /*!
+     * \brief transferSize
+     * \return the bytes to be copied for this file. It is the allocated size for
+     * a sparse file, whose holes are not copied, and the size for others.
+     */
+    goffset transferSize();
     bool isFolder() {return m_is_folder;}
 
+    /*!
+     * \brief treeMemoryUsage
+     * \return the bytes allocated by the tree of this node.
+     */
+    qint64 treeMemoryUsage();
+    /*!
+     * \brief treeNodeCount
+     * \return the count of nodes in the tree of this node.
+     */
+    qint64 treeNodeCount();
+
     /*!
      * \brief getRelativePath
      * \return
@@ -111,7 +185,7 @@ public:
      * </br>
      * \see setState().
      */
-    void setDestUri(QString uri) {m_dest_uri = uri;}
+    void setDestUri(QString uri);
     /*!
      * \brief setState
      * \param state
@@ -126,7 +200,7 @@ public:
      * or deleted. That will guide the application how to roll back if the operation
      * was cancelled.
      */
-    void setState(State state) {m_state = state;}
+    void setState(State state) {m_state = quint8(state);}
     /*!
      * \brief setErrorResponse
      * \param type
@@ -136,26 +210,45 @@ public:
      * will guide them how to do that.
      * For example, if a g_file move operation is ignored, it will not be cleared when clearing.
      */
-    void setErrorResponse(FileOperation::ResponseType type) {m_err_response = type;}
+    void setErrorResponse(FileOperation::ResponseType type) {m_err_response = quint8(type);}
 
-    void setDestFileName(const QString &name) {m_dest_basename = name;}
+    void setDestFileName(const QString &name);
+    /*!
+     * \brief resoveDestFileUri
+     * \param destRootDir
+     * \return the uri of this file in destRootDir, with the dest file names of the
+     * parents and itself.
+     * \note
+     * The path is built in a buffer shared by the tree. The dest uris of a tree must be
+     * resolved in the same thread, it is the operation thread usually.
+     */
     const QString resoveDestFileUri(const QString &destRootDir);
 
 private:
-    QString m_uri = nullptr;
-    QString m_basename = nullptr;
-    QString m_dest_basename = nullptr;
+    FileNode(const char *name, const char *uriName, bool isFolder, goffset size, FileNode *parent);
 
-    goffset m_size = 0;
-    bool m_is_folder = false;
+    void appendChild(FileNode *child);
+    void setAllocatedSize(goffset size);
+
+    FileNodeArena *m_arena = nullptr;
     FileNode *m_parent = nullptr;
-    QList<FileNode*> *m_children = nullptr;
+    FileNode *m_first_child = nullptr;
+    FileNode *m_next_sibling = nullptr;
+
+    //the name and the escaped last segment of uri, they are kept by arena.
+    const char *m_name = nullptr;
+    const char *m_uri_name = nullptr;
 
-    QString m_dest_uri = nullptr;
-    State m_state = Unhandled;
-    FileOperation::ResponseType m_err_response = FileOperation::Other;
+    goffset m_size = 0;
 
-    FileNodeReporter *m_reporter = nullptr;
+    //these fields might be written by the operation thread while the scanner
+    //thread is linking the children, do not pack them into bit fields.
+    bool m_is_folder = false;
+    bool m_uri_overridden = false;
+    bool m_dest_resolved = false;
+    bool m_is_sparse = false;
+    quint8 m_state = Unhandled;
+    quint8 m_err_response = FileOperation::Other;
 };
 
 }
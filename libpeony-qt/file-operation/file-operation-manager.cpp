@@ -41,6 +41,12 @@
 #include "file-operation-error-dialog.h"
 #include "file-operation-progress-wizard.h"
 
+#include <gio/gunixmounts.h>
+
+//throttle the light operations, such as deleting, on one device.
+#define MAX_LIGHT_OPERATIONS_PER_DEVICE 2
+#define MAX_RUNNING_OPERATIONS 16
+
 using namespace Peony;
 
 static FileOperationManager *global_instance = nullptr;
@@ -49,9 +55,13 @@ FileOperationManager::FileOperationManager(QObject *parent) : QObject(parent)
 {
     qRegisterMetaType<Peony::GErrorWrapperPtr>("Peony::GErrorWrapperPtr");
     qRegisterMetaType<Peony::GErrorWrapperPtr>("Peony::GErrorWrapperPtr&");
+    qRegisterMetaType<Peony::FileOperationProgress>("Peony::FileOperationProgress");
     m_thread_pool = new QThreadPool(this);
-    //Imitating queue execution.
-    m_thread_pool->setMaxThreadCount(1);
+    //the operations are queued by scheduleOperations().
+    m_thread_pool->setMaxThreadCount(MAX_RUNNING_OPERATIONS);
+    //one scanner for each running operation at most.
+    m_scanner_thread_pool = new QThreadPool(this);
+    m_scanner_thread_pool->setMaxThreadCount(MAX_RUNNING_OPERATIONS);
 }
 
 FileOperationManager::~FileOperationManager()
@@ -101,13 +111,10 @@ void FileOperationManager::startOperation(FileOperation *operation, bool addToHi
 
     auto operationInfo = operation->getOperationInfo();
 
-    bool allowParallel = false;
-
     auto opType = operationInfo->operationType();
     switch (opType) {
     case FileOperationInfo::Trash:
     case FileOperationInfo::Delete: {
-        allowParallel = true;
         auto operationSrcs = operationInfo->sources();
         auto currentOps = m_thread_pool->children();
         QList<FileOperation *> ops;
@@ -137,19 +144,23 @@ void FileOperationManager::startOperation(FileOperation *operation, bool addToHi
     wizard->setAttribute(Qt::WA_DeleteOnClose);
     wizard->connect(operation, &FileOperation::operationRequestShowWizard, wizard, &FileOperationProgressWizard::delayShow);
     wizard->connect(operation, &FileOperation::operationRequestShowWizard, wizard, &FileOperationProgressWizard::switchToPreparedPage);
-    wizard->connect(operation, &FileOperation::operationPreparedOne, wizard, &FileOperationProgressWizard::onElementFoundOne);
     wizard->connect(operation, &FileOperation::operationPrepared, wizard, &FileOperationProgressWizard::onElementFoundAll);
-    wizard->connect(operation, &FileOperation::operationProgressedOne, wizard, &FileOperationProgressWizard::onFileOperationProgressedOne);
-    wizard->connect(operation, &FileOperation::FileProgressCallback, wizard, &FileOperationProgressWizard::updateProgress);
     wizard->connect(operation, &FileOperation::operationProgressed, wizard, &FileOperationProgressWizard::onFileOperationProgressedAll);
-    wizard->connect(operation, &FileOperation::operationAfterProgressedOne, wizard, &FileOperationProgressWizard::onElementClearOne);
     wizard->connect(operation, &FileOperation::operationAfterProgressed, wizard, &FileOperationProgressWizard::switchToRollbackPage);
     wizard->connect(operation, &FileOperation::operationStartRollbacked, wizard, &FileOperationProgressWizard::switchToRollbackPage);
-    wizard->connect(operation, &FileOperation::operationRollbackedOne, wizard, &FileOperationProgressWizard::onFileRollbacked);
+    //the per-file progress is only delivered by snapshots.
+    wizard->connect(operation, &FileOperation::progressSnapshotUpdated, wizard, &FileOperationProgressWizard::onProgressSnapshotUpdated);
     wizard->connect(operation, &FileOperation::operationFinished, wizard, &FileOperationProgressWizard::deleteLater);
 
-    connect(wizard, &Peony::FileOperationProgressWizard::cancelled,
-            operation, &Peony::FileOperation::cancel);
+    connect(wizard, &Peony::FileOperationProgressWizard::cancelled, this, [=](){
+        cancelOperation(operation);
+    });
+    connect(wizard, &Peony::FileOperationProgressWizard::pauseRequest, this, [=](){
+        pauseOperation(operation);
+    });
+    connect(wizard, &Peony::FileOperationProgressWizard::resumeRequest, this, [=](){
+        resumeOperation(operation);
+    });
 
     operation->connect(operation, &FileOperation::errored, [=](){
         operation->setHasError(true);
@@ -165,7 +176,8 @@ void FileOperationManager::startOperation(FileOperation *operation, bool addToHi
             return ;
         }
 
-        if (addToHistory) {
+        //a cancelled operation has been rolled back, or never started.
+        if (addToHistory && !operation->isCancelled()) {
             auto info = operation->getOperationInfo();
             if (!info)
                 return;
@@ -178,26 +190,7 @@ void FileOperationManager::startOperation(FileOperation *operation, bool addToHi
         }
     });
 
-    if (!allowParallel) {
-        if (m_thread_pool->activeThreadCount() > 0) {
-            QMessageBox::warning(nullptr,
-                                 tr("File Operation is Busy"),
-                                 tr("There have been one or more file"
-                                    "operation(s) executing before. Your"
-                                    "operation will wait for executing"
-                                    "until it/them done."));
-        }
-        operation->setParent(m_thread_pool);
-        m_thread_pool->start(operation);
-    } else {
-        QtConcurrent::run([=]{
-            operation->setParent(m_thread_pool);
-            operation->setAutoDelete(false);
-            operation->run();
-            operation->setParent(nullptr);
-            operation->deleteLater();
-        });
-    }
+    enqueueOperation(operation);
 }
 
 void FileOperationManager::startUndoOrRedo(std::shared_ptr<FileOperationInfo> info)
@@ -309,3 +302,200 @@ QVariant FileOperationManager::handleError(const QString &srcUri,
     FileOperationErrorDialog dlg;
     return dlg.handleError(srcUri, destUri, err, critical);
 }
+
+//the devices are found in the mount table rather than by stat(), so that the
+//sources on a stalled network mount do not block the ui before the operation
+//starts, and a target which doesn't exist yet has a device too.
+static QString uri_device(const QString &uri, GList *mounts)
+{
+    QUrl url(uri);
+    //remote files are on the same device if they are on the same server.
+    if (url.scheme() != "file")
+        return url.scheme() + "://" + url.host();
+
+    GFile *file = g_file_new_for_uri(uri.toUtf8().constData());
+    char *path = g_file_get_path(file);
+    g_object_unref(file);
+    if (!path)
+        return nullptr;
+
+    //the mount whose path is the longest prefix of path.
+    QByteArray filePath = path;
+    g_free(path);
+    QString device;
+    int matchedLength = -1;
+    for (GList *l = mounts; l; l = l->next) {
+        auto mount = static_cast<GUnixMountEntry *>(l->data);
+        QByteArray mountPath = g_unix_mount_get_mount_path(mount);
+        if (mountPath.length() <= matchedLength)
+            continue;
+        bool contains = mountPath == "/" || filePath == mountPath || filePath.startsWith(mountPath + "/");
+        if (!contains)
+            continue;
+        matchedLength = mountPath.length();
+        //mounts of a block device share it, virtual file systems do not.
+        QString devicePath = g_unix_mount_get_device_path(mount);
+        device = devicePath.startsWith("/")? devicePath: mountPath;
+    }
+    return device;
+}
+
+void FileOperationManager::enqueueOperation(FileOperation *operation)
+{
+    ScheduledOperation scheduled;
+    scheduled.operation = operation;
+
+    //the sources are usually in a few folders, look up each folder once.
+    auto info = operation->getOperationInfo();
+    QSet<QString> folderUris;
+    for (auto uri : info->sources()) {
+        int index = uri.lastIndexOf('/');
+        bool isTopLevel = index <= 0 || uri.at(index - 1) == '/';
+        folderUris<<(isTopLevel? uri: uri.left(index));
+    }
+    if (!info->target().isEmpty())
+        folderUris<<info->target();
+
+    GList *mounts = g_unix_mounts_get(nullptr);
+    for (auto uri : folderUris) {
+        auto device = uri_device(uri, mounts);
+        if (!device.isEmpty() && !scheduled.devices.contains(device))
+            scheduled.devices<<device;
+    }
+    g_list_free_full(mounts, GDestroyNotify(g_unix_mount_free));
+
+    auto type = info->operationType();
+    scheduled.exclusive = type == FileOperationInfo::Copy || type == FileOperationInfo::Move;
+
+    //the queued operations keep the application running as well.
+    operation->setParent(m_thread_pool);
+    operation->setAutoDelete(false);
+
+    m_queued_operations<<scheduled;
+    Q_EMIT operationQueueChanged();
+    scheduleOperations();
+}
+
+bool FileOperationManager::canStartOperation(const ScheduledOperation &scheduled)
+{
+    for (auto device : scheduled.devices) {
+        int lightCount = 0;
+        for (auto running : m_running_operations) {
+            if (!running.devices.contains(device))
+                continue;
+            if (running.exclusive && scheduled.exclusive)
+                return false;
+            if (!running.exclusive)
+                lightCount++;
+        }
+        if (!scheduled.exclusive && lightCount >= MAX_LIGHT_OPERATIONS_PER_DEVICE)
+            return false;
+    }
+    return true;
+}
+
+void FileOperationManager::scheduleOperations()
+{
+    bool changed = false;
+    for (int i = 0; i < m_queued_operations.count(); ) {
+        auto scheduled = m_queued_operations.at(i);
+        if (scheduled.paused || !canStartOperation(scheduled)) {
+            i++;
+            continue;
+        }
+
+        m_queued_operations.removeAt(i);
+        m_running_operations<<scheduled;
+        changed = true;
+
+        auto operation = scheduled.operation;
+        QtConcurrent::run(m_thread_pool, [=](){
+            operation->run();
+            QMetaObject::invokeMethod(this, [=](){
+                onOperationDone(operation);
+            }, Qt::QueuedConnection);
+        });
+    }
+
+    if (changed)
+        Q_EMIT operationQueueChanged();
+}
+
+void FileOperationManager::onOperationDone(FileOperation *operation)
+{
+    for (int i = 0; i < m_running_operations.count(); i++) {
+        if (m_running_operations.at(i).operation == operation) {
+            m_running_operations.removeAt(i);
+            break;
+        }
+    }
+    operation->setParent(nullptr);
+    operation->deleteLater();
+
+    scheduleOperations();
+}
+
+const QList<FileOperation *> FileOperationManager::queuedOperations()
+{
+    QList<FileOperation *> operations;
+    for (auto scheduled : m_queued_operations) {
+        operations<<scheduled.operation;
+    }
+    return operations;
+}
+
+void FileOperationManager::pauseOperation(FileOperation *operation)
+{
+    for (auto &scheduled : m_queued_operations) {
+        if (scheduled.operation == operation) {
+            scheduled.paused = true;
+            Q_EMIT operationQueueChanged();
+            return;
+        }
+    }
+    operation->pause();
+}
+
+void FileOperationManager::resumeOperation(FileOperation *operation)
+{
+    for (auto &scheduled : m_queued_operations) {
+        if (scheduled.operation == operation) {
+            scheduled.paused = false;
+            Q_EMIT operationQueueChanged();
+            scheduleOperations();
+            return;
+        }
+    }
+    operation->resume();
+}
+
+void FileOperationManager::cancelOperation(FileOperation *operation)
+{
+    operation->cancel();
+    for (int i = 0; i < m_queued_operations.count(); i++) {
+        if (m_queued_operations.at(i).operation == operation) {
+            //run() returns at once for a cancelled operation without finishing it,
+            //so finish it here to release its wizard and restore the quit policy.
+            m_queued_operations.removeAt(i);
+            Q_EMIT operationQueueChanged();
+            Q_EMIT operation->operationFinished();
+            operation->setParent(nullptr);
+            operation->deleteLater();
+            scheduleOperations();
+            return;
+        }
+    }
+}
+
+void FileOperationManager::moveQueuedOperation(FileOperation *operation, int index)
+{
+    for (int i = 0; i < m_queued_operations.count(); i++) {
+        if (m_queued_operations.at(i).operation == operation) {
+            auto scheduled = m_queued_operations.takeAt(i);
+            index = qBound(0, index, m_queued_operations.count());
+            m_queued_operations.insert(index, scheduled);
+            Q_EMIT operationQueueChanged();
+            return;
+        }
+    }
+}
@@ -47,8 +47,10 @@ class FileOperationInfo;
  * And in peony-qt, it is similar to peony. But there are higher level
  * api to manage these 'managers' in peony-qt.
  * Not only the undo/redo stacks' management. FileOperationManager
- * only allows up to one file operation instace to run at same times,
- * this means the operations will be queue executed.
+ * schedules the operations by the devices they read and write. Copying
+ * and moving operations on the same device are queue executed, others
+ * run concurrently. The queued operations can be paused, resumed and
+ * reordered.
  * FileOperationManager will provide the operation-ui and error-handler-ui
  * which are implement as defaut in peony-qt's operation frameworks.
  * \note
@@ -67,8 +69,27 @@ public:
     static FileOperationManager *getInstance();
     void close();
 
+    /*!
+     * \brief queuedOperations
+     * \return the operations waiting for their devices, the front ones
+     * will be started at first.
+     */
+    const QList<FileOperation *> queuedOperations();
+
+    /*!
+     * \brief scannerThreadPool
+     * \return the pool in which FileNodeScanner scans the source trees of the
+     * running operations.
+     * \details
+     * A scanner holds its thread for the whole operation, even while the operation
+     * is paused. The pool has a thread for every running operation, so that the
+     * scanners neither starve each other nor the users of the global thread pool.
+     */
+    QThreadPool *scannerThreadPool() {return m_scanner_thread_pool;}
+
 Q_SIGNALS:
     void closed();
+    void operationQueueChanged();
 
 public Q_SLOTS:
     void startOperation(FileOperation *operation, bool addToHistory = true);
@@ -85,14 +106,57 @@ public Q_SLOTS:
 
     QVariant handleError(const QString &srcUri, const QString &destUri, const GErrorWrapperPtr &err, bool critical);
 
+    /*!
+     * \brief pauseOperation
+     * \param operation
+     * \details
+     * A queued operation will not be started until it is resumed, the operations
+     * behind it might be started earlier. A running operation stops before it
+     * handles the next file.
+     */
+    void pauseOperation(FileOperation *operation);
+    void resumeOperation(FileOperation *operation);
+    /*!
+     * \brief cancelOperation
+     * \param operation
+     * \details
+     * A queued operation is removed from the queue and finished without
+     * running, it is not added to the history.
+     */
+    void cancelOperation(FileOperation *operation);
+    /*!
+     * \brief moveQueuedOperation
+     * \param operation
+     * \param index, the new position of operation in queue.
+     */
+    void moveQueuedOperation(FileOperation *operation, int index);
+
 private:
     explicit FileOperationManager(QObject *parent = nullptr);
     ~FileOperationManager();
 
+    struct ScheduledOperation {
+        FileOperation *operation = nullptr;
+        //the mounts of the sources and the target, the server for remote files.
+        QStringList devices;
+        //copy and move are bound by the device bandwidth.
+        bool exclusive = false;
+        bool paused = false;
+    };
+
+    void enqueueOperation(FileOperation *operation);
+    bool canStartOperation(const ScheduledOperation &scheduled);
+    void scheduleOperations();
+    void onOperationDone(FileOperation *operation);
+
+    QList<ScheduledOperation> m_queued_operations;
+    QList<ScheduledOperation> m_running_operations;
+
     QStack<std::shared_ptr<FileOperationInfo>> m_undo_stack;
     QStack<std::shared_ptr<FileOperationInfo>> m_redo_stack;
 
     QThreadPool *m_thread_pool;
+    QThreadPool *m_scanner_thread_pool;
     bool m_is_current_operation_errored = false;
 };
 
@@ -100,6 +164,7 @@ class FileOperationInfo : public QObject
 {
     Q_OBJECT
     friend class FileOperationManager;
+    friend class FileTrashOperation;
 public:
     enum Type {
         Invalid,
@@ -36,6 +36,7 @@
 #include <QSystemTrayIcon>
 
 #include <QTimer>
+#include <QTime>
 
 #include <gio/gio.h>
 
@@ -53,12 +54,23 @@ FileOperationProgressWizard::FileOperationProgressWizard(QWidget *parent) : QWiz
 
     setWindowFlags(windowFlags());
     setWindowTitle(tr("File Manager"));
-    //only show cancel button at bottom-right of wizard
+    //only show pause and cancel buttons at bottom-right of wizard
     QList<WizardButton> layout;
-    layout<<Stretch<<CustomButton1;
+    layout<<Stretch<<CustomButton2<<CustomButton1;
     setButtonText(CustomButton1, tr("&Cancel"));
-    connect(this, &QWizard::customButtonClicked, [=](){
-        this->cancelled();
+    setButtonText(CustomButton2, tr("&Pause"));
+    connect(this, &QWizard::customButtonClicked, [=](int which){
+        if (which == CustomButton1) {
+            this->cancelled();
+            return;
+        }
+        m_paused = !m_paused;
+        setButtonText(CustomButton2, m_paused? tr("&Resume"): tr("&Pause"));
+        if (m_paused) {
+            Q_EMIT this->pauseRequest();
+        } else {
+            Q_EMIT this->resumeRequest();
+        }
     });
     setButtonLayout(layout);
 
@@ -254,6 +266,62 @@ void FileOperationProgressWizard::updateProgress(const QString &srcUri, const QS
     m_second_page->m_progress_bar->setValue(int(progress*100));
 }
 
+void FileOperationProgressWizard::onProgressSnapshotUpdated(const FileOperationProgress &progress)
+{
+    m_total_count = int(progress.foundCount);
+    m_total_size = progress.foundSize;
+    m_current_count = int(progress.doneCount);
+    m_current_size = progress.doneSize;
+
+    auto page = currentPage();
+    if (page == m_first_page) {
+        char *format_size = g_format_size(quint64(m_total_size));
+        m_first_page->m_src_line->setText(progress.srcUri);
+        m_first_page->m_state_line->setText(tr("%1 files, %2").arg(m_total_count).arg(format_size));
+        g_free(format_size);
+    } else if (page == m_second_page) {
+        char *current_format_size = g_format_size(quint64(m_current_size));
+        char *total_format_size = g_format_size(quint64(m_total_size));
+        QString state = tr("%1 done, %2 total, %3 of %4.").
+                arg(current_format_size).arg(total_format_size)
+                .arg(m_current_count).arg(m_total_count);
+        g_free(current_format_size);
+        g_free(total_format_size);
+
+        if (progress.throughput > 0) {
+            char *speed_format_size = g_format_size(quint64(progress.throughput));
+            state += " " + tr("%1/s").arg(speed_format_size);
+            g_free(speed_format_size);
+        }
+        if (progress.remainingTime >= 0) {
+            auto remaining = QTime(0, 0).addSecs(int(qMin(progress.remainingTime, qint64(24*3600 - 1))));
+            state += " " + tr("About %1 left.").arg(remaining.toString("hh:mm:ss"));
+        }
+        m_second_page->m_state_line->setText(state);
+        m_second_page->m_src_line->setText(progress.srcUri);
+        m_second_page->m_dest_line->setText(progress.destUri);
+
+        char *memory_format_size = g_format_size(quint64(progress.treeMemory));
+        m_second_page->m_memory_line->setText(memory_format_size);
+        g_free(memory_format_size);
+
+        if (m_total_size > 0)
+            m_second_page->m_progress_bar->setValue(int(m_current_size*100.0/m_total_size));
+    } else if (page == m_third_page) {
+        m_third_page->m_file_deleted_count = int(progress.clearedCount);
+        m_third_page->m_src_line->setText(tr("clearing: %1, %2 of %3").arg(progress.srcUri).
+                                          arg(m_third_page->m_file_deleted_count).
+                                          arg(m_total_count));
+        if (m_total_count > 0)
+            m_third_page->m_progress_bar->setValue(int(m_third_page->m_file_deleted_count*100.0/m_total_count));
+    } else if (page == m_last_page) {
+        //use the done count as total count of files need rollback.
+        m_last_page->m_current_count = int(progress.rollbackedCount);
+        if (m_current_count > 0)
+            m_last_page->m_progress_bar->setValue(int(m_last_page->m_current_count*100.0/m_current_count));
+    }
+}
+
 //FileOperationPreparePage
 FileOperationPreparePage::FileOperationPreparePage(QWidget *parent) : QWizardPage (parent)
 {
@@ -299,8 +367,10 @@ FileOperationProgressPage::FileOperationProgressPage(QWidget *parent) : QWizardP
 
     m_src_line = new QLabel("null", this);
     m_dest_line = new QLabel("null", this);
+    m_memory_line = new QLabel("0 bytes", this);
     moreDetailsLayout->addRow(tr("From:"), m_src_line);
     moreDetailsLayout->addRow(tr("To:"), m_dest_line);
+    moreDetailsLayout->addRow(tr("Memory:"), m_memory_line);
 
     QWidget *detailsWidget = new QWidget(this);
     detailsWidget->setLayout(moreDetailsLayout);
@@ -26,6 +26,7 @@
 #include <QWizard>
 
 #include "peony-core_global.h"
+#include "file-operation.h"
 
 class QLabel;
 class QProgressBar;
@@ -72,6 +73,8 @@ public:
 
 Q_SIGNALS:
     void cancelled();
+    void pauseRequest();
+    void resumeRequest();
 
 public Q_SLOTS:
     virtual void delayShow();
@@ -92,11 +95,20 @@ public Q_SLOTS:
 
     virtual void updateProgress(const QString &srcUri, const QString &destUri, quint64 current, quint64 total);
 
+    /*!
+     * \brief onProgressSnapshotUpdated
+     * \param progress
+     * \details
+     * Update the current page with the snapshot of operation. It replaces the
+     * per-file slots above, which are kept for the custom operations.
+     */
+    virtual void onProgressSnapshotUpdated(const Peony::FileOperationProgress &progress);
+
 protected:
     void closeEvent(QCloseEvent *e) override;
 
     qint64 m_total_size = 0;
-    int m_current_size = 0;
+    qint64 m_current_size = 0;
     int m_total_count = 0;
     int m_current_count = 1;
 
@@ -108,6 +120,7 @@ protected:
 private:
     QSystemTrayIcon *m_tray_icon = nullptr;
     QTimer *m_delayer;
+    bool m_paused = false;
 };
 
 class PEONYCORESHARED_EXPORT FileOperationPreparePage : public QWizardPage
@@ -142,6 +155,7 @@ private:
     QGridLayout *m_layout = nullptr;
     QLabel *m_src_line = nullptr;
     QLabel *m_dest_line = nullptr;
+    QLabel *m_memory_line = nullptr;
     QLabel *m_state_line = nullptr;
     QProgressBar *m_progress_bar = nullptr;
 };
@@ -22,12 +22,73 @@
 
 #include "file-operation.h"
 
+#include <QTimer>
+
+//20 times per second is smooth enough for progress bars.
+#define PROGRESS_SNAPSHOT_INTERVAL 50
+#define THROUGHPUT_SMOOTHING 0.1
+
 using namespace Peony;
 
 FileOperation::FileOperation(QObject *parent) : QObject (parent)
 {
     m_cancellable_wrapper = wrapGCancellable(g_cancellable_new());
     setAutoDelete(true);
+
+    //the per-file signals are only accumulated in the operation thread,
+    //they are published as snapshots by m_snapshot_timer.
+    connect(this, &FileOperation::operationPreparedOne, this, [=](const QString &uri, const qint64 &size){
+        Q_UNUSED(uri)
+        m_found_count++;
+        m_found_size += size;
+        m_progress_generation++;
+    }, Qt::DirectConnection);
+    connect(this, &FileOperation::operationProgressedOne, this, [=](const QString &uri, const QString &destUri, const qint64 &size){
+        m_progress_mutex.lock();
+        m_progress_src_uri = uri;
+        m_progress_dest_uri = destUri;
+        m_progress_mutex.unlock();
+        m_done_count++;
+        m_done_size += size;
+        m_progress_generation++;
+    }, Qt::DirectConnection);
+    connect(this, &FileOperation::FileProgressCallback, this, [=](const QString &srcUri, const QString &destUri,
+            const qint64 &current, const qint64 &total){
+        Q_UNUSED(total)
+        m_progress_mutex.lock();
+        m_progress_src_uri = srcUri;
+        m_progress_dest_uri = destUri;
+        m_progress_mutex.unlock();
+        m_copied_size.store(current);
+        m_progress_generation++;
+    }, Qt::DirectConnection);
+    connect(this, &FileOperation::operationAfterProgressedOne, this, [=](const QString &uri){
+        m_progress_mutex.lock();
+        m_progress_src_uri = uri;
+        m_progress_mutex.unlock();
+        m_cleared_count++;
+        m_progress_generation++;
+    }, Qt::DirectConnection);
+    connect(this, &FileOperation::operationRollbackedOne, this, [=](){
+        m_rollbacked_count++;
+        m_progress_generation++;
+    }, Qt::DirectConnection);
+    connect(this, &FileOperation::operationTreeMemoryChanged, this, [=](const qint64 &bytes){
+        m_tree_memory.store(bytes);
+        m_progress_generation++;
+    }, Qt::DirectConnection);
+
+    m_snapshot_timer = new QTimer(this);
+    m_snapshot_timer->setInterval(PROGRESS_SNAPSHOT_INTERVAL);
+    connect(m_snapshot_timer, &QTimer::timeout, this, &FileOperation::publishProgressSnapshot);
+    connect(this, &FileOperation::operationStarted, this, [=](){
+        m_elapsed_timer.start();
+        m_snapshot_timer->start();
+    });
+    connect(this, &FileOperation::operationFinished, this, [=](){
+        m_snapshot_timer->stop();
+        publishProgressSnapshot();
+    });
 }
 
 FileOperation::~FileOperation()
@@ -43,5 +104,103 @@ void FileOperation::run()
 void FileOperation::cancel()
 {
     g_cancellable_cancel(m_cancellable_wrapper.get()->get());
+    m_pause_mutex.lock();
     m_is_cancelled = true;
+    m_resume_condition.wakeAll();
+    m_pause_mutex.unlock();
+}
+
+bool FileOperation::isCancelled()
+{
+    m_pause_mutex.lock();
+    while (m_is_paused && !m_is_cancelled)
+        m_resume_condition.wait(&m_pause_mutex);
+    bool cancelled = m_is_cancelled;
+    m_pause_mutex.unlock();
+    return cancelled;
+}
+
+void FileOperation::pause()
+{
+    m_pause_mutex.lock();
+    m_is_paused = true;
+    m_pause_mutex.unlock();
+}
+
+void FileOperation::resume()
+{
+    m_pause_mutex.lock();
+    m_is_paused = false;
+    m_resume_condition.wakeAll();
+    m_pause_mutex.unlock();
+}
+
+bool FileOperation::isPaused()
+{
+    QMutexLocker locker(&m_pause_mutex);
+    return m_is_paused;
+}
+
+void FileOperation::reportPreparedFiles(qint64 count, qint64 size)
+{
+    m_found_count += count;
+    m_found_size += size;
+    m_progress_generation++;
+}
+
+void FileOperation::reportClearedFiles(const QString &lastUri, qint64 count)
+{
+    m_progress_mutex.lock();
+    m_progress_src_uri = lastUri;
+    m_progress_mutex.unlock();
+    m_cleared_count += count;
+    m_progress_generation++;
+}
+
+const FileOperationProgress FileOperation::progressSnapshot()
+{
+    FileOperationProgress progress;
+    progress.foundCount = m_found_count.load();
+    progress.foundSize = m_found_size.load();
+    progress.doneCount = m_done_count.load();
+    //the files copied by progress callback might not be done yet.
+    progress.doneSize = qMax(m_done_size.load(), m_copied_size.load());
+    progress.clearedCount = m_cleared_count.load();
+    progress.rollbackedCount = m_rollbacked_count.load();
+    progress.treeMemory = m_tree_memory.load();
+
+    m_progress_mutex.lock();
+    progress.srcUri = m_progress_src_uri;
+    progress.destUri = m_progress_dest_uri;
+    m_progress_mutex.unlock();
+    return progress;
+}
+
+void FileOperation::publishProgressSnapshot()
+{
+    int generation = m_progress_generation.load();
+    if (generation == m_published_generation)
+        return;
+    m_published_generation = generation;
+
+    auto progress = progressSnapshot();
+
+    qint64 now = m_elapsed_timer.elapsed();
+    if (now > m_last_snapshot_time) {
+        double speed = (progress.doneSize - m_last_snapshot_size)*1000.0/(now - m_last_snapshot_time);
+        if (m_throughput == 0) {
+            m_throughput = speed;
+        } else {
+            m_throughput = m_throughput*(1 - THROUGHPUT_SMOOTHING) + speed*THROUGHPUT_SMOOTHING;
+        }
+        m_last_snapshot_time = now;
+        m_last_snapshot_size = progress.doneSize;
+    }
+
+    progress.throughput = qint64(m_throughput);
+    if (progress.throughput > 0 && progress.foundSize >= progress.doneSize) {
+        progress.remainingTime = (progress.foundSize - progress.doneSize)/progress.throughput;
+    }
+
+    Q_EMIT progressSnapshotUpdated(progress);
 }
@@ -31,12 +31,45 @@
 
 #include <QMetaType>
 #include <QHash>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
 
 #include "peony-core_global.h"
 
+class QTimer;
+
 namespace Peony {
 
 class FileOperationInfo;
+
+/*!
+ * \brief The FileOperationProgress struct
+ * <br>
+ * A snapshot of the progress of a file operation, it is published by
+ * FileOperation::progressSnapshotUpdated() at a fixed rate.
+ * </br>
+ */
+struct FileOperationProgress
+{
+    qint64 foundCount = 0;
+    qint64 foundSize = 0;
+    qint64 doneCount = 0;
+    qint64 doneSize = 0;
+    qint64 clearedCount = 0;
+    qint64 rollbackedCount = 0;
+
+    QString srcUri;
+    QString destUri;
+
+    //bytes per second.
+    qint64 throughput = 0;
+    //seconds, -1 if it is unknown yet.
+    qint64 remainingTime = -1;
+
+    qint64 treeMemory = 0;
+};
 /*!
  * \brief The FileOperation class
  * <br>
@@ -110,7 +143,26 @@ public:
     void setShouldReversible(bool reversible = true) {m_reversible = reversible;}
     virtual bool reversible() {return m_reversible;}
 
-    bool isCancelled() {return m_is_cancelled;}
+    /*!
+     * \brief isCancelled
+     * \details
+     * The operations check it before handling each file. If the operation
+     * is paused, it blocks until the operation is resumed or cancelled.
+     * \note
+     * Do not call it in main thread.
+     */
+    bool isCancelled();
+
+    /*!
+     * \brief pause
+     * \details
+     * Pause a running operation. It stops before handling its next file, the
+     * file being handled is finished at first.
+     * \see isCancelled(), resume().
+     */
+    void pause();
+    void resume();
+    bool isPaused();
 
 Q_SIGNALS:
     /*!
@@ -183,6 +235,14 @@ Q_SIGNALS:
      * The total size should also be accumulated.
      */
     void operationPreparedOne(const QString &srcUri, const qint64 &size);
+    /*!
+     * \brief operationTreeMemoryChanged
+     * \param bytes
+     * \details
+     * This signal is sent when the FileNode trees of the operation allocated
+     * more memory, so that it could be shown in the progress ui.
+     */
+    void operationTreeMemoryChanged(const qint64 &bytes);
     /*!
      * \brief operationPrepared
      * <br>
@@ -275,21 +335,83 @@ Q_SIGNALS:
      */
     void operationFinished();
 
+    /*!
+     * \brief progressSnapshotUpdated
+     * \param progress
+     * <br>
+     * The per-file signals above are accumulated by FileOperation, and the snapshot
+     * is published in the thread of the operation object 20 times per second at most.
+     * A progress ui should connect this signal rather than the per-file ones, which
+     * might be emitted hundreds of thousands times.
+     * </br>
+     */
+    void progressSnapshotUpdated(const Peony::FileOperationProgress &progress);
+
 public Q_SLOTS:
     virtual void cancel();
 
+public:
+    /*!
+     * \brief progressSnapshot
+     * \return the current progress without throughput and remaining time,
+     * it can be called in any thread.
+     */
+    const FileOperationProgress progressSnapshot();
+
 protected:
     GCancellableWrapperPtr getCancellable(){return m_cancellable_wrapper;}
 
+    /*!
+     * \brief reportPreparedFiles
+     * \param count
+     * \param size
+     * \details
+     * Accumulate the progress of files handled in batches, instead of sending
+     * operationPreparedOne() and operationAfterProgressedOne() for each file.
+     * They can be called in any thread.
+     */
+    void reportPreparedFiles(qint64 count, qint64 size);
+    void reportClearedFiles(const QString &lastUri, qint64 count);
+
+private:
+    void publishProgressSnapshot();
+
 private:
     GCancellableWrapperPtr m_cancellable_wrapper = nullptr;
     bool m_is_cancelled = false;
     bool m_reversible = false;
     bool m_has_error = false;
+
+    bool m_is_paused = false;
+    QMutex m_pause_mutex;
+    QWaitCondition m_resume_condition;
+
+    //written by the operation thread.
+    QAtomicInteger<qint64> m_found_count = 0;
+    QAtomicInteger<qint64> m_found_size = 0;
+    QAtomicInteger<qint64> m_done_count = 0;
+    QAtomicInteger<qint64> m_done_size = 0;
+    QAtomicInteger<qint64> m_copied_size = 0;
+    QAtomicInteger<qint64> m_cleared_count = 0;
+    QAtomicInteger<qint64> m_rollbacked_count = 0;
+    QAtomicInteger<qint64> m_tree_memory = 0;
+    QAtomicInt m_progress_generation = 0;
+    QMutex m_progress_mutex;
+    QString m_progress_src_uri;
+    QString m_progress_dest_uri;
+
+    //used by the publisher in the thread of operation object.
+    QTimer *m_snapshot_timer = nullptr;
+    int m_published_generation = 0;
+    QElapsedTimer m_elapsed_timer;
+    qint64 m_last_snapshot_time = 0;
+    qint64 m_last_snapshot_size = 0;
+    double m_throughput = 0;
 };
 
 }
 
 Q_DECLARE_METATYPE(Peony::FileOperation::ResponseType)
+Q_DECLARE_METATYPE(Peony::FileOperationProgress)
 
 #endif // FILEOPERATION_H
@@ -9,14 +9,19 @@ HEADERS += \
     $$PWD/file-move-operation.h \
     $$PWD/file-node.h \
     $$PWD/file-node-reporter.h \
+    $$PWD/file-node-scanner.h \
     $$PWD/file-operation-progress-wizard.h \
     $$PWD/file-operation-error-handler.h \
     $$PWD/file-operation-error-dialog.h \
     $$PWD/file-copy-operation.h \
+    $$PWD/file-copy-engine.h \
+    $$PWD/file-delete-engine.h \
+    $$PWD/file-trash-engine.h \
     $$PWD/file-operation-manager.h \
     $$PWD/file-delete-operation.h \
     $$PWD/file-link-operation.h \
     $$PWD/file-trash-operation.h \
+    $$PWD/file-empty-trash-operation.h \
     $$PWD/file-untrash-operation.h \
     $$PWD/file-rename-operation.h \
     $$PWD/file-count-operation.h \
@@ -27,13 +32,18 @@ SOURCES += \
     $$PWD/file-move-operation.cpp \
     $$PWD/file-node.cpp \
     $$PWD/file-node-reporter.cpp \
+    $$PWD/file-node-scanner.cpp \
     $$PWD/file-operation-progress-wizard.cpp \
     $$PWD/file-operation-error-dialog.cpp \
     $$PWD/file-copy-operation.cpp \
+    $$PWD/file-copy-engine.cpp \
+    $$PWD/file-delete-engine.cpp \
+    $$PWD/file-trash-engine.cpp \
     $$PWD/file-operation-manager.cpp \
     $$PWD/file-delete-operation.cpp \
     $$PWD/file-link-operation.cpp \
     $$PWD/file-trash-operation.cpp \
+    $$PWD/file-empty-trash-operation.cpp \
     $$PWD/file-untrash-operation.cpp \
     $$PWD/file-rename-operation.cpp \
     $$PWD/file-count-operation.cpp \
@@ -0,0 +1,586 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2019, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#include "file-trash-engine.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QSaveFile>
+
+#include <gio/gunixmounts.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <dirent.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#ifndef RENAME_NOREPLACE
+#define RENAME_NOREPLACE (1 << 0)
+#endif
+
+using namespace Peony;
+
+static gboolean set_error_from_errno(GError **error, int errsv)
+{
+    g_set_error_literal(error, G_IO_ERROR, g_io_error_from_errno(errsv), g_strerror(errsv));
+    return FALSE;
+}
+
+static QByteArray join_path(const QByteArray &dir, const QByteArray &name)
+{
+    return dir.endsWith('/')? dir + name: dir + "/" + name;
+}
+
+static QByteArray base_name(const QByteArray &path)
+{
+    return path.mid(path.lastIndexOf('/') + 1);
+}
+
+/*!
+ * \brief trash_item_name
+ * \return the name of a trashed file in trash:///, escaped the same way as
+ * trash_item_escape_name() of gvfs. the items of home trash are named by their
+ * names, with a '`' prepended to a leading '\'. the items of other trash
+ * directories are named by their full paths, where '`' is escaped as "``",
+ * '\' as "`\", and '/' is replaced by '\'.
+ */
+static QByteArray trash_item_name(const QByteArray &trashedPath, bool inHomeTrash)
+{
+    if (inHomeTrash) {
+        auto name = base_name(trashedPath);
+        return name.startsWith('\\')? "`" + name: name;
+    }
+
+    QByteArray name;
+    name.reserve(trashedPath.size() + 8);
+    for (char c : trashedPath) {
+        if (c == '`' || c == '\\') {
+            name += '`';
+            name += c;
+        } else if (c == '/') {
+            name += '\\';
+        } else {
+            name += c;
+        }
+    }
+    return name;
+}
+
+static bool write_all(int fd, const QByteArray &data)
+{
+    const char *p = data.constData();
+    ssize_t size = data.size();
+    while (size > 0) {
+        ssize_t written = write(fd, p, size_t(size));
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        p += written;
+        size -= written;
+    }
+    return true;
+}
+
+static int rename_noreplace(const char *path, int destDirFd, const char *name)
+{
+#ifdef SYS_renameat2
+    int ret = int(syscall(SYS_renameat2, AT_FDCWD, path, destDirFd, name, RENAME_NOREPLACE));
+    if (ret == 0 || (errno != ENOSYS && errno != EINVAL))
+        return ret;
+#endif
+    //the name has been reserved by the trash info, a plain rename is fine.
+    return renameat(AT_FDCWD, path, destDirFd, name);
+}
+
+/*!
+ * \brief find_topdir
+ * \return the mount point of the file system of path.
+ */
+static QByteArray find_topdir(const QByteArray &path, dev_t dev)
+{
+    QByteArray dir = path;
+    while (dir != "/") {
+        int index = dir.lastIndexOf('/');
+        QByteArray parent = index > 0? dir.left(index): "/";
+        struct stat st;
+        if (stat(parent.constData(), &st) != 0 || st.st_dev != dev)
+            break;
+        dir = parent;
+    }
+    return dir;
+}
+
+static bool is_system_internal_mount(const QByteArray &topdir)
+{
+    GUnixMountEntry *mount = g_unix_mount_at(topdir.constData(), nullptr);
+    //not a mount point, it is not a trash topdir either.
+    if (!mount)
+        return true;
+    bool internal = g_unix_mount_is_system_internal(mount);
+    g_unix_mount_free(mount);
+    return internal;
+}
+
+static qint64 directory_size(int parentFd, const char *name)
+{
+    int fd = openat(parentFd, name, O_RDONLY|O_DIRECTORY|O_NOFOLLOW|O_CLOEXEC);
+    if (fd < 0)
+        return 0;
+    DIR *dir = fdopendir(fd);
+    if (!dir) {
+        close(fd);
+        return 0;
+    }
+
+    qint64 size = 0;
+    struct dirent *entry = nullptr;
+    while ((entry = readdir(dir))) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+            continue;
+        struct stat st;
+        if (fstatat(fd, entry->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+            continue;
+        size += st.st_size;
+        if (S_ISDIR(st.st_mode))
+            size += directory_size(fd, entry->d_name);
+    }
+    closedir(dir);
+    return size;
+}
+
+struct DirectorySize
+{
+    qint64 size;
+    qint64 mtime;
+};
+
+/*!
+ * \brief read_directory_sizes
+ * \return the entries of directorysizes cache, which has lines of
+ * "size mtime percent-encoded-name", keyed by the names.
+ */
+static QHash<QByteArray, DirectorySize> read_directory_sizes(const QByteArray &trashPath)
+{
+    QHash<QByteArray, DirectorySize> sizes;
+    QFile cache(QString::fromLocal8Bit(trashPath + "/directorysizes"));
+    if (!cache.open(QIODevice::ReadOnly))
+        return sizes;
+
+    for (auto line : cache.readAll().split('\n')) {
+        auto fields = line.split(' ');
+        if (fields.count() != 3)
+            continue;
+        char *name = g_uri_unescape_string(fields.at(2).constData(), nullptr);
+        if (!name)
+            continue;
+        sizes.insert(name, DirectorySize{fields.at(0).toLongLong(), fields.at(1).toLongLong()});
+        g_free(name);
+    }
+    return sizes;
+}
+
+static void write_directory_sizes(const QByteArray &trashPath, const QHash<QByteArray, DirectorySize> &sizes)
+{
+    QByteArray lines;
+    for (auto it = sizes.constBegin(); it != sizes.constEnd(); it++) {
+        char *escapedName = g_uri_escape_string(it.key().constData(), nullptr, FALSE);
+        lines += QByteArray::number(it.value().size) + " " + QByteArray::number(it.value().mtime) + " " + escapedName + "\n";
+        g_free(escapedName);
+    }
+
+    //the cache is replaced atomically as the spec requires.
+    QSaveFile file(QString::fromLocal8Bit(trashPath + "/directorysizes"));
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+    file.write(lines);
+    file.commit();
+}
+
+FileTrashEngine::FileTrashEngine()
+{
+    m_home_trash_path = join_path(g_get_user_data_dir(), "Trash");
+}
+
+FileTrashEngine::~FileTrashEngine()
+{
+    flush();
+    for (auto dir : m_directories) {
+        if (!dir)
+            continue;
+        close(dir->filesFd);
+        close(dir->infoFd);
+        delete dir;
+    }
+}
+
+FileTrashEngine::TrashDirectory *FileTrashEngine::openTrashDirectory(const QByteArray &path, const QByteArray &topdir)
+{
+    auto filesPath = path + "/files";
+    auto infoPath = path + "/info";
+    g_mkdir_with_parents(filesPath.constData(), 0700);
+    g_mkdir_with_parents(infoPath.constData(), 0700);
+
+    int filesFd = open(filesPath.constData(), O_RDONLY|O_DIRECTORY|O_NOFOLLOW|O_CLOEXEC);
+    int infoFd = open(infoPath.constData(), O_RDONLY|O_DIRECTORY|O_NOFOLLOW|O_CLOEXEC);
+    if (filesFd < 0 || infoFd < 0) {
+        if (filesFd >= 0)
+            close(filesFd);
+        if (infoFd >= 0)
+            close(infoFd);
+        return nullptr;
+    }
+
+    auto dir = new TrashDirectory;
+    dir->path = path;
+    dir->topdir = topdir;
+    dir->filesFd = filesFd;
+    dir->infoFd = infoFd;
+    return dir;
+}
+
+FileTrashEngine::TrashDirectory *FileTrashEngine::trashDirectory(dev_t dev, const QByteArray &path)
+{
+    auto it = m_directories.constFind(dev);
+    if (it != m_directories.constEnd())
+        return it.value();
+
+    TrashDirectory *dir = nullptr;
+    struct stat st;
+    g_mkdir_with_parents(m_home_trash_path.constData(), 0700);
+    if (stat(m_home_trash_path.constData(), &st) == 0 && st.st_dev == dev) {
+        dir = openTrashDirectory(m_home_trash_path, QByteArray());
+    } else {
+        auto topdir = find_topdir(path, dev);
+        //the files of system mounts, such as /tmp and /boot, are trashed by gio, as
+        //their trash directories are not listed in trash:/// or trashDirectories().
+        if (!is_system_internal_mount(topdir)) {
+            auto uid = QByteArray::number(getuid());
+            //the shared $topdir/.Trash must be a sticky directory rather than a link.
+            auto sharedTrash = join_path(topdir, ".Trash");
+            if (lstat(sharedTrash.constData(), &st) == 0 && S_ISDIR(st.st_mode) && (st.st_mode & S_ISVTX)) {
+                dir = openTrashDirectory(sharedTrash + "/" + uid, topdir);
+            }
+            if (!dir) {
+                dir = openTrashDirectory(join_path(topdir, ".Trash-" + uid), topdir);
+            }
+        }
+    }
+
+    //make sure the files can be renamed into it.
+    if (dir && (fstat(dir->filesFd, &st) != 0 || st.st_dev != dev)) {
+        close(dir->filesFd);
+        close(dir->infoFd);
+        delete dir;
+        dir = nullptr;
+    }
+
+    m_directories.insert(dev, dir);
+    return dir;
+}
+
+gboolean FileTrashEngine::trash(GFile *file, QString *trashUri, GCancellable *cancellable, GError **error)
+{
+    if (g_cancellable_set_error_if_cancelled(cancellable, error))
+        return FALSE;
+
+    TrashDirectory *dir = nullptr;
+    QByteArray path;
+    bool isDir = false;
+    char *rawPath = g_file_is_native(file)? g_file_get_path(file): nullptr;
+    if (rawPath) {
+        path = rawPath;
+        g_free(rawPath);
+        struct stat st;
+        if (lstat(path.constData(), &st) != 0)
+            return set_error_from_errno(error, errno);
+        isDir = S_ISDIR(st.st_mode);
+        dir = trashDirectory(st.st_dev, path);
+    }
+
+    //let gio report the errors of trashing the trash itself.
+    if (dir && path != dir->path && !path.startsWith(dir->path + "/")) {
+        bool fallback = false;
+        auto result = trashNatively(dir, path, isDir, trashUri, &fallback, error);
+        if (!fallback)
+            return result;
+    }
+
+    if (!g_file_trash(file, cancellable, error))
+        return FALSE;
+
+    //it is the name in home trash usually.
+    if (trashUri) {
+        char *basename = g_file_get_basename(file);
+        auto childName = trash_item_name(basename, true);
+        GFile *trash = g_file_new_for_uri("trash:///");
+        GFile *child = g_file_get_child(trash, childName.constData());
+        char *uri = g_file_get_uri(child);
+        *trashUri = uri;
+        g_free(uri);
+        g_object_unref(child);
+        g_object_unref(trash);
+        g_free(basename);
+    }
+    return TRUE;
+}
+
+gboolean FileTrashEngine::trashNatively(TrashDirectory *dir, const QByteArray &path, bool isDir, QString *trashUri, bool *fallback, GError **error)
+{
+    auto name = base_name(path);
+
+    //the original path is relative to the top directory for the trash of other file systems.
+    QByteArray originalPath = path;
+    if (!dir->topdir.isEmpty() && dir->topdir != "/") {
+        originalPath = path.mid(dir->topdir.length() + 1);
+    } else if (dir->topdir == "/") {
+        originalPath = path.mid(1);
+    }
+    char *escapedPath = g_uri_escape_string(originalPath.constData(), "/", FALSE);
+    QByteArray info = "[Trash Info]\nPath=";
+    info += escapedPath;
+    info += "\nDeletionDate=";
+    info += QDateTime::currentDateTime().toString("yyyy-MM-ddThh:mm:ss").toUtf8();
+    info += "\n";
+    g_free(escapedPath);
+
+    //reserve the name by creating the trash info exclusively.
+    QByteArray trashName;
+    QByteArray infoName;
+    int fd = -1;
+    for (int i = 1; ; i++) {
+        trashName = i == 1? name: name + "." + QByteArray::number(i);
+        infoName = trashName + ".trashinfo";
+        fd = openat(dir->infoFd, infoName.constData(), O_CREAT|O_EXCL|O_WRONLY|O_CLOEXEC, 0600);
+        if (fd < 0) {
+            if (errno == EEXIST)
+                continue;
+            return set_error_from_errno(error, errno);
+        }
+        //a file without trash info might be left by other implementations.
+        if (faccessat(dir->filesFd, trashName.constData(), F_OK, AT_SYMLINK_NOFOLLOW) == 0) {
+            close(fd);
+            unlinkat(dir->infoFd, infoName.constData(), 0);
+            continue;
+        }
+        break;
+    }
+
+    bool written = write_all(fd, info);
+    int errsv = errno;
+    close(fd);
+    if (!written) {
+        unlinkat(dir->infoFd, infoName.constData(), 0);
+        return set_error_from_errno(error, errsv);
+    }
+
+    if (rename_noreplace(path.constData(), dir->filesFd, trashName.constData()) != 0) {
+        errsv = errno;
+        unlinkat(dir->infoFd, infoName.constData(), 0);
+        //a bind mount shares the device with its source, let gio decide.
+        if (errsv == EXDEV) {
+            *fallback = true;
+            return FALSE;
+        }
+        return set_error_from_errno(error, errsv);
+    }
+
+    dir->dirty = true;
+    if (isDir) {
+        dir->pendingFolders.insert(trashName);
+    }
+
+    if (trashUri) {
+        auto childName = trash_item_name(dir->path + "/files/" + trashName, dir->topdir.isEmpty());
+        GFile *trash = g_file_new_for_uri("trash:///");
+        GFile *child = g_file_get_child(trash, childName.constData());
+        char *uri = g_file_get_uri(child);
+        *trashUri = uri;
+        g_free(uri);
+        g_object_unref(child);
+        g_object_unref(trash);
+    }
+    return TRUE;
+}
+
+void FileTrashEngine::updateDirectorySizes(TrashDirectory *dir)
+{
+    if (dir->pendingFolders.isEmpty())
+        return;
+
+    auto sizes = read_directory_sizes(dir->path);
+    for (auto name : dir->pendingFolders) {
+        struct stat st;
+        auto infoName = name + ".trashinfo";
+        if (fstatat(dir->infoFd, infoName.constData(), &st, 0) != 0)
+            continue;
+        sizes.insert(name, DirectorySize{directory_size(dir->filesFd, name.constData()), qint64(st.st_mtime)});
+    }
+    dir->pendingFolders.clear();
+
+    //drop the folders which are not in trash any more.
+    for (auto it = sizes.begin(); it != sizes.end();) {
+        if (faccessat(dir->filesFd, it.key().constData(), F_OK, AT_SYMLINK_NOFOLLOW) != 0) {
+            it = sizes.erase(it);
+        } else {
+            it++;
+        }
+    }
+    write_directory_sizes(dir->path, sizes);
+}
+
+void FileTrashEngine::flush()
+{
+    for (auto dir : m_directories) {
+        if (!dir || !dir->dirty)
+            continue;
+        //sync the entries of the batch once, instead of once per file. the contents
+        //of the .trashinfo files are left to the writeback of the file system, a
+        //crash before that might leave some of them empty.
+        fsync(dir->infoFd);
+        fsync(dir->filesFd);
+        updateDirectorySizes(dir);
+        dir->dirty = false;
+    }
+}
+
+QStringList FileTrashEngine::trashDirectories()
+{
+    QStringList directories;
+    auto homeTrash = join_path(g_get_user_data_dir(), "Trash");
+    struct stat st;
+    if (stat(homeTrash.constData(), &st) == 0 && S_ISDIR(st.st_mode))
+        directories<<QString::fromLocal8Bit(homeTrash);
+
+    auto uid = QByteArray::number(getuid());
+    GList *mounts = g_unix_mounts_get(nullptr);
+    for (GList *l = mounts; l; l = l->next) {
+        auto mount = static_cast<GUnixMountEntry *>(l->data);
+        if (g_unix_mount_is_system_internal(mount))
+            continue;
+        QByteArray topdir = g_unix_mount_get_mount_path(mount);
+        QByteArrayList candidates;
+        auto sharedTrash = join_path(topdir, ".Trash");
+        if (lstat(sharedTrash.constData(), &st) == 0 && S_ISDIR(st.st_mode) && (st.st_mode & S_ISVTX))
+            candidates<<sharedTrash + "/" + uid;
+        candidates<<join_path(topdir, ".Trash-" + uid);
+        for (auto candidate : candidates) {
+            auto path = QString::fromLocal8Bit(candidate);
+            if (!directories.contains(path) && lstat(candidate.constData(), &st) == 0 && S_ISDIR(st.st_mode))
+                directories<<path;
+        }
+    }
+    g_list_free_full(mounts, GDestroyNotify(g_unix_mount_free));
+    return directories;
+}
+
+qint64 FileTrashEngine::trashSize(const QString &trashPath)
+{
+    auto path = trashPath.toLocal8Bit();
+    int filesFd = open((path + "/files").constData(), O_RDONLY|O_DIRECTORY|O_NOFOLLOW|O_CLOEXEC);
+    if (filesFd < 0)
+        return 0;
+    int infoFd = open((path + "/info").constData(), O_RDONLY|O_DIRECTORY|O_NOFOLLOW|O_CLOEXEC);
+    DIR *dir = fdopendir(dup(filesFd));
+    if (!dir) {
+        close(filesFd);
+        if (infoFd >= 0)
+            close(infoFd);
+        return 0;
+    }
+
+    auto cachedSizes = read_directory_sizes(path);
+    QHash<QByteArray, DirectorySize> sizes;
+    bool changed = false;
+    qint64 total = 0;
+
+    struct dirent *entry = nullptr;
+    while ((entry = readdir(dir))) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+            continue;
+        struct stat st;
+        if (fstatat(filesFd, entry->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+            continue;
+        if (!S_ISDIR(st.st_mode)) {
+            total += st.st_size;
+            continue;
+        }
+
+        //a cached size is valid while its trash info is not changed.
+        QByteArray name = entry->d_name;
+        struct stat infoSt;
+        qint64 mtime = 0;
+        if (infoFd >= 0 && fstatat(infoFd, (name + ".trashinfo").constData(), &infoSt, 0) == 0)
+            mtime = qint64(infoSt.st_mtime);
+        auto it = cachedSizes.constFind(name);
+        if (it != cachedSizes.constEnd() && it.value().mtime == mtime) {
+            sizes.insert(name, it.value());
+        } else {
+            sizes.insert(name, DirectorySize{directory_size(filesFd, entry->d_name), mtime});
+            changed = true;
+        }
+        total += st.st_size + sizes.value(name).size;
+    }
+    closedir(dir);
+    close(filesFd);
+    if (infoFd >= 0)
+        close(infoFd);
+
+    if (changed || sizes.count() != cachedSizes.count())
+        write_directory_sizes(path, sizes);
+    return total;
+}
+
+void FileTrashEngine::removeOrphanedTrashInfo(const QString &trashPath)
+{
+    auto path = trashPath.toLocal8Bit();
+    int filesFd = open((path + "/files").constData(), O_RDONLY|O_DIRECTORY|O_NOFOLLOW|O_CLOEXEC);
+    if (filesFd < 0)
+        return;
+    int infoFd = open((path + "/info").constData(), O_RDONLY|O_DIRECTORY|O_NOFOLLOW|O_CLOEXEC);
+    DIR *dir = infoFd >= 0? fdopendir(dup(infoFd)): nullptr;
+    if (!dir) {
+        close(filesFd);
+        if (infoFd >= 0)
+            close(infoFd);
+        return;
+    }
+
+    const QByteArray suffix = ".trashinfo";
+    struct dirent *entry = nullptr;
+    while ((entry = readdir(dir))) {
+        QByteArray infoName = entry->d_name;
+        if (!infoName.endsWith(suffix))
+            continue;
+        auto name = infoName.left(infoName.length() - suffix.length());
+        if (faccessat(filesFd, name.constData(), F_OK, AT_SYMLINK_NOFOLLOW) != 0 && errno == ENOENT)
+            unlinkat(infoFd, entry->d_name, 0);
+    }
+    closedir(dir);
+    close(infoFd);
+    close(filesFd);
+}
@@ -0,0 +1,139 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2019, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#ifndef FILETRASHENGINE_H
+#define FILETRASHENGINE_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include <gio/gio.h>
+
+#include <sys/types.h>
+
+namespace Peony {
+
+/*!
+ * \brief The FileTrashEngine class
+ * <br>
+ * FileTrashEngine moves local files to trash by implementing the XDG trash spec
+ * directly. The trash directory of each file system is resolved once, it is the
+ * home trash for the file system of home, and $topdir/.Trash/$uid or
+ * $topdir/.Trash-$uid for others. A name is reserved by creating the .trashinfo
+ * file exclusively, then the file is moved with renameat2(RENAME_NOREPLACE).
+ * </br>
+ * <br>
+ * g_file_trash() writes every .trashinfo file with a temporary file and fsync(),
+ * which is the most of its cost. The engine writes them directly without fsync(),
+ * and only syncs the info and files directories once per batch in flush(), so
+ * the contents of the .trashinfo files are not durable until the file system
+ * writes them back. The directorysizes cache of trash is updated for the trashed
+ * folders in flush() as well.
+ * </br>
+ * <br>
+ * The files which can not be trashed natively, such as files of remote schemes,
+ * are trashed by g_file_trash().
+ * </br>
+ */
+class FileTrashEngine
+{
+public:
+    FileTrashEngine();
+    ~FileTrashEngine();
+
+    /*!
+     * \brief trash
+     * \param file
+     * \param trashUri, set to the uri of the trashed file in trash:///, it can
+     * be used to restore the file.
+     * \details
+     * This function has the same semantic as g_file_trash().
+     */
+    gboolean trash(GFile *file, QString *trashUri, GCancellable *cancellable, GError **error);
+
+    /*!
+     * \brief flush
+     * \details
+     * Sync the trash directory entries created since the last flush, and update the
+     * directorysizes caches. It is also called when the engine is destroyed.
+     */
+    void flush();
+
+    /*!
+     * \brief trashDirectories
+     * \return the existing trash directories of current user, the home trash
+     * and the trash directories in the top directories of mounts.
+     */
+    static QStringList trashDirectories();
+    /*!
+     * \brief trashSize
+     * \param trashPath, one of trashDirectories().
+     * \return the total size of files in the trash directory.
+     * \details
+     * The sizes of trashed folders are read from the directorysizes cache, and
+     * only the folders missing in it are walked. The cache is updated with them,
+     * and the entries of removed folders are dropped.
+     */
+    static qint64 trashSize(const QString &trashPath);
+    /*!
+     * \brief removeOrphanedTrashInfo
+     * \param trashPath, one of trashDirectories().
+     * \details
+     * Remove the .trashinfo files whose files are not in the trash directory.
+     */
+    static void removeOrphanedTrashInfo(const QString &trashPath);
+
+private:
+    struct TrashDirectory
+    {
+        QByteArray path;
+        //empty for the home trash, the original paths are absolute.
+        QByteArray topdir;
+        int filesFd = -1;
+        int infoFd = -1;
+        //the trashed folders whose sizes are not cached yet.
+        QSet<QByteArray> pendingFolders;
+        bool dirty = false;
+    };
+
+    TrashDirectory *trashDirectory(dev_t dev, const QByteArray &path);
+    TrashDirectory *openTrashDirectory(const QByteArray &path, const QByteArray &topdir);
+    /*!
+     * \brief trashNatively
+     * \param fallback, set to true if the file should be trashed by gio instead,
+     * error is not set then.
+     */
+    gboolean trashNatively(TrashDirectory *dir, const QByteArray &path, bool isDir, QString *trashUri, bool *fallback, GError **error);
+    void updateDirectorySizes(TrashDirectory *dir);
+
+private:
+    QByteArray m_home_trash_path;
+    QHash<dev_t, TrashDirectory *> m_directories;
+};
+
+}
+
+#endif // FILETRASHENGINE_H
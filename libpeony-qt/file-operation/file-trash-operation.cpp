@@ -22,6 +22,10 @@
 
 #include "file-trash-operation.h"
 #include "file-operation-manager.h"
+#include "file-trash-engine.h"
+
+//the trash info is synced once for a batch of files.
+#define TRASH_BATCH_SIZE 256
 
 using namespace Peony;
 
@@ -34,13 +38,26 @@ FileTrashOperation::FileTrashOperation(QStringList srcUris, QObject *parent) : F
 void FileTrashOperation::run()
 {
     Q_EMIT operationStarted();
+
+    Q_EMIT operationRequestShowWizard();
+
+    //there is nothing to count, the files are moved in the clearing stage.
+    reportPreparedFiles(m_src_uris.count(), 0);
+    operationPrepared();
+    operationProgressed();
+
+    FileTrashEngine engine;
+    QStringList trashUris;
+    int unflushed = 0;
     for (auto src : m_src_uris) {
         if (isCancelled())
             break;
         retry:
         auto srcFile = wrapGFile(g_file_new_for_uri(src.toUtf8().constData()));
         GError *err = nullptr;
-        g_file_trash(srcFile.get()->get(),
+        QString trashUri;
+        engine.trash(srcFile.get()->get(),
+                     &trashUri,
                      getCancellable().get()->get(),
                      &err);
         if (err) {
@@ -54,7 +71,20 @@ void FileTrashOperation::run()
             default:
                 break;
             }
+            continue;
+        }
+
+        trashUris<<trashUri;
+        reportClearedFiles(src, 1);
+        if (++unflushed == TRASH_BATCH_SIZE) {
+            engine.flush();
+            unflushed = 0;
         }
     }
+    engine.flush();
+
+    //untrash the files with their names in trash, which might be renamed.
+    m_info->m_dest_uris = trashUris;
+
     Q_EMIT operationFinished();
 }
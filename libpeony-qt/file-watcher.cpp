@@ -62,7 +62,7 @@ FileWatcher::FileWatcher(QString uri, QObject *parent) : QObject(parent)
 
     GError *err2 = nullptr;
     m_dir_monitor = g_file_monitor_directory(m_file,
-                                             G_FILE_MONITOR_NONE,
+                                             G_FILE_MONITOR_WATCH_MOVES,
                                              m_cancellable,
                                              &err2);
     if (err2) {
@@ -173,7 +173,7 @@ void FileWatcher::changeMonitorUri(QString uri)
 
     GError *err2 = nullptr;
     m_dir_monitor = g_file_monitor_directory(m_file,
-                                             G_FILE_MONITOR_NONE,
+                                             G_FILE_MONITOR_WATCH_MOVES,
                                              m_cancellable,
                                              &err2);
     if (err2) {
@@ -238,8 +238,21 @@ void FileWatcher::dir_changed_callback(GFileMonitor *monitor,
 {
     //qDebug()<<"dir_changed_callback";
     Q_UNUSED(monitor);
-    Q_UNUSED(other_file);
     switch (event_type) {
+    case G_FILE_MONITOR_EVENT_RENAMED: {
+        //a rename in the directory is still a deletion and a creation for
+        //the users which do not care about renaming.
+        char *uri = g_file_get_uri(file);
+        QString oldUri = QUrl(uri).toDisplayString();
+        g_free(uri);
+        uri = g_file_get_uri(other_file);
+        QString newUri = QUrl(uri).toDisplayString();
+        g_free(uri);
+        Q_EMIT p_this->fileRenamed(oldUri, newUri);
+        Q_EMIT p_this->fileDeleted(oldUri);
+        Q_EMIT p_this->fileCreated(newUri);
+        break;
+    }
     case G_FILE_MONITOR_EVENT_ATTRIBUTE_CHANGED:
     case G_FILE_MONITOR_EVENT_CHANGED: {
         if (p_this->m_montor_children_change) {
@@ -253,7 +266,8 @@ void FileWatcher::dir_changed_callback(GFileMonitor *monitor,
         }
         break;
     }
-    case G_FILE_MONITOR_EVENT_CREATED: {
+    case G_FILE_MONITOR_EVENT_CREATED:
+    case G_FILE_MONITOR_EVENT_MOVED_IN: {
         char *uri = g_file_get_uri(file);
         QString createdFileUri = uri;
         QUrl url = createdFileUri;
@@ -262,7 +276,8 @@ void FileWatcher::dir_changed_callback(GFileMonitor *monitor,
         Q_EMIT p_this->fileCreated(createdFileUri);
         break;
     }
-    case G_FILE_MONITOR_EVENT_DELETED: {
+    case G_FILE_MONITOR_EVENT_DELETED:
+    case G_FILE_MONITOR_EVENT_MOVED_OUT: {
         char *uri = g_file_get_uri(file);
         QString deletedFileUri = uri;
         QUrl url = deletedFileUri;
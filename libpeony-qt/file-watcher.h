@@ -83,6 +83,13 @@ Q_SIGNALS:
     void directoryUnmounted(const QString &uri);
     void fileCreated(const QString &uri);
     void fileDeleted(const QString &uri);
+    /*!
+     * \brief fileRenamed
+     * \details
+     * A child is renamed in the directory, fileDeleted() and fileCreated()
+     * are still sent for it after this signal.
+     */
+    void fileRenamed(const QString &oldUri, const QString &newUri);
     void fileChanged(const QString &uri);
 
     void thumbnailUpdated(const QString &uri);
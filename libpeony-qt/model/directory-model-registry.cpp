@@ -0,0 +1,147 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2019, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#include "directory-model-registry.h"
+#include "file-item-model.h"
+
+using namespace Peony;
+
+static DirectoryModelRegistry *global_instance = nullptr;
+
+DirectoryModelRegistry *DirectoryModelRegistry::getInstance()
+{
+    if (!global_instance) {
+        global_instance = new DirectoryModelRegistry;
+    }
+    return global_instance;
+}
+
+DirectoryModelRegistry::DirectoryModelRegistry(QObject *parent) : QObject(parent)
+{
+
+}
+
+FileItemModel *DirectoryModelRegistry::acquire(const QString &uri, bool *shared)
+{
+    auto model = m_models.value(uri);
+    //the root of a model might be changed, such as its directory
+    //was deleted, then it is not the model of uri any more.
+    if (model && model->getRootUri() != uri) {
+        m_models.remove(uri);
+        model = nullptr;
+    }
+
+    if (shared)
+        *shared = model != nullptr;
+
+    if (!model) {
+        model = new FileItemModel(this);
+        m_models.insert(uri, model);
+        m_entries[model].uri = uri;
+        connect(model, &FileItemModel::rootUriChanged, this, [=](const QString &rootUri){
+            onRootUriChanged(model, rootUri);
+        });
+    }
+
+    auto &entry = m_entries[model];
+    entry.refs++;
+    //a new view is not suspended.
+    model->resume();
+    return model;
+}
+
+void DirectoryModelRegistry::release(FileItemModel *model, bool suspended)
+{
+    auto it = m_entries.find(model);
+    if (it == m_entries.end())
+        return;
+
+    it->refs--;
+    if (suspended)
+        it->suspendedRefs--;
+
+    if (it->refs > 0) {
+        updateSuspension(model, *it);
+        return;
+    }
+
+    if (m_models.value(it->uri) == model)
+        m_models.remove(it->uri);
+    m_entries.erase(it);
+    //the views might still hold the model until the current event is processed.
+    model->cancelFindChildren();
+    model->deleteLater();
+}
+
+void DirectoryModelRegistry::suspend(FileItemModel *model)
+{
+    auto it = m_entries.find(model);
+    if (it == m_entries.end())
+        return;
+
+    it->suspendedRefs++;
+    updateSuspension(model, *it);
+}
+
+void DirectoryModelRegistry::resume(FileItemModel *model)
+{
+    auto it = m_entries.find(model);
+    if (it == m_entries.end())
+        return;
+
+    it->suspendedRefs--;
+    updateSuspension(model, *it);
+}
+
+bool DirectoryModelRegistry::isShared(FileItemModel *model)
+{
+    auto it = m_entries.find(model);
+    if (it == m_entries.end())
+        return false;
+    return it->refs > 1;
+}
+
+void DirectoryModelRegistry::onRootUriChanged(FileItemModel *model, const QString &uri)
+{
+    auto it = m_entries.find(model);
+    if (it == m_entries.end() || it->uri == uri)
+        return;
+
+    if (m_models.value(it->uri) == model)
+        m_models.remove(it->uri);
+    it->uri = uri;
+    //another model might have been created for the new location.
+    if (!m_models.contains(uri))
+        m_models.insert(uri, model);
+
+    Q_EMIT modelRootChanged(model, uri);
+}
+
+void DirectoryModelRegistry::updateSuspension(FileItemModel *model, const Entry &entry)
+{
+    if (entry.suspendedRefs >= entry.refs) {
+        model->suspend();
+    } else {
+        model->resume();
+    }
+}
@@ -0,0 +1,127 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2019, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+
+#ifndef DIRECTORYMODELREGISTRY_H
+#define DIRECTORYMODELREGISTRY_H
+
+#include <QObject>
+#include <QHash>
+#include "peony-core_global.h"
+
+namespace Peony {
+
+class FileItemModel;
+
+/*!
+ * \brief The DirectoryModelRegistry class
+ * <br>
+ * DirectoryModelRegistry shares the FileItemModel of a directory between all
+ * the views showing it, such as duplicated tabs, split views and other windows.
+ * The directory is enumerated, monitored and queried only once, and the items
+ * are kept once. Each view still has its own FileItemProxyFilterSortModel, so
+ * that sorting, filtering and hidden files are set per view.
+ * </br>
+ * <br>
+ * The models are reference counted, a model is deleted when the last view
+ * releases it. A model is only suspended when all of its views are suspended.
+ * </br>
+ * <br>
+ * The state of a view must not be set on a shared model. A view should not reset
+ * or cancel the loading of a model shared with others, see isShared(). The mode
+ * and expansions of tree views are counted by the model and its items, see
+ * FileItemModel::addTreeView() and FileItem::addExpandedView().
+ * </br>
+ * \note
+ * Large directories shown with FlatDirectoryModel are not shared, the flat
+ * model sorts its rows itself and can not be sorted per view.
+ */
+class PEONYCORESHARED_EXPORT DirectoryModelRegistry : public QObject
+{
+    Q_OBJECT
+public:
+    static DirectoryModelRegistry *getInstance();
+
+    /*!
+     * \brief acquire
+     * \param uri
+     * \param shared, set to true if the model was used by other views,
+     * then it has been loaded or is being loaded, and the view should not
+     * set its root uri again.
+     * \return the model of uri, it must be released with release().
+     */
+    FileItemModel *acquire(const QString &uri, bool *shared = nullptr);
+    /*!
+     * \brief release
+     * \param model
+     * \param suspended, true if the view had suspended the model.
+     */
+    void release(FileItemModel *model, bool suspended = false);
+
+    /*!
+     * \brief suspend
+     * \param model
+     * <br>
+     * Called when a view of model is hidden for a while. The model is suspended
+     * once all of its views are suspended.
+     * </br>
+     * \see FileItemModel::suspend()
+     */
+    void suspend(FileItemModel *model);
+    void resume(FileItemModel *model);
+
+    /*!
+     * \brief isShared
+     * \return true if model is used by more than one view.
+     */
+    bool isShared(FileItemModel *model);
+
+Q_SIGNALS:
+    /*!
+     * \brief modelRootChanged
+     * <br>
+     * The root of a shared model was changed by the model itself, such as its
+     * directory was deleted, all of the views using it should follow.
+     * </br>
+     */
+    void modelRootChanged(FileItemModel *model, const QString &uri);
+
+private:
+    explicit DirectoryModelRegistry(QObject *parent = nullptr);
+
+    struct Entry {
+        QString uri;
+        int refs = 0;
+        int suspendedRefs = 0;
+    };
+
+    void updateSuspension(FileItemModel *model, const Entry &entry);
+    void onRootUriChanged(FileItemModel *model, const QString &uri);
+
+private:
+    QHash<QString, FileItemModel*> m_models;
+    QHash<FileItemModel*, Entry> m_entries;
+};
+
+}
+
+#endif // DIRECTORYMODELREGISTRY_H
@@ -31,6 +31,7 @@
 #include "file-utils.h"
 
 #include "thumbnail-manager.h"
+#include "theme-icon-cache.h"
 
 #include "file-operation-utils.h"
 
@@ -78,10 +79,56 @@ void FileItemModel::setRootItem(FileItem *item)
     beginResetModel();
     m_root_item->deleteLater();
 
+    m_suspended = false;
     m_root_item = item;
     m_root_item->findChildrenAsync();
 
     endResetModel();
+
+    Q_EMIT rootUriChanged(m_root_item->uri());
+}
+
+void FileItemModel::suspend()
+{
+    if (!m_root_item || m_suspended)
+        return;
+
+    m_suspended = true;
+    m_root_item->suspend();
+}
+
+void FileItemModel::resume()
+{
+    if (!m_suspended)
+        return;
+
+    m_suspended = false;
+    m_root_item->catchUp();
+}
+
+void FileItemModel::catchUp()
+{
+    if (!m_root_item || m_suspended || !m_root_item->m_loaded)
+        return;
+
+    m_root_item->catchUp();
+}
+
+void FileItemModel::addTreeView()
+{
+    m_tree_views++;
+    m_is_positive = false;
+    m_can_expand = true;
+}
+
+void FileItemModel::removeTreeView()
+{
+    if (m_tree_views > 0)
+        m_tree_views--;
+    if (m_tree_views == 0) {
+        m_is_positive = true;
+        m_can_expand = false;
+    }
 }
 
 QModelIndex FileItemModel::index(int row, int column, const QModelIndex &parent) const
@@ -198,6 +245,10 @@ QVariant FileItemModel::data(const QModelIndex &index, int role) const
     if (role == FileItemModel::UriRole)
         return QVariant(item->uri());
 
+    //the children of expanded sub folders are queried in the viewport order.
+    if (item->m_info_deferred && (role == Qt::DisplayRole || role == Qt::DecorationRole))
+        item->queryDeferredInfo();
+
     //qDebug()<<item->m_info->uri();
     switch (index.column()) {
     case FileName:{
@@ -206,7 +257,7 @@ QVariant FileItemModel::data(const QModelIndex &index, int role) const
             return QVariant(Qt::AlignHCenter | Qt::AlignBaseline);
         }
         case Qt::DisplayRole:{
-            return QVariant(item->m_info->displayName());
+            return QVariant(item->displayName());
         }
         case Qt::DecorationRole:{
             /*
@@ -218,11 +269,11 @@ QVariant FileItemModel::data(const QModelIndex &index, int role) const
             auto thumbnail = ThumbnailManager::getInstance()->tryGetThumbnail(item->m_info->uri());
             if (!thumbnail.isNull()) {
                 if (item->m_info->uri().endsWith(".desktop") && !item->m_info->canExecute()) {
-                    return QIcon::fromTheme(item->m_info->iconName(), QIcon::fromTheme("text-x-generic"));
+                    return ThemeIconCache::getInstance()->icon(item->m_info->iconName(), "text-x-generic");
                 }
                 return thumbnail;
             }
-            QIcon icon = QIcon::fromTheme(item->m_info->iconName(), QIcon::fromTheme("text-x-generic"));
+            QIcon icon = ThemeIconCache::getInstance()->icon(item->m_info->iconName(), "text-x-generic");
             return QVariant(icon);
         }
         case Qt::ToolTipRole: {
@@ -297,7 +348,7 @@ bool FileItemModel::hasChildren(const QModelIndex &parent) const
     if (!parent.isValid())
         return true;
     FileItem *parent_item = static_cast<FileItem*>(parent.internalPointer());
-    if (parent_item->hasChildren() && m_can_expand)
+    if (parent_item->hasChildren() && m_can_expand && !parent_item->m_is_empty)
         return true;
     return false;
 }
@@ -335,8 +386,13 @@ bool FileItemModel::canFetchMore(const QModelIndex &parent) const
 
 void FileItemModel::fetchMore(const QModelIndex &parent)
 {
-    Q_UNUSED(parent);
-    //do not fetch more here
+    //the root item is loaded by setRootUri(), the others are
+    //loaded lazily when they are expanded in a tree view.
+    if (!parent.isValid() || !m_can_expand)
+        return;
+
+    FileItem *parent_item = static_cast<FileItem*>(parent.internalPointer());
+    parent_item->findChildrenAsync();
 }
 
 bool FileItemModel::insertRows(int row, int count, const QModelIndex &parent)
@@ -94,6 +94,50 @@ public:
      */
     bool isPositiveResponse() {return m_is_positive;}
 
+    /*!
+     * \brief suspend
+     * <br>
+     * Stop monitoring the root item and its expanded children, cancel the pending
+     * enumeration and release the thumbnails. This is used when the view is hidden
+     * for a while, such as a background tab. The items are kept so that the view
+     * can be shown again immediately.
+     * </br>
+     * \see FileItem::suspend().
+     */
+    void suspend();
+    /*!
+     * \brief resume
+     * <br>
+     * Update the suspended items with the changes happened during suspension,
+     * and start monitoring again.
+     * </br>
+     * \see FileItem::catchUp().
+     */
+    void resume();
+    bool isSuspended() {return m_suspended;}
+    /*!
+     * \brief catchUp
+     * <br>
+     * Update the loaded items with the current directory contents, like resume()
+     * does, without resetting the model. A shared model is refreshed this way, so
+     * that the other views keep their rows and states. A model which is still
+     * loading is not touched.
+     * </br>
+     */
+    void catchUp();
+
+    /*!
+     * \brief addTreeView
+     * <br>
+     * A shared model might be shown in views of different kinds. A tree view
+     * needs the children found in one batch and the sub folders expandable, so
+     * the model works that way while any tree view is bound to it.
+     * </br>
+     * \see setPositiveResponse(), setExpandable()
+     */
+    void addTreeView();
+    void removeTreeView();
+
     void setExpandable(bool expandable) {m_can_expand = expandable;}
     bool canExpandChildren() {return  m_can_expand;}
 
@@ -228,6 +272,15 @@ Q_SIGNALS:
      */
     void updated();
 
+    /*!
+     * \brief rootUriChanged
+     * <br>
+     * The root item was changed, it might not be requested by a view, such as
+     * the directory was deleted or renamed.
+     * </br>
+     */
+    void rootUriChanged(const QString &uri);
+
 public Q_SLOTS:
     /*!
      * \brief onFoundChildren
@@ -256,6 +309,8 @@ private:
     FileItem *m_root_item = nullptr;
     bool m_is_positive = false;
     bool m_can_expand = false;
+    bool m_suspended = false;
+    int m_tree_views = 0;
 };
 
 }
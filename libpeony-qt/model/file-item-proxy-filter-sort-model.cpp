@@ -55,8 +55,11 @@ FileItemProxyFilterSortModel::FileItemProxyFilterSortModel(QObject *parent) : QS
 
 void FileItemProxyFilterSortModel::setSourceModel(QAbstractItemModel *model)
 {
+    if (sourceModel() == model)
+        return;
+    //the source models are shared between views.
     if (sourceModel())
-        disconnect(sourceModel());
+        disconnect(static_cast<FileItemModel*>(sourceModel()), &FileItemModel::updated, this, &FileItemProxyFilterSortModel::update);
     QSortFilterProxyModel::setSourceModel(model);
     FileItemModel *file_item_model = static_cast<FileItemModel*>(model);
     connect(file_item_model, &FileItemModel::updated, this, &FileItemProxyFilterSortModel::update);
@@ -104,26 +107,8 @@ bool FileItemProxyFilterSortModel::lessThan(const QModelIndex &left, const QMode
 default_sort:
         switch (sortColumn()) {
         case FileItemModel::FileName: {
-            if (FileOperationUtils::leftNameIsDuplicatedFileOfRightName(leftItem->m_info->displayName(), rightItem->m_info->displayName())) {
-                return FileOperationUtils::leftNameLesserThanRightName(leftItem->info()->displayName(), rightItem->info()->displayName());
-            }
-            if (m_use_default_name_sort_order) {
-                QString leftDisplayName = leftItem->m_info->displayName();
-                QString rightDisplayName = rightItem->m_info->displayName();
-                bool leftStartWithChinese = startWithChinese(leftDisplayName);
-                bool rightStartWithChinese = startWithChinese(rightDisplayName);
-                //all start with Chinese, use the default compare directly
-                if (leftStartWithChinese && rightStartWithChinese)
-                    return comparer.compare(leftDisplayName, rightDisplayName) < 0;
-                //simplify the logic
-                if (leftStartWithChinese || rightStartWithChinese) {
-                    if (sortOrder() == Qt::AscendingOrder) {
-                        return leftStartWithChinese;
-                    }
-                    return rightStartWithChinese;
-                }
-            }
-            return leftItem->m_info->displayName().toLower() < rightItem->m_info->displayName().toLower();
+            //the children of expanded sub folders might not be queried yet.
+            return nameLessThan(leftItem->displayName(), rightItem->displayName(), m_use_default_name_sort_order, sortOrder());
         }
         case FileItemModel::FileSize: {
             return leftItem->m_info->size() < rightItem->m_info->size();
@@ -142,6 +127,31 @@ default_sort:
     return QSortFilterProxyModel::lessThan(left, right);
 }
 
+bool FileItemProxyFilterSortModel::nameLessThan(const QString &left, const QString &right, bool chineseFirst, Qt::SortOrder order)
+{
+    //names without a copy number can not be duplicated files of each other,
+    //skip the regular expressions for them.
+    bool mayBeDuplicated = left.contains('(') || right.contains('(');
+    if (mayBeDuplicated && FileOperationUtils::leftNameIsDuplicatedFileOfRightName(left, right)) {
+        return FileOperationUtils::leftNameLesserThanRightName(left, right);
+    }
+    if (chineseFirst) {
+        bool leftStartWithChinese = startWithChinese(left);
+        bool rightStartWithChinese = startWithChinese(right);
+        //all start with Chinese, use the default compare directly
+        if (leftStartWithChinese && rightStartWithChinese)
+            return comparer.compare(left, right) < 0;
+        //simplify the logic
+        if (leftStartWithChinese || rightStartWithChinese) {
+            if (order == Qt::AscendingOrder) {
+                return leftStartWithChinese;
+            }
+            return rightStartWithChinese;
+        }
+    }
+    return left.toLower() < right.toLower();
+}
+
 bool FileItemProxyFilterSortModel::filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent) const
 {
     //FIXME:
@@ -154,8 +164,9 @@ bool FileItemProxyFilterSortModel::filterAcceptsRow(int sourceRow, const QModelI
             //qDebug()<<sourceRow<<item->m_info->displayName()<<model->rowCount(sourceParent);
             //QMessageBox::warning(nullptr, "filter", item->m_info->displayName());
             //qDebug()<<item->m_info->displayName();
-            if (item->m_info->displayName() != nullptr) {
-                if (item->m_info->displayName().at(0) == '.')
+            auto displayName = item->displayName();
+            if (displayName != nullptr) {
+                if (displayName.at(0) == '.')
                     //qDebug()<<sourceRow<<item->m_info->displayName()<<model->rowCount(sourceParent);
                     return false;
             }
@@ -489,7 +500,7 @@ void FileItemProxyFilterSortModel::setLabelBlurName(QString blurName, bool caseS
     invalidateFilter();
 }
 
-bool FileItemProxyFilterSortModel::startWithChinese(const QString &displayName) const
+bool FileItemProxyFilterSortModel::startWithChinese(const QString &displayName)
 {
     //NOTE: a newly created file might could not get display name soon.
     if (displayName.isEmpty()) {
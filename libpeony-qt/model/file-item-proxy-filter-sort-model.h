@@ -95,6 +95,18 @@ public:
     QStringList getAllFileUris();
     QModelIndexList getAllFileIndexes();
 
+    /*!
+     * \brief nameLessThan
+     * \param chineseFirst, names start with Chinese are in front of others.
+     * \param order, the sort order, Chinese names are in front in both orders.
+     * \return true if the left name should be sorted before the right one in
+     * ascending order.
+     * \details
+     * This is the name comparison of lessThan(), FlatDirectoryModel sorts with
+     * it too, so the names are in the same order in both models.
+     */
+    static bool nameLessThan(const QString &left, const QString &right, bool chineseFirst, Qt::SortOrder order);
+
 public Q_SLOTS:
     void update();
 
@@ -103,7 +115,7 @@ protected:
     bool lessThan(const QModelIndex &left, const QModelIndex &right) const override;
 
 private:
-    bool startWithChinese(const QString &displayName) const;
+    static bool startWithChinese(const QString &displayName);
     bool checkFileTypeFilter(QString type) const;
     bool checkFileModifyTimeFilter(QString modifiedDate) const;
     bool checkFileSizeFilter(quint64 size) const;
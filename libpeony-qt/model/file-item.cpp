@@ -38,6 +38,16 @@
 
 #include <QMessageBox>
 #include <QUrl>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSet>
+#include <QTimer>
+#include <QDirIterator>
+#include <QFutureWatcher>
+#include <QtConcurrent>
+
+//a collapsed folder might be expanded again soon.
+#define CHILDREN_RELEASE_DELAY 10000
 
 using namespace Peony;
 
@@ -134,9 +144,11 @@ void FileItem::findChildrenAsync()
         enumerator->enumerateAsync();
     });
 
-    if (!m_model->isPositiveResponse()) {
+    //an expanded sub folder shows its children as soon as they are found.
+    if (!m_model->isPositiveResponse() && !m_parent) {
         enumerator->connect(enumerator, &Peony::FileEnumerator::enumerateFinished, this, [=](bool successed){
             if (successed) {
+                m_loaded = true;
                 auto infos = enumerator->getChildren(true);
                 m_async_count = infos.count();
                 if (infos.count() == 0) {
@@ -177,56 +189,12 @@ void FileItem::findChildrenAsync()
             enumerator->cancel();
             delete enumerator;
 
-             m_watcher = std::make_shared<FileWatcher>(this->m_info->uri());
-            m_watcher->setMonitorChildrenChange(true);
-            connect(m_watcher.get(), &FileWatcher::fileCreated, this, [=](QString uri){
-                //add new item to m_children
-                //tell the model update
-                this->onChildAdded(uri);
-                Q_EMIT this->childAdded(uri);
-            });
-            connect(m_watcher.get(), &FileWatcher::fileDeleted, this, [=](QString uri){
-                //remove the crosponding child
-                //tell the model update
-                this->onChildRemoved(uri);
-                Q_EMIT this->childRemoved(uri);
-            });
-            connect(m_watcher.get(), &FileWatcher::fileChanged, this, [=](const QString &uri){
-                auto index = m_model->indexFromUri(uri);
-                if (index.isValid()) {
-                    auto infoJob = new FileInfoJob(FileInfo::fromUri(index.data(FileItemModel::UriRole).toString()));
-                    infoJob->setAutoDelete();
-                    connect(infoJob, &FileInfoJob::queryAsyncFinished, this, [=](){
-                        m_model->dataChanged(m_model->indexFromUri(uri), m_model->indexFromUri(uri));
-                        auto info = FileInfo::fromUri(uri);
-                        if (info->isDesktopFile()) {
-                            ThumbnailManager::getInstance()->updateDesktopFileThumbnail(info->uri(), m_watcher);
-                        }
-                    });
-                    infoJob->queryAsync();
-                }
-            });
-            connect(m_watcher.get(), &FileWatcher::thumbnailUpdated, this, [=](const QString &uri){
-                m_model->dataChanged(m_model->indexFromUri(uri), m_model->indexFromUri(uri));
-            });
-            connect(m_watcher.get(), &FileWatcher::directoryDeleted, this, [=](QString uri){
-                //clean all the children, if item index is root index, cd up.
-                //this might use FileItemModel::setRootItem()
-                Q_EMIT this->deleted(uri);
-                this->onDeleted(uri);
-            });
-
-            connect(m_watcher.get(), &FileWatcher::locationChanged, this, [=](QString oldUri, QString newUri){
-                //this might use FileItemModel::setRootItem()
-                Q_EMIT this->renamed(oldUri, newUri);
-                this->onRenamed(oldUri, newUri);
-            });
+            //the model was suspended while loading, it will be reloaded when resumed.
+            if (m_model->isSuspended())
+                return;
 
-            connect(m_watcher.get(), &FileWatcher::directoryUnmounted, this, [=](){
-                m_model->setRootUri("computer:///");
-            });
-            //qDebug()<<"startMonitor";
-            m_watcher->startMonitor();
+            startMonitor();
+            probeChildren();
         });
     } else {
         enumerator->connect(enumerator, &Peony::FileEnumerator::childrenUpdated, this, [=](const QStringList &uris){
@@ -240,12 +208,27 @@ void FileItem::findChildrenAsync()
                 return ;
             }
 
+            if (uris.isEmpty())
+                return;
+
+            //the children of an expanded sub folder query their info when
+            //they are shown, so they are loaded in the viewport order.
+            bool deferInfo = m_parent != nullptr;
+            QList<FileItem *> items;
+            m_model->beginInsertRows(firstColumnIndex(), m_children->count(), m_children->count() + uris.count() - 1);
             for (auto uri : uris) {
-                auto info = FileInfo::fromUri(uri);
-                auto item = new FileItem(info, this, m_model);
-                m_model->beginInsertRows(firstColumnIndex(), m_children->count(), m_children->count());
+                auto item = new FileItem(FileInfo::fromUri(uri), this, m_model);
+                item->m_info_deferred = deferInfo;
                 m_children->append(item);
-                m_model->endInsertRows();
+                items<<item;
+            }
+            m_model->endInsertRows();
+
+            if (deferInfo)
+                return;
+
+            for (auto item : items) {
+                auto info = item->m_info;
                 auto infoJob = new FileInfoJob(info);
                 infoJob->setAutoDelete();
                 infoJob->connect(infoJob, &FileInfoJob::infoUpdated, this, [=](){
@@ -257,64 +240,22 @@ void FileItem::findChildrenAsync()
             }
         });
 
-        enumerator->connect(enumerator, &Peony::FileEnumerator::enumerateFinished, this, [=](){
+        enumerator->connect(enumerator, &Peony::FileEnumerator::enumerateFinished, this, [=](bool successed){
             delete enumerator;
             if (!m_model||!m_children||!m_info)
                 return;
 
+            //a cancelled enumeration also finishes, its children are incomplete.
+            m_loaded = successed;
             Q_EMIT m_model->findChildrenFinished();
             Q_EMIT m_model->updated();
 
-            m_watcher = std::make_shared<FileWatcher>(this->m_info->uri());
-            m_watcher->setMonitorChildrenChange(true);
-            connect(m_watcher.get(), &FileWatcher::fileCreated, this, [=](QString uri){
-                //add new item to m_children
-                //tell the model update
-                this->onChildAdded(uri);
-                Q_EMIT this->childAdded(uri);
-                ThumbnailManager::getInstance()->createThumbnail(uri, m_watcher);
-            });
-            connect(m_watcher.get(), &FileWatcher::fileDeleted, this, [=](QString uri){
-                //remove the crosponding child
-                //tell the model update
-                this->onChildRemoved(uri);
-                Q_EMIT this->childRemoved(uri);
-            });
-            connect(m_watcher.get(), &FileWatcher::fileChanged, this, [=](const QString &uri){
-                auto index = m_model->indexFromUri(uri);
-                if (index.isValid()) {
-                    auto infoJob = new FileInfoJob(FileInfo::fromUri(index.data(FileItemModel::UriRole).toString()));
-                    infoJob->setAutoDelete();
-                    connect(infoJob, &FileInfoJob::queryAsyncFinished, this, [=](){
-                        m_model->dataChanged(m_model->indexFromUri(uri), m_model->indexFromUri(uri));
-                        auto info = FileInfo::fromUri(uri);
-                        if (info->isDesktopFile()) {
-                            ThumbnailManager::getInstance()->updateDesktopFileThumbnail(info->uri(), m_watcher);
-                        }
-                    });
-                    infoJob->queryAsync();
-                }
-            });
-            connect(m_watcher.get(), &FileWatcher::thumbnailUpdated, this, [=](const QString &uri){
-                m_model->dataChanged(m_model->indexFromUri(uri), m_model->indexFromUri(uri));
-            });
-            connect(m_watcher.get(), &FileWatcher::directoryDeleted, this, [=](QString uri){
-                //clean all the children, if item index is root index, cd up.
-                //this might use FileItemModel::setRootItem()
-                Q_EMIT this->deleted(uri);
-                this->onDeleted(uri);
-            });
-            connect(m_watcher.get(), &FileWatcher::locationChanged, this, [=](QString oldUri, QString newUri){
-                //this might use FileItemModel::setRootItem()
-                Q_EMIT this->renamed(oldUri, newUri);
-                this->onRenamed(oldUri, newUri);
-            });
+            //the model was suspended while loading, it will be reloaded when resumed.
+            if (m_model->isSuspended())
+                return;
 
-            connect(m_watcher.get(), &FileWatcher::directoryUnmounted, this, [=](){
-                m_model->setRootUri("computer:///");
-            });
-            //qDebug()<<"startMonitor";
-            m_watcher->startMonitor();
+            startMonitor();
+            probeChildren();
         });
     }
 
@@ -331,6 +272,308 @@ QModelIndex FileItem::lastColumnIndex()
     return m_model->lastColumnIndex(this);
 }
 
+void FileItem::startMonitor()
+{
+    m_watcher = std::make_shared<FileWatcher>(this->m_info->uri());
+    m_watcher->setMonitorChildrenChange(true);
+    connect(m_watcher.get(), &FileWatcher::fileCreated, this, [=](QString uri){
+        //add new item to m_children
+        //tell the model update
+        this->onChildAdded(uri);
+        Q_EMIT this->childAdded(uri);
+        ThumbnailManager::getInstance()->createThumbnail(uri, m_watcher);
+    });
+    connect(m_watcher.get(), &FileWatcher::fileDeleted, this, [=](QString uri){
+        //remove the crosponding child
+        //tell the model update
+        this->onChildRemoved(uri);
+        Q_EMIT this->childRemoved(uri);
+    });
+    connect(m_watcher.get(), &FileWatcher::fileChanged, this, [=](const QString &uri){
+        auto index = m_model->indexFromUri(uri);
+        if (index.isValid()) {
+            auto infoJob = new FileInfoJob(FileInfo::fromUri(index.data(FileItemModel::UriRole).toString()));
+            infoJob->setAutoDelete();
+            connect(infoJob, &FileInfoJob::queryAsyncFinished, this, [=](){
+                m_model->dataChanged(m_model->indexFromUri(uri), m_model->indexFromUri(uri));
+                auto info = FileInfo::fromUri(uri);
+                if (info->isDesktopFile()) {
+                    ThumbnailManager::getInstance()->updateDesktopFileThumbnail(info->uri(), m_watcher);
+                }
+                //a sub folder might have been filled or emptied.
+                if (info->isDir())
+                    probeChildren(QStringList()<<info->uri());
+            });
+            infoJob->queryAsync();
+        }
+    });
+    connect(m_watcher.get(), &FileWatcher::thumbnailUpdated, this, [=](const QString &uri){
+        m_model->dataChanged(m_model->indexFromUri(uri), m_model->indexFromUri(uri));
+    });
+    connect(m_watcher.get(), &FileWatcher::directoryDeleted, this, [=](QString uri){
+        //clean all the children, if item index is root index, cd up.
+        //this might use FileItemModel::setRootItem()
+        Q_EMIT this->deleted(uri);
+        this->onDeleted(uri);
+    });
+    connect(m_watcher.get(), &FileWatcher::locationChanged, this, [=](QString oldUri, QString newUri){
+        //this might use FileItemModel::setRootItem()
+        Q_EMIT this->renamed(oldUri, newUri);
+        this->onRenamed(oldUri, newUri);
+    });
+
+    connect(m_watcher.get(), &FileWatcher::directoryUnmounted, this, [=](){
+        m_model->setRootUri("computer:///");
+    });
+    //qDebug()<<"startMonitor";
+    m_watcher->startMonitor();
+}
+
+void FileItem::suspend()
+{
+    if (!m_expanded)
+        return;
+
+    Q_EMIT cancelFindChildren();
+    //the thumbnail jobs requested with the watcher are cancelled as well.
+    m_watcher.reset();
+    for (auto child : *m_children) {
+        //the thumbnails shown by other views are kept.
+        ThumbnailManager::getInstance()->releaseUnwatchedThumbnail(child->uri());
+        child->suspend();
+    }
+}
+
+void FileItem::catchUp()
+{
+    if (!m_expanded)
+        return;
+
+    if (!m_loaded) {
+        //the children were not found completely before suspended.
+        reloadChildren();
+        return;
+    }
+
+    Peony::FileEnumerator *enumerator = new Peony::FileEnumerator;
+    enumerator->setEnumerateDirectory(m_info->uri());
+    //a cancelled enumeration finishes unsuccessfully too, it must not reload.
+    auto cancelled = std::make_shared<bool>(false);
+    enumerator->connect(this, &FileItem::cancelFindChildren, enumerator, [=](){
+        *cancelled = true;
+        enumerator->cancel();
+    });
+    enumerator->connect(enumerator, &Peony::FileEnumerator::enumerateFinished, this, [=](bool successed){
+        auto uris = enumerator->getChildrenUris();
+        enumerator->deleteLater();
+        //suspended again, or stopped.
+        if (*cancelled || m_model->isSuspended())
+            return;
+        //the snapshot can not be compared, and it would not be monitored.
+        if (!successed) {
+            reloadChildren();
+            return;
+        }
+
+        QSet<QString> foundUris;
+        for (auto uri : uris) {
+            foundUris<<QUrl(uri).toDisplayString();
+        }
+
+        QHash<QString, quint64> modifiedTimes;
+        auto parent = firstColumnIndex();
+        for (int row = m_children->count() - 1; row >= 0; row--) {
+            auto child = m_children->at(row);
+            if (!foundUris.remove(child->uri())) {
+                m_model->beginRemoveRows(parent, row, row);
+                m_children->remove(row);
+                m_model->endRemoveRows();
+                delete child;
+                continue;
+            }
+
+            //local files are checked with a cheap stat, we can not
+            //know whether a remote file changed without querying it.
+            QUrl url = child->uri();
+            if (child->m_info_deferred) {
+                //it will be queried when it is shown.
+            } else if (url.isLocalFile()) {
+                modifiedTimes.insert(child->uri(), child->info()->modifiedTime());
+            } else {
+                child->updateInfoAsync();
+            }
+            child->catchUp();
+        }
+
+        if (!foundUris.isEmpty()) {
+            m_model->beginInsertRows(parent, m_children->count(), m_children->count() + foundUris.count() - 1);
+            for (auto uri : foundUris) {
+                auto child = new FileItem(FileInfo::fromUri(uri), this, m_model);
+                m_children->append(child);
+                child->updateInfoAsync();
+            }
+            m_model->endInsertRows();
+        }
+
+        startMonitor();
+        for (auto child : *m_children) {
+            ThumbnailManager::getInstance()->createThumbnail(child->uri(), m_watcher);
+        }
+        probeChildren();
+        Q_EMIT m_model->updated();
+
+        updateModifiedChildren(modifiedTimes);
+    });
+    enumerator->enumerateAsync();
+}
+
+void FileItem::reloadChildren()
+{
+    if (!m_parent) {
+        m_model->setRootUri(uri());
+    } else {
+        clearChildren();
+    }
+}
+
+void FileItem::updateModifiedChildren(const QHash<QString, quint64> &modifiedTimes)
+{
+    if (modifiedTimes.isEmpty())
+        return;
+
+    //stat the children in a worker thread, a large directory would block the gui.
+    auto watcher = new QFutureWatcher<QSet<QString>>(this);
+    connect(watcher, &QFutureWatcher<QSet<QString>>::finished, this, [=](){
+        QSet<QString> modifiedUris = watcher->result();
+        watcher->deleteLater();
+        if (m_model->isSuspended())
+            return;
+
+        for (auto child : *m_children) {
+            if (modifiedUris.contains(child->uri()))
+                child->updateInfoAsync();
+        }
+    });
+    watcher->setFuture(QtConcurrent::run([=](){
+        QSet<QString> modifiedUris;
+        for (auto it = modifiedTimes.constBegin(); it != modifiedTimes.constEnd(); it++) {
+            auto modifiedTime = quint64(QFileInfo(QUrl(it.key()).toLocalFile()).lastModified().toMSecsSinceEpoch()/1000);
+            if (modifiedTime != it.value())
+                modifiedUris<<it.key();
+        }
+        return modifiedUris;
+    }));
+}
+
+void FileItem::probeChildren(const QStringList &uris)
+{
+    //the probe is only used to decide whether an item can be expanded.
+    if (!m_model->canExpandChildren())
+        return;
+
+    QStringList dirUris = uris;
+    if (dirUris.isEmpty()) {
+        for (auto child : *m_children) {
+            if (child->m_info->isDir())
+                dirUris<<child->uri();
+        }
+    }
+
+    //remote directories are assumed to have entries.
+    QStringList paths;
+    for (auto uri : dirUris) {
+        QUrl url = uri;
+        if (url.isLocalFile())
+            paths<<url.toLocalFile();
+    }
+    if (paths.isEmpty())
+        return;
+
+    //only the first entry of each directory is read, in a worker thread.
+    auto watcher = new QFutureWatcher<QStringList>(this);
+    connect(watcher, &QFutureWatcher<QStringList>::finished, this, [=](){
+        QSet<QString> emptyPaths = watcher->result().toSet();
+        QSet<QString> probedPaths = paths.toSet();
+        watcher->deleteLater();
+
+        bool changed = false;
+        for (auto child : *m_children) {
+            auto path = QUrl(child->uri()).toLocalFile();
+            if (!probedPaths.contains(path))
+                continue;
+            bool isEmpty = emptyPaths.contains(path);
+            if (child->m_is_empty != isEmpty) {
+                child->m_is_empty = isEmpty;
+                changed = true;
+            }
+        }
+        //let the views layout again, they cache the expanders.
+        if (changed)
+            Q_EMIT m_model->updated();
+    });
+    watcher->setFuture(QtConcurrent::run([=](){
+        QStringList emptyPaths;
+        for (auto path : paths) {
+            QDirIterator it(path, QDir::AllEntries|QDir::NoDotAndDotDot|QDir::Hidden|QDir::System);
+            if (!it.hasNext())
+                emptyPaths<<path;
+        }
+        return emptyPaths;
+    }));
+}
+
+void FileItem::queryDeferredInfo()
+{
+    m_info_deferred = false;
+    auto infoJob = new FileInfoJob(m_info);
+    infoJob->setAutoDelete();
+    infoJob->connect(infoJob, &FileInfoJob::infoUpdated, this, [=](){
+        Q_EMIT m_model->dataChanged(firstColumnIndex(), lastColumnIndex());
+        if (m_parent)
+            ThumbnailManager::getInstance()->createThumbnail(m_info->uri(), m_parent->m_watcher);
+    });
+    infoJob->queryAsync();
+}
+
+const QString FileItem::displayName()
+{
+    if (!m_info->isEmptyInfo())
+        return m_info->displayName();
+
+    //the info has not been queried yet.
+    auto uri = m_info->uri();
+    if (uri.endsWith("/"))
+        uri.chop(1);
+    return uri.mid(uri.lastIndexOf("/") + 1);
+}
+
+void FileItem::releaseChildrenLater()
+{
+    int serial = ++m_release_serial;
+    QTimer::singleShot(CHILDREN_RELEASE_DELAY, this, [=](){
+        //it was expanded again during the delay.
+        if (serial != m_release_serial || !m_expanded || m_expanded_views > 0)
+            return;
+        Q_EMIT cancelFindChildren();
+        clearChildren();
+    });
+}
+
+void FileItem::addExpandedView()
+{
+    m_expanded_views++;
+    //cancel the pending release.
+    m_release_serial++;
+}
+
+void FileItem::removeExpandedView()
+{
+    if (m_expanded_views > 0)
+        m_expanded_views--;
+    if (m_expanded_views == 0)
+        releaseChildrenLater();
+}
+
 bool FileItem::hasChildren()
 {
     //qDebug()<<"has children"<<m_info->uri()<<(m_info->isDir() || m_info->isVolume() || m_children->count() > 0);
@@ -449,7 +692,8 @@ void FileItem::updateInfoAsync()
 void FileItem::clearChildren()
 {
     auto parent = firstColumnIndex();
-    m_model->removeRows(0, m_model->rowCount(parent), parent);
+    if (!m_children->isEmpty())
+        m_model->removeRows(0, m_model->rowCount(parent), parent);
     for (auto child : *m_children) {
         delete child;
     }
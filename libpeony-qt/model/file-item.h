@@ -28,6 +28,7 @@
 
 #include <QObject>
 #include <QVector>
+#include <QHash>
 
 namespace Peony {
 
@@ -89,6 +90,46 @@ public:
 
     bool hasChildren();
 
+    /*!
+     * \brief suspend
+     * <br>
+     * Stop monitoring this item and its expanded children, cancel the pending
+     * enumeration and release the thumbnails of children. The children are kept
+     * as a snapshot of the directory.
+     * </br>
+     * \see catchUp().
+     */
+    void suspend();
+    /*!
+     * \brief catchUp
+     * <br>
+     * Compare the snapshot with the current directory contents after suspended.
+     * Only the removed, added and modified children are updated, and the monitor
+     * is started again. If the children were not found completely before suspended,
+     * they will be found again.
+     * </br>
+     */
+    void catchUp();
+
+    /*!
+     * \brief displayName
+     * \return the display name of info, or the file name of uri if the
+     * info has not been queried yet.
+     */
+    const QString displayName();
+
+    /*!
+     * \brief addExpandedView
+     * <br>
+     * A shared model might be shown in several tree views, which expand the item
+     * separately. Once the last of them collapses the item, removeExpandedView()
+     * releases the children and their monitors after a delay. They are kept if the
+     * item is expanded again during the delay.
+     * </br>
+     */
+    void addExpandedView();
+    void removeExpandedView();
+
 Q_SIGNALS:
     void cancelFindChildren();
     void childAdded(const QString &uri);
@@ -135,6 +176,39 @@ protected:
      */
     void updateInfoAsync();
 
+private:
+    void startMonitor();
+
+    /*!
+     * \brief probeChildren
+     * \param uris, the children to probe, all the children directories if empty.
+     * <br>
+     * Check whether the children directories have any entry in a batch, so that
+     * an empty directory will not show an expander in a tree view. It only works
+     * if the model can expand children.
+     * </br>
+     */
+    void probeChildren(const QStringList &uris = QStringList());
+    void queryDeferredInfo();
+    void releaseChildrenLater();
+
+    /*!
+     * \brief reloadChildren
+     * <br>
+     * Find the children again when the snapshot can not be caught up, the root
+     * item resets the model, others are collapsed.
+     * </br>
+     */
+    void reloadChildren();
+    /*!
+     * \brief updateModifiedChildren
+     * \param modifiedTimes, the local children's uris and modified times in snapshot.
+     * <br>
+     * Stat the children in a worker thread, and query the info of the modified ones.
+     * </br>
+     */
+    void updateModifiedChildren(const QHash<QString, quint64> &modifiedTimes);
+
 private:
     FileItem *m_parent = nullptr;
     std::shared_ptr<Peony::FileInfo> m_info;
@@ -143,6 +217,19 @@ private:
     FileItemModel *m_model = nullptr;
 
     bool m_expanded = false;
+    /*!
+     * \brief m_loaded
+     * true if the enumeration of children was finished without being cancelled.
+     */
+    bool m_loaded = false;
+
+    //true if this directory was probed without any entry.
+    bool m_is_empty = false;
+    //the info will be queried when the item is shown.
+    bool m_info_deferred = false;
+    int m_release_serial = 0;
+    //tree views which expand this item.
+    int m_expanded_views = 0;
 
     std::shared_ptr<FileWatcher> m_watcher = nullptr;
 
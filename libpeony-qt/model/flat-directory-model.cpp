@@ -0,0 +1,1289 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2019, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "flat-directory-model.h"
+#include "file-item-model.h"
+#include "file-item-proxy-filter-sort-model.h"
+
+#include "file-info.h"
+#include "file-info-job.h"
+#include "file-watcher.h"
+
+#include "file-operation-manager.h"
+#include "file-copy-operation.h"
+#include "file-operation-utils.h"
+#include "file-utils.h"
+
+#include "thumbnail-manager.h"
+#include "theme-icon-cache.h"
+#include "global-settings.h"
+
+#include <QMimeData>
+#include <QUrl>
+#include <QIcon>
+#include <QDateTime>
+
+#include <algorithm>
+
+#include <QDebug>
+
+#ifndef PEONY_FLAT_MODEL_BATCH_SIZE
+#define PEONY_FLAT_MODEL_BATCH_SIZE 1000
+#endif
+
+//about 25 thousands entries on ext4 and tmpfs.
+#ifndef PEONY_FLAT_MODEL_DIRECTORY_SIZE_THRESHOLD
+#define PEONY_FLAT_MODEL_DIRECTORY_SIZE_THRESHOLD 512*1024
+#endif
+
+//monitor events of a large directory usually come in bursts, such as
+//untarring into it, they are queried and applied in batches.
+#define PEONY_FLAT_MODEL_EVENT_INTERVAL 100
+
+//compact the columns once a quarter of the records are removed.
+#define PEONY_FLAT_MODEL_COMPACT_RATIO 4
+
+//use the fast content type, sniffing the content of every child
+//is much slower than enumerating itself.
+#define PEONY_FLAT_MODEL_ATTRIBUTES \
+    G_FILE_ATTRIBUTE_STANDARD_NAME "," \
+    G_FILE_ATTRIBUTE_STANDARD_TYPE "," \
+    G_FILE_ATTRIBUTE_STANDARD_SIZE "," \
+    G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE "," \
+    G_FILE_ATTRIBUTE_STANDARD_IS_HIDDEN "," \
+    G_FILE_ATTRIBUTE_STANDARD_IS_SYMLINK "," \
+    G_FILE_ATTRIBUTE_TIME_MODIFIED "," \
+    G_FILE_ATTRIBUTE_ACCESS_CAN_READ "," \
+    G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE "," \
+    G_FILE_ATTRIBUTE_ACCESS_CAN_EXECUTE
+
+using namespace Peony;
+
+FlatDirectoryModel::FlatDirectoryModel(QObject *parent) : QAbstractItemModel(parent)
+{
+    auto settings = GlobalSettings::getInstance();
+    m_show_hidden = settings->isExist("show-hidden")? settings->getValue("show-hidden").toBool(): false;
+    m_folder_first = settings->isExist("folder-first")? settings->getValue("folder-first").toBool(): true;
+    m_use_default_name_sort_order = settings->isExist("chinese-first")? settings->getValue("chinese-first").toBool(): false;
+
+    m_cancellable = g_cancellable_new();
+    m_check_cancellable = g_cancellable_new();
+    //rows painted in a view at most, with some margin.
+    m_row_cache.setMaxCost(1024);
+
+    m_event_timer.setSingleShot(true);
+    m_event_timer.setInterval(PEONY_FLAT_MODEL_EVENT_INTERVAL);
+    connect(&m_event_timer, &QTimer::timeout, this, &FlatDirectoryModel::flushEvents);
+}
+
+FlatDirectoryModel::~FlatDirectoryModel()
+{
+    clear();
+    g_object_unref(m_cancellable);
+    g_cancellable_cancel(m_check_cancellable);
+    g_object_unref(m_check_cancellable);
+}
+
+void FlatDirectoryModel::checkLargeDirectory(const QString &uri)
+{
+    g_cancellable_cancel(m_check_cancellable);
+    g_object_unref(m_check_cancellable);
+    m_check_cancellable = g_cancellable_new();
+
+    m_checking_uri = uri;
+    if (!uri.startsWith("file://")) {
+        Q_EMIT largeDirectoryChecked(uri, false);
+        return;
+    }
+
+    GFile *file = g_file_new_for_uri(uri.toUtf8().constData());
+    g_file_query_info_async(file,
+                            G_FILE_ATTRIBUTE_STANDARD_TYPE "," G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                            G_FILE_QUERY_INFO_NONE,
+                            G_PRIORITY_DEFAULT,
+                            m_check_cancellable,
+                            GAsyncReadyCallback(query_directory_size_async_callback),
+                            this);
+    g_object_unref(file);
+}
+
+GAsyncReadyCallback FlatDirectoryModel::query_directory_size_async_callback(GFile *file,
+                                                                            GAsyncResult *res,
+                                                                            FlatDirectoryModel *p_this)
+{
+    GError *err = nullptr;
+    GFileInfo *info = g_file_query_info_finish(file, res, &err);
+    if (err) {
+        //the model might have been deleted.
+        bool cancelled = g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+        g_error_free(err);
+        if (cancelled)
+            return nullptr;
+    }
+
+    bool isLarge = false;
+    if (info) {
+        isLarge = g_file_info_get_file_type(info) == G_FILE_TYPE_DIRECTORY &&
+                g_file_info_get_size(info) >= PEONY_FLAT_MODEL_DIRECTORY_SIZE_THRESHOLD;
+        g_object_unref(info);
+    }
+    Q_EMIT p_this->largeDirectoryChecked(p_this->m_checking_uri, isLarge);
+    return nullptr;
+}
+
+void FlatDirectoryModel::setRootUri(const QString &uri)
+{
+    beginResetModel();
+    clear();
+    m_suspended = false;
+    m_root_uri = uri;
+    m_root_file = g_file_new_for_uri(uri.toUtf8().constData());
+    endResetModel();
+
+    //monitor before enumerating, a child might be created during the loading.
+    //created children which have been enumerated will be handled as changed.
+    startMonitor();
+
+    m_loading = true;
+    Q_EMIT findChildrenStarted();
+    g_file_enumerate_children_async(m_root_file,
+                                    PEONY_FLAT_MODEL_ATTRIBUTES,
+                                    G_FILE_QUERY_INFO_NONE,
+                                    G_PRIORITY_DEFAULT,
+                                    m_cancellable,
+                                    GAsyncReadyCallback(enumerate_children_async_callback),
+                                    this);
+}
+
+void FlatDirectoryModel::cancelFindChildren()
+{
+    g_cancellable_cancel(m_cancellable);
+    g_object_unref(m_cancellable);
+    m_cancellable = g_cancellable_new();
+
+    if (m_loading) {
+        //keep the children we have found.
+        m_loading = false;
+        sort(m_sort_column, m_sort_order);
+        Q_EMIT findChildrenFinished();
+    }
+
+    //the records are caught up again when resumed.
+    m_catching_up = false;
+    m_stale_records.clear();
+
+    //the queries of monitor events are cancelled too, query them again.
+    for (auto uri : m_batch_uris) {
+        m_pending_query_uris<<uri;
+    }
+    resetEventBatch();
+    scheduleEvents();
+}
+
+void FlatDirectoryModel::clearChildren()
+{
+    beginResetModel();
+    clear();
+    m_root_uri = nullptr;
+    endResetModel();
+}
+
+void FlatDirectoryModel::suspend()
+{
+    if (m_suspended || m_root_uri.isNull())
+        return;
+
+    m_suspended = true;
+    cancelFindChildren();
+    m_watcher.reset();
+
+    //resume() will find the changes.
+    m_event_timer.stop();
+    m_pending_query_uris.clear();
+    m_pending_deleted_uris.clear();
+}
+
+void FlatDirectoryModel::resume()
+{
+    if (!m_suspended)
+        return;
+
+    m_suspended = false;
+    startMonitor();
+
+    //every record is stale until the enumeration finds it.
+    m_catching_up = true;
+    m_stale_records = QBitArray(m_name_offsets.count(), true);
+    g_file_enumerate_children_async(m_root_file,
+                                    PEONY_FLAT_MODEL_ATTRIBUTES,
+                                    G_FILE_QUERY_INFO_NONE,
+                                    G_PRIORITY_DEFAULT,
+                                    m_cancellable,
+                                    GAsyncReadyCallback(enumerate_children_async_callback),
+                                    this);
+}
+
+void FlatDirectoryModel::clear()
+{
+    g_cancellable_cancel(m_cancellable);
+    g_object_unref(m_cancellable);
+    m_cancellable = g_cancellable_new();
+    m_loading = false;
+    m_catching_up = false;
+    m_stale_records.clear();
+    m_generation++;
+
+    m_watcher.reset();
+    m_event_timer.stop();
+    m_pending_query_uris.clear();
+    m_pending_deleted_uris.clear();
+    resetEventBatch();
+    if (m_root_file) {
+        g_object_unref(m_root_file);
+        m_root_file = nullptr;
+    }
+
+    //assign rather than clear, so that the memory is released.
+    m_name_pool = QByteArray();
+    m_name_offsets = QVector<quint32>();
+    m_sizes = QVector<quint64>();
+    m_modified_times = QVector<quint64>();
+    m_type_ids = QVector<quint16>();
+    m_flags = QVector<quint8>();
+    m_removed_count = 0;
+    m_name_index = QVector<quint32>();
+    m_order = QVector<quint32>();
+    m_rows = QVector<qint32>();
+
+    m_row_cache.clear();
+    m_querying_uris.clear();
+}
+
+void FlatDirectoryModel::startMonitor()
+{
+    m_watcher = std::make_shared<FileWatcher>(m_root_uri);
+    m_watcher->setMonitorChildrenChange(true);
+    connect(m_watcher.get(), &FileWatcher::fileCreated, this, &FlatDirectoryModel::onChildCreated);
+    connect(m_watcher.get(), &FileWatcher::fileDeleted, this, &FlatDirectoryModel::onChildDeleted);
+    connect(m_watcher.get(), &FileWatcher::fileChanged, this, &FlatDirectoryModel::onChildChanged);
+    connect(m_watcher.get(), &FileWatcher::thumbnailUpdated, this, [=](const QString &uri){
+        int record = recordFromUri(uri);
+        if (record >= 0)
+            updateRecordRow(quint32(record));
+    });
+    m_watcher->startMonitor();
+}
+
+GAsyncReadyCallback FlatDirectoryModel::enumerate_children_async_callback(GFile *file,
+                                                                          GAsyncResult *res,
+                                                                          FlatDirectoryModel *p_this)
+{
+    GError *err = nullptr;
+    GFileEnumerator *enumerator = g_file_enumerate_children_finish(file, res, &err);
+    if (err) {
+        //the model might have been deleted.
+        if (g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            g_error_free(err);
+            return nullptr;
+        }
+        qDebug()<<"flat model enumerate children err:"<<err->code<<err->message;
+        g_error_free(err);
+    }
+
+    if (!enumerator) {
+        //the records can not be compared, load the directory again.
+        if (p_this->m_catching_up) {
+            p_this->setRootUri(p_this->m_root_uri);
+            return nullptr;
+        }
+        p_this->m_loading = false;
+        Q_EMIT p_this->findChildrenFinished();
+        return nullptr;
+    }
+
+    g_file_enumerator_next_files_async(enumerator,
+                                       PEONY_FLAT_MODEL_BATCH_SIZE,
+                                       G_PRIORITY_DEFAULT,
+                                       p_this->m_cancellable,
+                                       GAsyncReadyCallback(next_files_async_callback),
+                                       p_this);
+    g_object_unref(enumerator);
+    return nullptr;
+}
+
+GAsyncReadyCallback FlatDirectoryModel::next_files_async_callback(GFileEnumerator *enumerator,
+                                                                  GAsyncResult *res,
+                                                                  FlatDirectoryModel *p_this)
+{
+    GError *err = nullptr;
+    GList *files = g_file_enumerator_next_files_finish(enumerator, res, &err);
+    if (err) {
+        if (g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED)) {
+            g_error_free(err);
+            return nullptr;
+        }
+        qDebug()<<"flat model next files err:"<<err->code<<err->message;
+        g_error_free(err);
+    }
+
+    QVector<quint32> shownRecords;
+    for (GList *l = files; l; l = l->next) {
+        GFileInfo *info = static_cast<GFileInfo*>(l->data);
+        //the child might have been added by monitor, or kept while suspended.
+        int existingRecord = p_this->recordFromName(g_file_info_get_name(info));
+        if (existingRecord >= 0) {
+            if (p_this->m_catching_up)
+                p_this->catchUpRecord(quint32(existingRecord), info);
+            continue;
+        }
+        quint32 record = p_this->appendRecord(info);
+        if (p_this->isRecordVisible(record))
+            shownRecords<<record;
+    }
+    p_this->insertRecordRows(shownRecords);
+
+    if (files) {
+        g_list_free_full(files, g_object_unref);
+        g_file_enumerator_next_files_async(enumerator,
+                                           PEONY_FLAT_MODEL_BATCH_SIZE,
+                                           G_PRIORITY_DEFAULT,
+                                           p_this->m_cancellable,
+                                           GAsyncReadyCallback(next_files_async_callback),
+                                           p_this);
+        return nullptr;
+    }
+
+    if (p_this->m_catching_up) {
+        p_this->finishCatchingUp();
+        return nullptr;
+    }
+
+    //children were appended unsorted while loading, sort them once.
+    p_this->m_loading = false;
+    p_this->sort(p_this->m_sort_column, p_this->m_sort_order);
+    Q_EMIT p_this->findChildrenFinished();
+    return nullptr;
+}
+
+quint32 FlatDirectoryModel::appendRecord(GFileInfo *info)
+{
+    quint32 record = quint32(m_name_offsets.count());
+    const char *name = g_file_info_get_name(info);
+    m_name_offsets<<quint32(m_name_pool.size());
+    m_name_pool.append(name, int(qstrlen(name)) + 1);
+
+    m_sizes<<0;
+    m_modified_times<<0;
+    m_type_ids<<0;
+    m_flags<<0;
+    m_rows<<-1;
+    updateRecord(record, info);
+
+    //keep the name index at most half full.
+    if ((m_name_offsets.count()) * 2 > m_name_index.count()) {
+        int capacity = qMax(1024, m_name_index.count() * 2);
+        m_name_index = QVector<quint32>(capacity, 0);
+        for (int i = 0; i < m_name_offsets.count(); i++) {
+            insertNameIndex(quint32(i));
+        }
+    } else {
+        insertNameIndex(record);
+    }
+    return record;
+}
+
+void FlatDirectoryModel::updateRecord(quint32 record, GFileInfo *info)
+{
+    quint8 flags = 0;
+    if (g_file_info_get_file_type(info) == G_FILE_TYPE_DIRECTORY)
+        flags |= IsDir;
+    if (g_file_info_get_is_hidden(info) || rawName(record)[0] == '.')
+        flags |= IsHidden;
+    if (g_file_info_get_is_symlink(info))
+        flags |= IsSymbolLink;
+    if (!g_file_info_has_attribute(info, G_FILE_ATTRIBUTE_ACCESS_CAN_READ) ||
+            g_file_info_get_attribute_boolean(info, G_FILE_ATTRIBUTE_ACCESS_CAN_READ))
+        flags |= CanRead;
+    if (g_file_info_get_attribute_boolean(info, G_FILE_ATTRIBUTE_ACCESS_CAN_WRITE))
+        flags |= CanWrite;
+    if (g_file_info_get_attribute_boolean(info, G_FILE_ATTRIBUTE_ACCESS_CAN_EXECUTE))
+        flags |= CanExecute;
+
+    int i = int(record);
+    m_flags[i] = flags;
+    m_sizes[i] = g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_STANDARD_SIZE);
+    m_modified_times[i] = g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+    m_type_ids[i] = typeId(g_file_info_get_attribute_string(info, G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE));
+}
+
+quint16 FlatDirectoryModel::typeId(const char *contentType)
+{
+    QByteArray key = contentType? contentType: "application/octet-stream";
+    auto it = m_type_hash.constFind(key);
+    if (it != m_type_hash.constEnd())
+        return it.value();
+
+    //there are far less content types than this, but do not overflow.
+    if (m_types.count() == 0xffff)
+        return 0;
+
+    TypeEntry entry;
+    entry.contentType = key;
+    char *description = g_content_type_get_description(key.constData());
+    entry.description = description;
+    g_free(description);
+
+    GIcon *icon = g_content_type_get_icon(key.constData());
+    if (G_IS_THEMED_ICON(icon)) {
+        const gchar* const* iconNames = g_themed_icon_get_names(G_THEMED_ICON(icon));
+        for (auto p = iconNames; p && *p; p++) {
+            if (entry.iconName.isNull())
+                entry.iconName = *p;
+            if (QIcon::hasThemeIcon(*p)) {
+                entry.iconName = *p;
+                break;
+            }
+        }
+    }
+    if (icon)
+        g_object_unref(icon);
+
+    quint16 id = quint16(m_types.count());
+    m_types<<entry;
+    m_type_hash.insert(key, id);
+    return id;
+}
+
+void FlatDirectoryModel::insertNameIndex(quint32 record)
+{
+    const char *name = rawName(record);
+    uint mask = uint(m_name_index.count() - 1);
+    uint slot = qHashBits(name, qstrlen(name)) & mask;
+    while (m_name_index.at(int(slot)) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    //0 means empty.
+    m_name_index[int(slot)] = record + 1;
+}
+
+int FlatDirectoryModel::recordFromName(const char *name) const
+{
+    if (!name || m_name_index.isEmpty())
+        return -1;
+
+    uint mask = uint(m_name_index.count() - 1);
+    uint slot = qHashBits(name, qstrlen(name)) & mask;
+    while (quint32 stored = m_name_index.at(int(slot))) {
+        quint32 record = stored - 1;
+        //removed records are kept in index, skip them.
+        if (!(m_flags.at(int(record)) & IsRemoved) && qstrcmp(rawName(record), name) == 0)
+            return int(record);
+        slot = (slot + 1) & mask;
+    }
+    return -1;
+}
+
+int FlatDirectoryModel::recordFromUri(const QString &uri) const
+{
+    GFile *file = g_file_new_for_uri(uri.toUtf8().constData());
+    char *name = g_file_get_basename(file);
+    g_object_unref(file);
+    int record = recordFromName(name);
+    g_free(name);
+    return record;
+}
+
+const QString FlatDirectoryModel::displayName(quint32 record) const
+{
+    char *name = g_filename_display_name(rawName(record));
+    QString displayName = name;
+    g_free(name);
+    return displayName;
+}
+
+const QString FlatDirectoryModel::recordUri(quint32 record) const
+{
+    GFile *child = g_file_get_child(m_root_file, rawName(record));
+    char *uri = g_file_get_uri(child);
+    g_object_unref(child);
+    //keep the same form as FileInfo::uri().
+    QString displayUri = QUrl(uri).toDisplayString();
+    g_free(uri);
+    return displayUri;
+}
+
+FlatDirectoryModel::RowStrings *FlatDirectoryModel::rowStrings(quint32 record) const
+{
+    if (auto strings = m_row_cache.object(record))
+        return strings;
+
+    auto strings = new RowStrings;
+    strings->uri = recordUri(record);
+    strings->displayName = displayName(record);
+
+    char *size = g_format_size_full(m_sizes.at(int(record)), G_FORMAT_SIZE_DEFAULT);
+    strings->fileSize = size;
+    g_free(size);
+
+    QDateTime date = QDateTime::fromMSecsSinceEpoch(qint64(m_modified_times.at(int(record)))*1000);
+    strings->modifiedDate = date.toString(Qt::SystemLocaleShortDate);
+
+    m_row_cache.insert(record, strings);
+    return strings;
+}
+
+void FlatDirectoryModel::updateRecordRow(quint32 record)
+{
+    m_row_cache.remove(record);
+    int row = m_rows.at(int(record));
+    if (row < 0)
+        return;
+    Q_EMIT dataChanged(index(row, FileItemModel::FileName), index(row, FileItemModel::ModifiedDate));
+}
+
+bool FlatDirectoryModel::isRecordVisible(quint32 record) const
+{
+    quint8 flags = m_flags.at(int(record));
+    if (flags & IsRemoved)
+        return false;
+    if (!m_show_hidden && (flags & IsHidden))
+        return false;
+    return true;
+}
+
+bool FlatDirectoryModel::recordLessThan(quint32 left, quint32 right, const QVector<QString> *nameKeys) const
+{
+    int l = int(left);
+    int r = int(right);
+    if (m_folder_first) {
+        //folders are always in front of files, whatever the sort order is.
+        bool leftIsDir = m_flags.at(l) & IsDir;
+        bool rightIsDir = m_flags.at(r) & IsDir;
+        if (leftIsDir != rightIsDir)
+            return leftIsDir;
+    }
+
+    int result = 0;
+    switch (m_sort_column) {
+    case FileItemModel::FileSize: {
+        if (m_sizes.at(l) != m_sizes.at(r))
+            result = m_sizes.at(l) < m_sizes.at(r)? -1: 1;
+        break;
+    }
+    case FileItemModel::FileType: {
+        result = m_types.at(m_type_ids.at(l)).description.compare(m_types.at(m_type_ids.at(r)).description);
+        break;
+    }
+    case FileItemModel::ModifiedDate: {
+        if (m_modified_times.at(l) != m_modified_times.at(r))
+            result = m_modified_times.at(l) < m_modified_times.at(r)? -1: 1;
+        break;
+    }
+    default:
+        break;
+    }
+
+    //compare names if the sort column is name, or the column values are same.
+    //names are compared as FileItemProxyFilterSortModel does.
+    if (result == 0) {
+        const QString leftName = nameKeys? nameKeys->at(l): displayName(left);
+        const QString rightName = nameKeys? nameKeys->at(r): displayName(right);
+        if (FileItemProxyFilterSortModel::nameLessThan(leftName, rightName, m_use_default_name_sort_order, m_sort_order)) {
+            result = -1;
+        } else if (FileItemProxyFilterSortModel::nameLessThan(rightName, leftName, m_use_default_name_sort_order, m_sort_order)) {
+            result = 1;
+        }
+    }
+
+    return m_sort_order == Qt::AscendingOrder? result < 0: result > 0;
+}
+
+void FlatDirectoryModel::rebuildRows(int from)
+{
+    for (int row = from; row < m_order.count(); row++) {
+        m_rows[int(m_order.at(row))] = row;
+    }
+}
+
+void FlatDirectoryModel::sort(int column, Qt::SortOrder order)
+{
+    m_sort_column = column < 0? FileItemModel::FileName: column;
+    m_sort_order = order;
+
+    //children will be sorted once when loading finished.
+    if (m_loading)
+        return;
+
+    Q_EMIT layoutAboutToBeChanged();
+
+    auto oldIndexes = persistentIndexList();
+    QVector<quint32> oldRecords;
+    for (auto index : oldIndexes) {
+        oldRecords<<m_order.at(index.row());
+    }
+
+    //decode every name once rather than in each comparing.
+    QVector<QString> nameKeys(m_name_offsets.count());
+    for (auto record : m_order) {
+        nameKeys[int(record)] = displayName(record);
+    }
+    std::stable_sort(m_order.begin(), m_order.end(), [&](quint32 left, quint32 right) {
+        return recordLessThan(left, right, &nameKeys);
+    });
+    rebuildRows();
+
+    QModelIndexList newIndexes;
+    for (int i = 0; i < oldIndexes.count(); i++) {
+        newIndexes<<createIndex(m_rows.at(int(oldRecords.at(i))), oldIndexes.at(i).column());
+    }
+    changePersistentIndexList(oldIndexes, newIndexes);
+
+    Q_EMIT layoutChanged();
+}
+
+void FlatDirectoryModel::setShowHidden(bool showHidden)
+{
+    if (m_show_hidden == showHidden)
+        return;
+
+    m_show_hidden = showHidden;
+
+    beginResetModel();
+    m_order.clear();
+    for (int record = 0; record < m_name_offsets.count(); record++) {
+        m_rows[record] = -1;
+        if (isRecordVisible(quint32(record)))
+            m_order<<quint32(record);
+    }
+    rebuildRows();
+    endResetModel();
+
+    sort(m_sort_column, m_sort_order);
+}
+
+void FlatDirectoryModel::setFolderFirst(bool folderFirst)
+{
+    if (m_folder_first == folderFirst)
+        return;
+
+    m_folder_first = folderFirst;
+    sort(m_sort_column, m_sort_order);
+}
+
+void FlatDirectoryModel::setUseDefaultNameSortOrder(bool use)
+{
+    if (m_use_default_name_sort_order == use)
+        return;
+
+    m_use_default_name_sort_order = use;
+    sort(m_sort_column, m_sort_order);
+}
+
+void FlatDirectoryModel::onChildCreated(const QString &uri)
+{
+    //a created child which has been enumerated will be updated.
+    m_pending_query_uris<<uri;
+    scheduleEvents();
+}
+
+void FlatDirectoryModel::onChildDeleted(const QString &uri)
+{
+    m_pending_deleted_uris<<uri;
+    scheduleEvents();
+}
+
+void FlatDirectoryModel::onChildChanged(const QString &uri)
+{
+    if (recordFromUri(uri) < 0)
+        return;
+
+    m_pending_query_uris<<uri;
+    scheduleEvents();
+}
+
+void FlatDirectoryModel::scheduleEvents()
+{
+    if (m_pending_query_uris.isEmpty() && m_pending_deleted_uris.isEmpty())
+        return;
+    //the events received meanwhile are applied after the querying batch.
+    if (m_event_timer.isActive() || m_batch_querying_count > 0)
+        return;
+    m_event_timer.start();
+}
+
+void FlatDirectoryModel::flushEvents()
+{
+    //deleted children are removed first, a child which was deleted and
+    //created again is queried and added back.
+    if (!m_pending_deleted_uris.isEmpty()) {
+        QVector<quint32> deletedRecords;
+        for (auto uri : m_pending_deleted_uris) {
+            int record = recordFromUri(uri);
+            if (record >= 0)
+                deletedRecords<<quint32(record);
+        }
+        m_pending_deleted_uris.clear();
+        removeRecords(deletedRecords);
+    }
+
+    if (m_pending_query_uris.isEmpty())
+        return;
+
+    m_batch_uris = m_pending_query_uris.toList();
+    m_pending_query_uris.clear();
+    m_batch_querying_count = m_batch_uris.count();
+    for (auto uri : m_batch_uris) {
+        GFile *file = g_file_new_for_uri(uri.toUtf8().constData());
+        g_file_query_info_async(file,
+                                PEONY_FLAT_MODEL_ATTRIBUTES,
+                                G_FILE_QUERY_INFO_NONE,
+                                G_PRIORITY_DEFAULT,
+                                m_cancellable,
+                                GAsyncReadyCallback(query_info_async_callback),
+                                this);
+        g_object_unref(file);
+    }
+}
+
+GAsyncReadyCallback FlatDirectoryModel::query_info_async_callback(GFile *file,
+                                                                  GAsyncResult *res,
+                                                                  FlatDirectoryModel *p_this)
+{
+    GError *err = nullptr;
+    GFileInfo *info = g_file_query_info_finish(file, res, &err);
+    if (err) {
+        //the model might have been deleted.
+        bool cancelled = g_error_matches(err, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+        g_error_free(err);
+        if (cancelled)
+            return nullptr;
+    }
+
+    //the child might have been deleted again.
+    if (info)
+        p_this->m_queried_infos<<info;
+
+    p_this->m_batch_querying_count--;
+    if (p_this->m_batch_querying_count == 0)
+        p_this->applyQueriedInfos();
+    return nullptr;
+}
+
+void FlatDirectoryModel::applyQueriedInfos()
+{
+    auto infos = m_queried_infos;
+    m_queried_infos.clear();
+    m_batch_uris.clear();
+
+    QVector<quint32> createdRecords;
+    int firstChangedRow = -1;
+    int lastChangedRow = -1;
+    for (auto info : infos) {
+        int record = recordFromName(g_file_info_get_name(info));
+        if (record < 0) {
+            quint32 created = appendRecord(info);
+            if (isRecordVisible(created))
+                createdRecords<<created;
+        } else {
+            updateRecord(quint32(record), info);
+            m_row_cache.remove(quint32(record));
+            int row = m_rows.at(record);
+            if (row >= 0) {
+                refreshSharedInfo(recordUri(quint32(record)));
+                firstChangedRow = firstChangedRow < 0? row: qMin(firstChangedRow, row);
+                lastChangedRow = qMax(lastChangedRow, row);
+            }
+        }
+        g_object_unref(info);
+    }
+
+    if (lastChangedRow >= 0)
+        Q_EMIT dataChanged(index(firstChangedRow, FileItemModel::FileName), index(lastChangedRow, FileItemModel::ModifiedDate));
+    insertRecordRows(createdRecords);
+
+    scheduleEvents();
+}
+
+void FlatDirectoryModel::resetEventBatch()
+{
+    for (auto info : m_queried_infos) {
+        g_object_unref(info);
+    }
+    m_queried_infos.clear();
+    m_batch_uris.clear();
+    m_batch_querying_count = 0;
+}
+
+void FlatDirectoryModel::insertRecordRows(QVector<quint32> records)
+{
+    if (records.isEmpty())
+        return;
+
+    if (m_loading) {
+        //children are appended unsorted while loading, they will be sorted once.
+        int first = m_order.count();
+        beginInsertRows(QModelIndex(), first, first + records.count() - 1);
+        for (auto record : records) {
+            m_rows[int(record)] = m_order.count();
+            m_order<<record;
+        }
+        endInsertRows();
+        return;
+    }
+
+    //insert at the sorted positions, do not resort all children. the sorted records
+    //are inserted in runs of adjacent rows, and the records of the rows after the
+    //first run are mapped once for the whole batch.
+    auto lessThan = [=](quint32 left, quint32 right) {
+        return recordLessThan(left, right, nullptr);
+    };
+    std::stable_sort(records.begin(), records.end(), lessThan);
+
+    int firstRow = m_order.count();
+    int from = 0;
+    int i = 0;
+    while (i < records.count()) {
+        auto it = std::upper_bound(m_order.begin() + from, m_order.end(), records.at(i), lessThan);
+        int row = int(it - m_order.begin());
+        int next = i + 1;
+        while (next < records.count() && (row == m_order.count() || lessThan(records.at(next), m_order.at(row))))
+            next++;
+
+        int count = next - i;
+        beginInsertRows(QModelIndex(), row, row + count - 1);
+        m_order.insert(row, count, 0);
+        for (int j = 0; j < count; j++) {
+            m_order[row + j] = records.at(i + j);
+        }
+        endInsertRows();
+
+        firstRow = qMin(firstRow, row);
+        from = row + count;
+        i = next;
+    }
+    rebuildRows(firstRow);
+}
+
+void FlatDirectoryModel::removeRecords(const QVector<quint32> &records)
+{
+    QVector<int> removedRows;
+    for (auto record : records) {
+        int i = int(record);
+        if (m_flags.at(i) & IsRemoved)
+            continue;
+        m_flags[i] |= IsRemoved;
+        m_removed_count++;
+        m_row_cache.remove(record);
+        if (m_rows.at(i) >= 0)
+            removedRows<<m_rows.at(i);
+    }
+
+    //remove the rows in runs of adjacent rows from the bottom, so that the rows
+    //above stay valid. the rows below are mapped once after all runs.
+    std::sort(removedRows.begin(), removedRows.end());
+    int last = removedRows.count() - 1;
+    while (last >= 0) {
+        int first = last;
+        while (first > 0 && removedRows.at(first - 1) == removedRows.at(first) - 1)
+            first--;
+        int row = removedRows.at(first);
+        int count = last - first + 1;
+        beginRemoveRows(QModelIndex(), row, row + count - 1);
+        for (int i = row; i < row + count; i++) {
+            m_rows[int(m_order.at(i))] = -1;
+        }
+        m_order.remove(row, count);
+        endRemoveRows();
+        last = first - 1;
+    }
+    if (!removedRows.isEmpty())
+        rebuildRows(removedRows.first());
+
+    if (m_removed_count * PEONY_FLAT_MODEL_COMPACT_RATIO > m_name_offsets.count())
+        compact();
+}
+
+void FlatDirectoryModel::compact()
+{
+    //the stale records of resume() are indexed by record.
+    if (m_removed_count == 0 || m_catching_up)
+        return;
+
+    int count = m_name_offsets.count() - m_removed_count;
+    QVector<qint32> newRecords(m_name_offsets.count(), -1);
+    QByteArray namePool;
+    QVector<quint32> nameOffsets;
+    QVector<quint64> sizes;
+    QVector<quint64> modifiedTimes;
+    QVector<quint16> typeIds;
+    QVector<quint8> flags;
+    QVector<qint32> rows;
+    nameOffsets.reserve(count);
+    sizes.reserve(count);
+    modifiedTimes.reserve(count);
+    typeIds.reserve(count);
+    flags.reserve(count);
+    rows.reserve(count);
+
+    for (int record = 0; record < m_name_offsets.count(); record++) {
+        if (m_flags.at(record) & IsRemoved)
+            continue;
+        newRecords[record] = nameOffsets.count();
+        const char *name = rawName(quint32(record));
+        nameOffsets<<quint32(namePool.size());
+        namePool.append(name, int(qstrlen(name)) + 1);
+        sizes<<m_sizes.at(record);
+        modifiedTimes<<m_modified_times.at(record);
+        typeIds<<m_type_ids.at(record);
+        flags<<m_flags.at(record);
+        rows<<m_rows.at(record);
+    }
+
+    //the rows are not changed, only the records they point to.
+    for (auto &record : m_order) {
+        record = quint32(newRecords.at(int(record)));
+    }
+
+    m_name_pool = namePool;
+    m_name_offsets = nameOffsets;
+    m_sizes = sizes;
+    m_modified_times = modifiedTimes;
+    m_type_ids = typeIds;
+    m_flags = flags;
+    m_rows = rows;
+    m_removed_count = 0;
+    m_row_cache.clear();
+
+    int capacity = 1024;
+    while (capacity < count * 2) {
+        capacity *= 2;
+    }
+    m_name_index = QVector<quint32>(capacity, 0);
+    for (int record = 0; record < count; record++) {
+        insertNameIndex(quint32(record));
+    }
+}
+
+void FlatDirectoryModel::refreshSharedInfo(const QString &uri)
+{
+    //the shared info should be queried again when it is painted.
+    auto fileInfo = FileInfo::fromUri(uri);
+    if (!fileInfo->isEmptyInfo() && !m_querying_uris.contains(uri)) {
+        auto job = new FileInfoJob(fileInfo);
+        job->setAutoDelete();
+        job->queryAsync();
+    }
+}
+
+void FlatDirectoryModel::catchUpRecord(quint32 record, GFileInfo *info)
+{
+    if (int(record) < m_stale_records.size())
+        m_stale_records.clearBit(int(record));
+
+    int i = int(record);
+    quint64 size = g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_STANDARD_SIZE);
+    quint64 modifiedTime = g_file_info_get_attribute_uint64(info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+    if (size == m_sizes.at(i) && modifiedTime == m_modified_times.at(i))
+        return;
+
+    updateRecord(record, info);
+    if (m_rows.at(i) >= 0)
+        refreshSharedInfo(recordUri(record));
+    updateRecordRow(record);
+}
+
+void FlatDirectoryModel::finishCatchingUp()
+{
+    m_catching_up = false;
+
+    //remove the records which were not found.
+    QVector<quint32> staleRecords;
+    for (int record = 0; record < m_stale_records.size(); record++) {
+        if (m_stale_records.testBit(record))
+            staleRecords<<quint32(record);
+    }
+    m_stale_records.clear();
+    removeRecords(staleRecords);
+
+    //drop the records removed before and while suspended.
+    compact();
+}
+
+const QModelIndex FlatDirectoryModel::indexFromUri(const QString &uri)
+{
+    int record = recordFromUri(uri);
+    if (record < 0)
+        return QModelIndex();
+    int row = m_rows.at(record);
+    if (row < 0)
+        return QModelIndex();
+    return createIndex(row, FileItemModel::FileName);
+}
+
+const QString FlatDirectoryModel::uriAt(int row) const
+{
+    if (row < 0 || row >= m_order.count())
+        return nullptr;
+    return rowStrings(m_order.at(row))->uri;
+}
+
+FlatDirectoryModel::RecordFlags FlatDirectoryModel::flagsAt(int row) const
+{
+    if (row < 0 || row >= m_order.count())
+        return RecordFlags();
+    return RecordFlags(QFlag(m_flags.at(int(m_order.at(row)))));
+}
+
+std::shared_ptr<FileInfo> FlatDirectoryModel::infoAt(int row)
+{
+    if (row < 0 || row >= m_order.count())
+        return nullptr;
+
+    const QString uri = rowStrings(m_order.at(row))->uri;
+    auto info = FileInfo::fromUri(uri);
+    if (!info->isEmptyInfo() || m_querying_uris.contains(uri))
+        return info;
+
+    m_querying_uris<<uri;
+    quint32 generation = m_generation;
+    auto job = new FileInfoJob(info);
+    job->setAutoDelete();
+    connect(job, &FileInfoJob::queryAsyncFinished, this, [=](){
+        //the root might have been changed.
+        if (generation != m_generation)
+            return;
+        m_querying_uris.remove(uri);
+        //the records might have been compacted.
+        int record = recordFromUri(uri);
+        if (record >= 0)
+            updateRecordRow(quint32(record));
+        auto mimeType = info->mimeType();
+        if (mimeType.startsWith("image/") || mimeType.contains("pdf")) {
+            ThumbnailManager::getInstance()->createThumbnail(uri, m_watcher);
+        }
+    });
+    job->queryAsync();
+    return info;
+}
+
+QStringList FlatDirectoryModel::getAllFileUris()
+{
+    QStringList uris;
+    uris.reserve(m_order.count());
+    for (auto record : m_order) {
+        uris<<recordUri(record);
+    }
+    return uris;
+}
+
+QModelIndex FlatDirectoryModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return QModelIndex();
+    if (row < 0 || row >= m_order.count() || column < 0 || column >= columnCount())
+        return QModelIndex();
+    return createIndex(row, column);
+}
+
+QModelIndex FlatDirectoryModel::parent(const QModelIndex &child) const
+{
+    Q_UNUSED(child);
+    return QModelIndex();
+}
+
+int FlatDirectoryModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return 0;
+    return m_order.count();
+}
+
+int FlatDirectoryModel::columnCount(const QModelIndex &parent) const
+{
+    Q_UNUSED(parent);
+    return FileItemModel::ModifiedDate+1;
+}
+
+QVariant FlatDirectoryModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_order.count())
+        return QVariant();
+
+    quint32 record = m_order.at(index.row());
+    int i = int(record);
+
+    if (role == FileItemModel::UriRole)
+        return QVariant(rowStrings(record)->uri);
+
+    switch (index.column()) {
+    case FileItemModel::FileName: {
+        switch (role) {
+        case Qt::TextAlignmentRole:
+            return QVariant(Qt::AlignHCenter | Qt::AlignBaseline);
+        case Qt::DisplayRole:
+        case Qt::ToolTipRole:
+            return QVariant(rowStrings(record)->displayName);
+        case Qt::DecorationRole: {
+            auto thumbnail = ThumbnailManager::getInstance()->tryGetThumbnail(rowStrings(record)->uri);
+            if (!thumbnail.isNull())
+                return thumbnail;
+            auto iconName = m_types.at(m_type_ids.at(i)).iconName;
+            return QVariant(ThemeIconCache::getInstance()->icon(iconName, "text-x-generic"));
+        }
+        default:
+            return QVariant();
+        }
+    }
+    case FileItemModel::FileSize: {
+        if (role == Qt::DisplayRole && !(m_flags.at(i) & IsDir))
+            return QVariant(rowStrings(record)->fileSize);
+        return QVariant();
+    }
+    case FileItemModel::FileType: {
+        if (role != Qt::DisplayRole)
+            return QVariant();
+        auto description = m_types.at(m_type_ids.at(i)).description;
+        if (m_flags.at(i) & IsSymbolLink)
+            return QVariant(tr("Symbol Link, ") + description);
+        return QVariant(description);
+    }
+    case FileItemModel::ModifiedDate: {
+        if (role == Qt::DisplayRole)
+            return QVariant(rowStrings(record)->modifiedDate);
+        return QVariant();
+    }
+    default:
+        return QVariant();
+    }
+}
+
+QVariant FlatDirectoryModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation == Qt::Vertical)
+        return QVariant();
+    if (role == Qt::DisplayRole) {
+        switch (section) {
+        case FileItemModel::FileName:
+            return tr("File Name");
+        case FileItemModel::FileSize:
+            return tr("File Size");
+        case FileItemModel::FileType:
+            return tr("File Type");
+        case FileItemModel::ModifiedDate:
+            return tr("Modified Date");
+        default:
+            return QVariant();
+        }
+    }
+    return QAbstractItemModel::headerData(section, orientation, role);
+}
+
+bool FlatDirectoryModel::hasChildren(const QModelIndex &parent) const
+{
+    return !parent.isValid();
+}
+
+Qt::ItemFlags FlatDirectoryModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid())
+        return Qt::ItemIsDropEnabled;
+
+    Qt::ItemFlags flags = QAbstractItemModel::flags(index);
+    if (flagsAt(index.row()) & IsDir) {
+        flags |= Qt::ItemIsDropEnabled;
+    }
+    if (index.column() == FileItemModel::FileName) {
+        flags |= Qt::ItemIsDragEnabled;
+        flags |= Qt::ItemIsEditable;
+    }
+    return flags;
+}
+
+QMimeData *FlatDirectoryModel::mimeData(const QModelIndexList &indexes) const
+{
+    //only urls are used in dnd, do not encode the item data of
+    //every index, there might be a huge selection.
+    QMimeData *data = new QMimeData;
+    QList<QUrl> urls;
+    for (auto index : indexes) {
+        if (index.column() == FileItemModel::FileName)
+            urls<<QUrl(uriAt(index.row()));
+    }
+    data->setUrls(urls);
+    return data;
+}
+
+bool FlatDirectoryModel::dropMimeData(const QMimeData *data, Qt::DropAction action, int row, int column, const QModelIndex &parent)
+{
+    Q_UNUSED(row);
+    Q_UNUSED(column);
+
+    QString destDirUri = nullptr;
+    if (parent.isValid()) {
+        //drop on a folder item.
+        if (flagsAt(parent.row()) & IsDir)
+            destDirUri = uriAt(parent.row());
+    } else {
+        destDirUri = m_root_uri;
+        auto targetUri = FileUtils::getTargetUri(destDirUri);
+        if (!targetUri.isEmpty()) {
+            destDirUri = targetUri;
+        }
+    }
+
+    if (destDirUri.isNull())
+        return false;
+
+    auto urls = data->urls();
+    if (urls.isEmpty())
+        return false;
+
+    QStringList srcUris;
+    for (auto url : urls) {
+        srcUris<<url.url();
+    }
+
+    //do not allow drop on it self.
+    if (srcUris.contains(destDirUri))
+        return false;
+
+    switch (action) {
+    case Qt::MoveAction: {
+        FileOperationUtils::move(srcUris, destDirUri, true, true);
+        break;
+    }
+    case Qt::CopyAction: {
+        FileCopyOperation *copyOp = new FileCopyOperation(srcUris, destDirUri);
+        FileOperationManager::getInstance()->startOperation(copyOp);
+        break;
+    }
+    default:
+        break;
+    }
+
+    return true;
+}
+
+Qt::DropActions FlatDirectoryModel::supportedDropActions() const
+{
+    return Qt::MoveAction;
+}
@@ -0,0 +1,301 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2019, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef FLATDIRECTORYMODEL_H
+#define FLATDIRECTORYMODEL_H
+
+#include <QAbstractItemModel>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+#include <QCache>
+#include <QBitArray>
+#include <QTimer>
+
+#include <memory>
+#include <gio/gio.h>
+
+#include "peony-core_global.h"
+
+namespace Peony {
+
+class FileInfo;
+class FileWatcher;
+
+/*!
+ * \brief The FlatDirectoryModel class
+ * <br>
+ * FlatDirectoryModel is a model for showing the children of a single, usually
+ * very large, directory. Unlike FileItemModel, it doesn't create a FileItem and
+ * a FileInfo for each child. The enumerated children are stored in columns,
+ * the names in a single string pool and the sizes, modified times, type ids
+ * and flags in plain vectors, which costs less than a hundred bytes for each row.
+ * </br>
+ * <br>
+ * Strings shown in view, such as uri, display name and formatted size, are only
+ * created for the rows which are painted and kept in a small cache. A FileInfo is
+ * only materialized by infoAt(), which is called by delegates for the visible rows.
+ * Sorting and hidden files filtering are done in model itself by reordering
+ * a row to record permutation, so there is no need of a proxy model.
+ * </br>
+ * <br>
+ * The changes of children reported by monitor are queried asynchronously and
+ * applied in batches, and the removed records are dropped from the columns once
+ * there are many of them, so that a busy directory doesn't block the ui or grow
+ * the model without bound.
+ * </br>
+ * \note
+ * This model exposes the same columns and roles as FileItemModel, but it can not
+ * expand children, and the label, type, time and size filters of
+ * FileItemProxyFilterSortModel are not supported.
+ * \see FileItemModel, DirectoryViewIface::bindFlatModel().
+ */
+class PEONYCORESHARED_EXPORT FlatDirectoryModel : public QAbstractItemModel
+{
+    Q_OBJECT
+public:
+    enum RecordFlag {
+        IsDir = 1 << 0,
+        IsHidden = 1 << 1,
+        IsSymbolLink = 1 << 2,
+        CanRead = 1 << 3,
+        CanWrite = 1 << 4,
+        CanExecute = 1 << 5,
+        IsRemoved = 1 << 6
+    };
+    Q_DECLARE_FLAGS(RecordFlags, RecordFlag)
+
+    explicit FlatDirectoryModel(QObject *parent = nullptr);
+    ~FlatDirectoryModel() override;
+
+    /*!
+     * \brief checkLargeDirectory
+     * \param uri
+     * \details
+     * Check if uri is a local directory which is large enough to be shown with
+     * a FlatDirectoryModel rather than a FileItemModel, largeDirectoryChecked()
+     * will be emitted. The directory is queried asynchronously, so that a hung
+     * mount doesn't block the navigation. A check not finished yet is cancelled.
+     * <br>
+     * We can not know the children count before enumerating, so the size of the
+     * directory inode is used as an estimation. Most of local file systems
+     * grows the directory size with the number of entries.
+     * </br>
+     */
+    void checkLargeDirectory(const QString &uri);
+
+    const QString getRootUri() {return m_root_uri;}
+    void setRootUri(const QString &uri);
+    void cancelFindChildren();
+    /*!
+     * \brief clearChildren
+     * <br>
+     * Stop loading and monitoring, and release all the children's data.
+     * </br>
+     */
+    void clearChildren();
+
+    /*!
+     * \brief suspend
+     * <br>
+     * Stop loading and monitoring while the view is hidden, the children found
+     * are kept. resume() enumerates the directory again and compares it with the
+     * records: only the removed, added and modified children are updated, so the
+     * rows, selections and scroll position of views are kept.
+     * </br>
+     */
+    void suspend();
+    void resume();
+    bool isSuspended() {return m_suspended;}
+
+    void setShowHidden(bool showHidden);
+    void setFolderFirst(bool folderFirst);
+    void setUseDefaultNameSortOrder(bool use);
+
+    const QModelIndex indexFromUri(const QString &uri);
+    const QString uriAt(int row) const;
+    RecordFlags flagsAt(int row) const;
+
+    /*!
+     * \brief infoAt
+     * \param row
+     * \return the shared file info of row.
+     * \details
+     * The info is queried asynchronously if it is not queried yet, the row
+     * will be updated when query finished. Use this method only for the
+     * rows which are visible.
+     */
+    std::shared_ptr<FileInfo> infoAt(int row);
+
+    QStringList getAllFileUris();
+
+    int sortColumn() const {return m_sort_column;}
+    Qt::SortOrder sortOrder() const {return m_sort_order;}
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex &child) const override;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    QVariant data(const QModelIndex &index, int role) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role) const override;
+
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+    QMimeData *mimeData(const QModelIndexList& indexes) const override;
+    bool dropMimeData(const QMimeData *data, Qt::DropAction action,
+                      int row, int column, const QModelIndex &parent) override;
+    Qt::DropActions supportedDropActions() const override;
+
+Q_SIGNALS:
+    void findChildrenStarted();
+    void findChildrenFinished();
+    void largeDirectoryChecked(const QString &uri, bool isLarge);
+
+protected:
+    static GAsyncReadyCallback enumerate_children_async_callback(GFile *file,
+                                                                 GAsyncResult *res,
+                                                                 FlatDirectoryModel *p_this);
+
+    static GAsyncReadyCallback next_files_async_callback(GFileEnumerator *enumerator,
+                                                         GAsyncResult *res,
+                                                         FlatDirectoryModel *p_this);
+
+    static GAsyncReadyCallback query_info_async_callback(GFile *file,
+                                                         GAsyncResult *res,
+                                                         FlatDirectoryModel *p_this);
+
+    static GAsyncReadyCallback query_directory_size_async_callback(GFile *file,
+                                                                   GAsyncResult *res,
+                                                                   FlatDirectoryModel *p_this);
+
+    void onChildCreated(const QString &uri);
+    void onChildDeleted(const QString &uri);
+    void onChildChanged(const QString &uri);
+
+private:
+    struct TypeEntry {
+        QByteArray contentType;
+        QString description;
+        QString iconName;
+    };
+
+    struct RowStrings {
+        QString uri;
+        QString displayName;
+        QString fileSize;
+        QString modifiedDate;
+    };
+
+    void clear();
+    void startMonitor();
+
+    quint32 appendRecord(GFileInfo *info);
+    void updateRecord(quint32 record, GFileInfo *info);
+    void insertRecordRows(QVector<quint32> records);
+    void removeRecords(const QVector<quint32> &records);
+    void compact();
+    void refreshSharedInfo(const QString &uri);
+
+    void scheduleEvents();
+    void flushEvents();
+    void applyQueriedInfos();
+    void resetEventBatch();
+
+    void catchUpRecord(quint32 record, GFileInfo *info);
+    void finishCatchingUp();
+    quint16 typeId(const char *contentType);
+
+    void insertNameIndex(quint32 record);
+    int recordFromName(const char *name) const;
+    int recordFromUri(const QString &uri) const;
+    const char *rawName(quint32 record) const {return m_name_pool.constData() + m_name_offsets.at(int(record));}
+    const QString displayName(quint32 record) const;
+    const QString recordUri(quint32 record) const;
+    RowStrings *rowStrings(quint32 record) const;
+    void updateRecordRow(quint32 record);
+
+    bool isRecordVisible(quint32 record) const;
+    bool recordLessThan(quint32 left, quint32 right, const QVector<QString> *nameKeys) const;
+    void rebuildRows(int from = 0);
+
+private:
+    QString m_root_uri;
+    GFile *m_root_file = nullptr;
+    GCancellable *m_cancellable = nullptr;
+    std::shared_ptr<FileWatcher> m_watcher;
+    bool m_loading = false;
+    bool m_suspended = false;
+    bool m_catching_up = false;
+    //records not found yet by the enumeration of resume().
+    QBitArray m_stale_records;
+    quint32 m_generation = 0;
+
+    //the monitor events are queried and applied in batches.
+    QTimer m_event_timer;
+    QSet<QString> m_pending_query_uris;
+    QSet<QString> m_pending_deleted_uris;
+    QStringList m_batch_uris;
+    QList<GFileInfo*> m_queried_infos;
+    int m_batch_querying_count = 0;
+
+    GCancellable *m_check_cancellable = nullptr;
+    QString m_checking_uri;
+
+    //columns, indexed by record.
+    QByteArray m_name_pool;
+    QVector<quint32> m_name_offsets;
+    QVector<quint64> m_sizes;
+    QVector<quint64> m_modified_times;
+    QVector<quint16> m_type_ids;
+    QVector<quint8> m_flags;
+    //removed records are kept until the columns are compacted.
+    int m_removed_count = 0;
+
+    //open addressing hash of names, stores record + 1.
+    QVector<quint32> m_name_index;
+
+    //row to record, and record to row (-1 if not shown).
+    QVector<quint32> m_order;
+    QVector<qint32> m_rows;
+
+    QVector<TypeEntry> m_types;
+    QHash<QByteArray, quint16> m_type_hash;
+
+    mutable QCache<quint32, RowStrings> m_row_cache;
+    QSet<QString> m_querying_uris;
+
+    bool m_show_hidden = false;
+    bool m_folder_first = true;
+    bool m_use_default_name_sort_order = false;
+    int m_sort_column = 0;
+    Qt::SortOrder m_sort_order = Qt::AscendingOrder;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(FlatDirectoryModel::RecordFlags)
+
+}
+
+#endif // FLATDIRECTORYMODEL_H
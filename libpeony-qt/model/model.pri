@@ -6,6 +6,8 @@ HEADERS += \
     $$PWD/file-item.h \
     $$PWD/file-item-model.h \
     $$PWD/file-item-proxy-filter-sort-model.h \
+    $$PWD/flat-directory-model.h \
+    $$PWD/directory-model-registry.h \
     $$PWD/file-label-model.h \
     $$PWD/side-bar-abstract-item.h \
     $$PWD/side-bar-model.h \
@@ -21,6 +23,8 @@ SOURCES += \
     $$PWD/file-item.cpp \
     $$PWD/file-item-model.cpp \
     $$PWD/file-item-proxy-filter-sort-model.cpp \
+    $$PWD/flat-directory-model.cpp \
+    $$PWD/directory-model-registry.cpp \
     $$PWD/file-label-model.cpp \
     $$PWD/side-bar-abstract-item.cpp \
     $$PWD/side-bar-model.cpp \
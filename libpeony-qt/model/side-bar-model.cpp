@@ -31,6 +31,7 @@
 
 #include "bookmark-manager.h"
 #include "file-operation-utils.h"
+#include "theme-icon-cache.h"
 
 #include <QIcon>
 #include <QMimeData>
@@ -194,7 +195,7 @@ QVariant SideBarModel::data(const QModelIndex &index, int role) const
     SideBarAbstractItem *item = static_cast<SideBarAbstractItem*>(index.internalPointer());
     if (index.column() == 1) {
         if (role == Qt::DecorationRole && item->isMounted())
-            return QVariant(QIcon::fromTheme("media-eject"));
+            return QVariant(ThemeIconCache::getInstance()->icon("media-eject"));
         else {
             return QVariant();
         }
@@ -202,7 +203,7 @@ QVariant SideBarModel::data(const QModelIndex &index, int role) const
 
     switch (role) {
     case Qt::DecorationRole:
-        return QIcon::fromTheme("ukui-" + item->iconName(), QIcon::fromTheme(item->iconName()));
+        return ThemeIconCache::getInstance()->icon("ukui-" + item->iconName(), item->iconName());
     case Qt::DisplayRole:
         return item->displayName();
     case Qt::ToolTipRole:
@@ -15,7 +15,8 @@ HEADERS += $$PWD/peony-core_global.h \
     $$PWD/thumbnail-manager.h \
     $$PWD/linux-pwd-helper.h \
     $$PWD/file-meta-info.h \
-    $$PWD/bookmark-manager.h
+    $$PWD/bookmark-manager.h \
+    $$PWD/theme-icon-cache.h
 
 SOURCES += $$PWD/file-info.cpp \
            $$PWD/file-info-job.cpp \
@@ -31,6 +32,7 @@ SOURCES += $$PWD/file-info.cpp \
     $$PWD/thumbnail-manager.cpp \
     $$PWD/linux-pwd-helper.cpp \
     $$PWD/file-meta-info.cpp \
-    $$PWD/bookmark-manager.cpp
+    $$PWD/bookmark-manager.cpp \
+    $$PWD/theme-icon-cache.cpp
 
 FORMS += $$PWD/connect-server-dialog.ui
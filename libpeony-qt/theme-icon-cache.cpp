@@ -0,0 +1,190 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "theme-icon-cache.h"
+
+#include <QIconEngine>
+#include <QPainter>
+#include <QStyle>
+#include <QApplication>
+
+using namespace Peony;
+
+static ThemeIconCache *global_instance = nullptr;
+
+namespace {
+
+/*!
+ * \brief The CachedThemeIconEngine class
+ * \details
+ * resolve the theme icon lazily, and rasterize it through the pixmap cache
+ * of ThemeIconCache.
+ */
+class CachedThemeIconEngine : public QIconEngine
+{
+public:
+    CachedThemeIconEngine(const QString &iconName, const QString &fallbackName)
+        : m_icon_name(iconName), m_fallback_name(fallbackName) {}
+
+    void paint(QPainter *painter, const QRect &rect, QIcon::Mode mode, QIcon::State state) override {
+        qreal dpr = painter->device()? painter->device()->devicePixelRatioF(): qApp->devicePixelRatio();
+        QPixmap pix = pixmap(rect.size() * dpr, mode, state);
+        if (pix.isNull())
+            return;
+        pix.setDevicePixelRatio(dpr);
+        QSize logicalSize = pix.size() / dpr;
+        QRect target = QStyle::alignedRect(Qt::LeftToRight, Qt::AlignCenter, logicalSize, rect);
+        painter->drawPixmap(target, pix);
+    }
+
+    QPixmap pixmap(const QSize &size, QIcon::Mode mode, QIcon::State state) override {
+        auto cache = ThemeIconCache::getInstance();
+        cache->checkThemeChanged();
+
+        QString key = QString("%1/%2/%3x%4/%5/%6").arg(m_icon_name)
+                .arg(m_fallback_name)
+                .arg(size.width())
+                .arg(size.height())
+                .arg(int(mode))
+                .arg(int(state));
+        QPixmap pix = cache->findPixmap(key);
+        if (!pix.isNull())
+            return pix;
+
+        //size is in device pixels already, but QIcon::pixmap() scales it by the
+        //application dpr again when AA_UseHighDpiPixmaps is set.
+        qreal appDpr = qApp->testAttribute(Qt::AA_UseHighDpiPixmaps)? qApp->devicePixelRatio(): 1.0;
+        QSize logicalSize = (QSizeF(size) / appDpr).toSize();
+        pix = themeIcon().pixmap(logicalSize, mode, state);
+        if (!pix.isNull()) {
+            pix.setDevicePixelRatio(1.0);
+            cache->insertPixmap(key, pix);
+        }
+        return pix;
+    }
+
+    QSize actualSize(const QSize &size, QIcon::Mode mode, QIcon::State state) override {
+        return themeIcon().actualSize(size, mode, state);
+    }
+
+    QList<QSize> availableSizes(QIcon::Mode mode, QIcon::State state) const override {
+        return const_cast<CachedThemeIconEngine *>(this)->themeIcon().availableSizes(mode, state);
+    }
+
+    QString iconName() const override {
+        return const_cast<CachedThemeIconEngine *>(this)->themeIcon().name();
+    }
+
+    QIconEngine *clone() const override {
+        return new CachedThemeIconEngine(m_icon_name, m_fallback_name);
+    }
+
+    void virtual_hook(int id, void *data) override {
+        if (id == QIconEngine::IsNullHook) {
+            *reinterpret_cast<bool *>(data) = themeIcon().isNull();
+            return;
+        }
+        QIconEngine::virtual_hook(id, data);
+    }
+
+private:
+    const QIcon &themeIcon() {
+        auto cache = ThemeIconCache::getInstance();
+        cache->checkThemeChanged();
+        if (m_generation != cache->generation()) {
+            m_icon = QIcon::fromTheme(m_icon_name, QIcon::fromTheme(m_fallback_name));
+            m_generation = cache->generation();
+        }
+        return m_icon;
+    }
+
+    QString m_icon_name;
+    QString m_fallback_name;
+    QIcon m_icon;
+    int m_generation = -1;
+};
+
+}
+
+ThemeIconCache *ThemeIconCache::getInstance()
+{
+    if (!global_instance)
+        global_instance = new ThemeIconCache;
+    return global_instance;
+}
+
+ThemeIconCache::ThemeIconCache(QObject *parent) : QObject(parent)
+{
+    m_theme_name = QIcon::themeName();
+    //about 32MB
+    m_pixmaps.setMaxCost(32*1024*1024);
+}
+
+const QIcon ThemeIconCache::icon(const QString &iconName, const QString &fallbackName)
+{
+    checkThemeChanged();
+
+    QString key = iconName + "/" + fallbackName;
+    //an icon missing in the theme is cached too, its engine only resolves it
+    //once, and testing isNull() here would resolve it for every call.
+    auto it = m_icons.constFind(key);
+    if (it != m_icons.constEnd())
+        return it.value();
+
+    QIcon icon(new CachedThemeIconEngine(iconName, fallbackName));
+    m_icons.insert(key, icon);
+    return icon;
+}
+
+const QPixmap ThemeIconCache::findPixmap(const QString &key)
+{
+    auto pixmap = m_pixmaps.object(key);
+    if (pixmap)
+        return *pixmap;
+    return QPixmap();
+}
+
+void ThemeIconCache::insertPixmap(const QString &key, const QPixmap &pixmap)
+{
+    int cost = pixmap.width() * pixmap.height() * pixmap.depth() / 8;
+    m_pixmaps.insert(key, new QPixmap(pixmap), cost);
+}
+
+bool ThemeIconCache::checkThemeChanged()
+{
+    auto themeName = QIcon::themeName();
+    if (themeName == m_theme_name)
+        return false;
+
+    m_theme_name = themeName;
+    clear();
+    return true;
+}
+
+void ThemeIconCache::clear()
+{
+    //the icons still held by views resolve the theme icon again,
+    //see CachedThemeIconEngine::themeIcon().
+    m_generation++;
+    m_icons.clear();
+    m_pixmaps.clear();
+}
@@ -0,0 +1,100 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef THEMEICONCACHE_H
+#define THEMEICONCACHE_H
+
+#include <QObject>
+#include <QIcon>
+#include <QHash>
+#include <QCache>
+
+#include "peony-core_global.h"
+
+namespace Peony {
+
+/*!
+ * \brief The ThemeIconCache class
+ * \details
+ * Models used to call QIcon::fromTheme() for every DecorationRole query,
+ * and delegates rasterized the returned icon on every paint.
+ *
+ * This class holds one QIcon per (icon name, fallback name). The icons are
+ * backed by an engine which resolves the theme icon only once, and keeps the
+ * rasterized pixmaps keyed by (size in device pixels, mode, state), so the
+ * device pixel ratio is a part of the key too. Every view and model of the
+ * process shares them, scrolling a folder does no theme lookup once the
+ * icons of its file types have been painted.
+ *
+ * All the cached data is dropped when the icon theme changed.
+ *
+ * \note
+ * This class is not thread safe, use it in gui thread only.
+ */
+class PEONYCORESHARED_EXPORT ThemeIconCache : public QObject
+{
+    Q_OBJECT
+public:
+    static ThemeIconCache *getInstance();
+
+    /*!
+     * \brief icon
+     * \param iconName
+     * \param fallbackName the theme icon used if theme doesn't have iconName.
+     * \return a cached icon, which is equivalent to
+     * QIcon::fromTheme(iconName, QIcon::fromTheme(fallbackName)).
+     */
+    const QIcon icon(const QString &iconName, const QString &fallbackName = nullptr);
+
+    const QPixmap findPixmap(const QString &key);
+    void insertPixmap(const QString &key, const QPixmap &pixmap);
+
+    /*!
+     * \brief checkThemeChanged
+     * \return true if the icon theme changed since last call, the cache will
+     * be cleared.
+     */
+    bool checkThemeChanged();
+
+    /*!
+     * \brief generation
+     * \return a number increased every time the cache is cleared. an icon
+     * engine which resolved its theme icon in an older generation resolves
+     * it again.
+     */
+    int generation() {return m_generation;}
+
+public Q_SLOTS:
+    void clear();
+
+private:
+    explicit ThemeIconCache(QObject *parent = nullptr);
+
+    QString m_theme_name;
+    int m_generation = 0;
+    QHash<QString, QIcon> m_icons;
+    QCache<QString, QPixmap> m_pixmaps;
+};
+
+}
+
+#endif // THEMEICONCACHE_H
@@ -32,6 +32,7 @@
 
 #include "generic-thumbnailer.h"
 #include "thumbnail-job.h"
+#include "shared-thumbnail-cache.h"
 
 #include "global-settings.h"
 
@@ -64,6 +65,10 @@ ThumbnailManager::ThumbnailManager(QObject *parent) : QObject(parent)
 
     m_thumbnail_thread_pool = new QThreadPool(this);
     m_thumbnail_thread_pool->setMaxThreadCount(1);
+
+    //attach the cache shared with other peony processes here, not in the
+    //thumbnail thread.
+    SharedThumbnailCache::getInstance();
 }
 
 ThumbnailManager *ThumbnailManager::getInstance()
@@ -83,8 +88,19 @@ void ThumbnailManager::setForbidThumbnailInView(bool forbid)
     GlobalSettings::getInstance()->setValue("do-not-thumbnail", forbid);
 }
 
-void ThumbnailManager::createThumbnailInternal(const QString &uri, std::shared_ptr<FileWatcher> watcher, bool force)
+void ThumbnailManager::createThumbnailInternal(const QString &uri, std::weak_ptr<FileWatcher> weakWatcher, bool force)
 {
+    //a job requested by a view is cancelled once the view's watcher is gone,
+    //even if it was gone before the job started. only a job requested without
+    //any watcher, whose weak pointer never owned one, can not be cancelled.
+    std::weak_ptr<FileWatcher> noWatcher;
+    bool cancellable = weakWatcher.owner_before(noWatcher) || noWatcher.owner_before(weakWatcher);
+    auto isCancelled = [=]() {
+        return cancellable && weakWatcher.expired();
+    };
+    if (isCancelled())
+        return;
+
     auto settings = GlobalSettings::getInstance();
     if (settings->isExist("do-not-thumbnail")) {
         bool do_not_thumbnail = settings->getValue("do-not-thumbnail").toBool();
@@ -96,6 +112,27 @@ void ThumbnailManager::createThumbnailInternal(const QString &uri, std::shared_p
     //NOTE: we should do createThumbnail() after we have queried the file's info.
     auto info = FileInfo::fromUri(uri);
     if (!info->mimeType().isEmpty()) {
+        //the thumbnail might have been generated by another peony process,
+        //such as peony-qt-desktop.
+        bool sharable = info->mimeType().startsWith("image/") || info->mimeType().contains("pdf");
+        if (sharable && info->modifiedTime() > 0) {
+            bool opaque = false;
+            QImage image = SharedThumbnailCache::getInstance()->lookup(uri, info->modifiedTime(), info->size(), &opaque);
+            if (!image.isNull()) {
+                //the image has the pixmap format already, so the pixmap shares
+                //the pixels mapped from the cache rather than copying them.
+                QIcon thumbnail;
+                thumbnail.addPixmap(QPixmap::fromImage(image));
+                m_hash.remove(uri);
+                m_hash.insert(uri, thumbnail);
+                setShadow(uri, opaque);
+                if (auto watcher = weakWatcher.lock()) {
+                    watcher->fileChanged(uri);
+                }
+                return;
+            }
+        }
+
         if (info->mimeType().startsWith("image/")) {
             QUrl url = uri;
             qDebug()<<url;
@@ -103,16 +140,29 @@ void ThumbnailManager::createThumbnailInternal(const QString &uri, std::shared_p
                 url = FileUtils::getTargetUri(info->uri());
                 qDebug()<<url;
             }
-            QIcon thumbnail = GenericThumbnailer::generateThumbnail(url.path(), true);
+            QIcon thumbnail = GenericThumbnailer::generateThumbnail(url.path());
             //thumbnail.addFile(url.path());
             if (!thumbnail.isNull()) {
                 //add lock
                 //m_mutex.lock();
                 m_hash.remove(uri);
                 m_hash.insert(uri, thumbnail);
+                //images with alpha channel do not need a shadow.
+                auto sizes = thumbnail.availableSizes();
+                if (!sizes.isEmpty()) {
+                    QPixmap pixmap = thumbnail.pixmap(sizes.first());
+                    bool opaque = !pixmap.hasAlphaChannel();
+                    setShadow(uri, opaque);
+                    if (info->modifiedTime() > 0) {
+                        SharedThumbnailCache::getInstance()->publish(uri, info->modifiedTime(), info->size(), pixmap.toImage(), opaque);
+                    }
+                } else {
+                    //svg
+                    setShadow(uri, false);
+                }
                 auto info = FileInfo::fromUri(uri);
                 //Q_EMIT info->updated();
-                if (watcher) {
+                if (auto watcher = weakWatcher.lock()) {
                     watcher->fileChanged(uri);
                 }
                 //info->setThumbnail(thumbnail);
@@ -125,19 +175,25 @@ void ThumbnailManager::createThumbnailInternal(const QString &uri, std::shared_p
                 url = FileUtils::getTargetUri(info->uri());
                 qDebug()<<url;
             }
-            PdfThumbnail pdfThumbnail(info->uri());
+            PdfThumbnail pdfThumbnail(url.path());
             QIcon thumbnail;
-            QPixmap pix = pdfThumbnail.generateThumbnail();
-            thumbnail = GenericThumbnailer::generateThumbnail(pix, true);
+            QPixmap pix = pdfThumbnail.generateThumbnail(128, isCancelled);
+            if (pix.isNull())
+                return;
+            thumbnail = GenericThumbnailer::generateThumbnail(pix);
             //thumbnail.addFile(url.path());
             if (!thumbnail.isNull()) {
                 //add lock
                 //m_mutex.lock();
                 m_hash.remove(uri);
                 m_hash.insert(uri, thumbnail);
+                setShadow(uri, true);
+                if (info->modifiedTime() > 0) {
+                    SharedThumbnailCache::getInstance()->publish(uri, info->modifiedTime(), info->size(), pix.toImage(), true);
+                }
                 auto info = FileInfo::fromUri(uri);
                 //Q_EMIT info->updated();
-                if (watcher) {
+                if (auto watcher = weakWatcher.lock()) {
                     watcher->fileChanged(uri);
                 }
                 //info->setThumbnail(thumbnail);
@@ -166,7 +222,7 @@ void ThumbnailManager::createThumbnailInternal(const QString &uri, std::shared_p
             QString string = _icon_string;
             if (thumbnail.isNull() && string.startsWith("/")) {
                 qDebug()<<"add file";
-                QIcon thumbnail = GenericThumbnailer::generateThumbnail(_icon_string, true);
+                QIcon thumbnail = GenericThumbnailer::generateThumbnail(_icon_string);
                 //thumbnail.addFile(_icon_string);
             }
             g_free(_icon_string);
@@ -177,9 +233,10 @@ void ThumbnailManager::createThumbnailInternal(const QString &uri, std::shared_p
                 //m_mutex.lock();
                 m_hash.remove(uri);
                 m_hash.insert(uri, thumbnail);
+                setShadow(uri, false);
                 auto info = FileInfo::fromUri(uri);
                 //Q_EMIT info->updated();
-                if (watcher) {
+                if (auto watcher = weakWatcher.lock()) {
                     watcher->fileChanged(uri);
                 }
                 //info->setThumbnail(thumbnail);
@@ -191,6 +248,23 @@ void ThumbnailManager::createThumbnailInternal(const QString &uri, std::shared_p
 
 void ThumbnailManager::createThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher, bool force)
 {
+    if (watcher) {
+        //one entry for each watcher, the expired ones are dropped.
+        QMutexLocker locker(&m_watchers_mutex);
+        auto &watchers = m_thumbnail_watchers[uri];
+        bool watched = false;
+        for (int i = watchers.count() - 1; i >= 0; i--) {
+            auto existing = watchers.at(i).lock();
+            if (!existing) {
+                watchers.removeAt(i);
+            } else if (existing == watcher) {
+                watched = true;
+            }
+        }
+        if (!watched)
+            watchers<<watcher;
+    }
+
     auto thumbnailJob = new ThumbnailJob(uri, watcher, this);
     m_thumbnail_thread_pool->start(thumbnailJob);
 }
@@ -219,7 +293,7 @@ void ThumbnailManager::updateDesktopFileThumbnail(const QString &uri, std::share
             QString string = _icon_string;
             if (thumbnail.isNull() && string.startsWith("/")) {
                 qDebug()<<"add file";
-                QIcon thumbnail = GenericThumbnailer::generateThumbnail(_icon_string, true);
+                QIcon thumbnail = GenericThumbnailer::generateThumbnail(_icon_string);
                 //thumbnail.addFile(_icon_string);
             }
             g_free(_icon_string);
@@ -230,6 +304,7 @@ void ThumbnailManager::updateDesktopFileThumbnail(const QString &uri, std::share
                 //m_mutex.lock();
                 m_hash.remove(uri);
                 m_hash.insert(uri, thumbnail);
+                setShadow(uri, false);
                 auto info = FileInfo::fromUri(uri);
                 //Q_EMIT info->updated();
                 if (watcher) {
@@ -251,7 +326,38 @@ void ThumbnailManager::releaseThumbnail(const QString &uri)
 {
     //m_mutex.lock();
     m_hash.remove(uri);
+    setShadow(uri, false);
     //m_mutex.unlock();
+    QMutexLocker locker(&m_watchers_mutex);
+    m_thumbnail_watchers.remove(uri);
+}
+
+void ThumbnailManager::releaseUnwatchedThumbnail(const QString &uri)
+{
+    m_watchers_mutex.lock();
+    auto watchers = m_thumbnail_watchers.value(uri);
+    m_watchers_mutex.unlock();
+    for (auto watcher : watchers) {
+        if (!watcher.expired())
+            return;
+    }
+    releaseThumbnail(uri);
+}
+
+bool ThumbnailManager::hasShadow(const QString &uri)
+{
+    QMutexLocker locker(&m_shadow_mutex);
+    return m_shadow_set.contains(uri);
+}
+
+void ThumbnailManager::setShadow(const QString &uri, bool shadow)
+{
+    QMutexLocker locker(&m_shadow_mutex);
+    if (shadow) {
+        m_shadow_set.insert(uri);
+    } else {
+        m_shadow_set.remove(uri);
+    }
 }
 
 const QIcon ThumbnailManager::tryGetThumbnail(const QString &uri)
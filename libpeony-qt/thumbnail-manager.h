@@ -28,6 +28,7 @@
 #include "file-info.h"
 
 #include <QHash>
+#include <QSet>
 #include <QIcon>
 #include <QMutex>
 
@@ -47,9 +48,28 @@ public:
     void setForbidThumbnailInView(bool forbid);
 
     bool hasThumbnail(const QString &uri) {return !m_hash.values(uri).isEmpty();}
+    /*!
+     * \brief hasShadow
+     * \return true if the thumbnail of uri is opaque and a drop shadow
+     * should be painted behind it.
+     * \see ThumbnailShadow
+     * \note
+     * The shadow set is written by the thumbnail thread, this is called by views
+     * in the gui thread, so the set is guarded by a mutex.
+     */
+    bool hasShadow(const QString &uri);
 
     void createThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher = nullptr, bool force = false);
     void releaseThumbnail(const QString &uri);
+    /*!
+     * \brief releaseUnwatchedThumbnail
+     * \details
+     * Release the thumbnail of uri unless it is still watched. A thumbnail is watched
+     * while any watcher it was created with is alive, so a model which drops its
+     * watcher, such as a suspended one, doesn't release the thumbnails shown by the
+     * other views.
+     */
+    void releaseUnwatchedThumbnail(const QString &uri);
     void updateDesktopFileThumbnail(const QString &uri, std::shared_ptr<FileWatcher> watcher = nullptr);
     const QIcon tryGetThumbnail(const QString &uri);
 
@@ -60,9 +80,15 @@ public Q_SLOTS:
 
 private:
     explicit ThumbnailManager(QObject *parent = nullptr);
-    void createThumbnailInternal(const QString &uri, std::shared_ptr<FileWatcher> watcher = nullptr, bool force = false);
+    void createThumbnailInternal(const QString &uri, std::weak_ptr<FileWatcher> weakWatcher, bool force = false);
+    void setShadow(const QString &uri, bool shadow);
 
     QHash<QString, QIcon> m_hash;
+    QSet<QString> m_shadow_set;
+    //the watchers which the thumbnails were created with.
+    QHash<QString, QList<std::weak_ptr<FileWatcher>>> m_thumbnail_watchers;
+    QMutex m_watchers_mutex;
+    QMutex m_shadow_mutex;
     //QMutex m_mutex;
 
     QThreadPool *m_thumbnail_thread_pool;
@@ -23,42 +23,97 @@
 #include <QDebug>
 #include <QImage>
 #include <QStandardPaths>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QCache>
+#include <QMutex>
 
 #include "pdf-thumbnail.h"
 
+//about 8MB of 128px wide first pages.
+static QCache<QString, QImage> pageCache(8*1024*1024);
+static QMutex pageCacheMutex;
+
+static bool shouldAbortRender(const QVariant &payload)
+{
+    auto isCancelled = static_cast<const std::function<bool()> *>(payload.value<void *>());
+    return isCancelled && (*isCancelled) && (*isCancelled)();
+}
+
 PdfThumbnail::PdfThumbnail(const QString &url, unsigned int pageNum)
     : pageNum(pageNum), shortUrl(url) {
     shortUrl = shortUrl.remove("file://");
-    documentPrivate = Poppler::Document::load(shortUrl);
-    if (!documentPrivate || documentPrivate->isLocked()) {
-        qDebug() << "load pdf documnet failed";
-    }
 }
 
 PdfThumbnail::~PdfThumbnail() {
-    delete documentPrivate;
     delete pagePrivate;
+    delete documentPrivate;
 }
 
-QPixmap PdfThumbnail::generateThumbnail(unsigned int pageNum) {
-    try {
-        if (this->documentPrivate == nullptr)
-            //throw "pdf document not existed";
-            //fix crash issue, change throw to return
-            return QPixmap();
-        pagePrivate = documentPrivate->page(pageNum);
-        if (pagePrivate == nullptr)
-            //throw "load pdf page failed";
-            return QPixmap();
-        auto image = pagePrivate->renderToImage(
-                         72 * 2, 72 * 2, 0, 0, pagePrivate->pageSizeF().width() * 2,
-                         pagePrivate->pageSizeF().height() * 2);
-        if (image.isNull())
-            //throw "load pdf page image failed";
-            return QPixmap();
-        return QPixmap::fromImage(image);
-    } catch (char *e) {
-        qDebug() << e;
+QPixmap PdfThumbnail::generateThumbnail(int targetWidth, const std::function<bool()> &isCancelled) {
+    if (targetWidth <= 0)
         return QPixmap();
+
+    QFileInfo fileInfo(shortUrl);
+    QString key = QString("%1:%2:%3:%4").arg(shortUrl)
+                  .arg(fileInfo.lastModified().toMSecsSinceEpoch())
+                  .arg(pageNum)
+                  .arg(targetWidth);
+
+    pageCacheMutex.lock();
+    auto cached = pageCache.object(key);
+    if (cached) {
+        auto pixmap = QPixmap::fromImage(*cached);
+        pageCacheMutex.unlock();
+        return pixmap;
     }
+    pageCacheMutex.unlock();
+
+    if (isCancelled && isCancelled())
+        return QPixmap();
+
+    if (!documentPrivate) {
+        documentPrivate = Poppler::Document::load(shortUrl);
+        if (!documentPrivate || documentPrivate->isLocked()) {
+            qDebug() << "load pdf documnet failed";
+            //fix crash issue, do not throw here, just return
+            return QPixmap();
+        }
+        //a thumbnail is too small for antialiased shapes, hinting and annotations
+        //to be noticed, trade them for rendering speed. text keeps antialiasing,
+        //small glyphs are unreadable without it.
+        documentPrivate->setRenderBackend(Poppler::Document::SplashBackend);
+        documentPrivate->setRenderHint(Poppler::Document::Antialiasing, false);
+        documentPrivate->setRenderHint(Poppler::Document::TextAntialiasing, true);
+        documentPrivate->setRenderHint(Poppler::Document::TextHinting, false);
+        documentPrivate->setRenderHint(Poppler::Document::HideAnnotations, true);
+    }
+
+    delete pagePrivate;
+    pagePrivate = documentPrivate->page(pageNum);
+    if (pagePrivate == nullptr)
+        return QPixmap();
+
+    QSizeF pageSize = pagePrivate->pageSizeF();
+    if (pageSize.width() <= 0 || pageSize.height() <= 0)
+        return QPixmap();
+
+    //page size is in points (1/72 inch), render exactly targetWidth pixels wide.
+    double dpi = 72.0 * targetWidth / pageSize.width();
+    auto image = pagePrivate->renderToImage(dpi, dpi, -1, -1, -1, -1,
+                                            Poppler::Page::Rotate0,
+                                            nullptr, nullptr,
+                                            shouldAbortRender,
+                                            QVariant::fromValue(static_cast<void *>(const_cast<std::function<bool()> *>(&isCancelled))));
+    if (image.isNull())
+        return QPixmap();
+
+    if (isCancelled && isCancelled())
+        return QPixmap();
+
+    pageCacheMutex.lock();
+    pageCache.insert(key, new QImage(image), int(image.sizeInBytes()));
+    pageCacheMutex.unlock();
+
+    return QPixmap::fromImage(image);
 }
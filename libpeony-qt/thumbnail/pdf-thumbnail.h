@@ -27,13 +27,29 @@
 #include <QString>
 #include <poppler-qt5.h>
 
+#include <functional>
+
 class PdfThumbnail {
 public:
     unsigned int pageNum;
 
     explicit PdfThumbnail(const QString &url, unsigned int pageNum = 0);
     ~PdfThumbnail();
-    QPixmap generateThumbnail(unsigned int pageNum = 0);
+
+    /*!
+     * \brief generateThumbnail
+     * \param targetWidth the width of the thumbnail in pixels.
+     * \param isCancelled polled by poppler while rendering, return true to stop
+     * the rendering as soon as possible.
+     * \return the page rendered directly at the target size, or a null pixmap
+     * if the document could not be rendered or the job was cancelled.
+     * \details
+     * The dpi is computed from the page size, so that poppler never rasterizes
+     * more pixels than we will show. The rendered image of the first page is
+     * cached by (path, mtime, width), so re-thumbnailing an unchanged document,
+     * for example after the view was reloaded, does not touch poppler again.
+     */
+    QPixmap generateThumbnail(int targetWidth = 128, const std::function<bool()> &isCancelled = nullptr);
 
 private:
     QString shortUrl;
@@ -0,0 +1,332 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "shared-thumbnail-cache.h"
+
+#include <QSharedMemory>
+#include <QCryptographicHash>
+#include <QMutexLocker>
+
+#include <QDebug>
+
+#include <unistd.h>
+#include <string.h>
+#include <signal.h>
+#include <errno.h>
+
+#define CACHE_MAGIC 0x50544331 //PTC1
+#define CACHE_VERSION 3
+#define SLOT_COUNT 256
+#define PROBE_COUNT 4
+//thumbnails are 128px wide, the slots fit portrait ones up to 1:2,
+//such as pdf pages and photos.
+#define SLOT_WIDTH 128
+#define SLOT_HEIGHT 256
+#define SLOT_DATA_SIZE (SLOT_WIDTH*SLOT_HEIGHT*4)
+//processes which can show a slot in place at the same time.
+#define PIN_COUNT 4
+
+using namespace Peony;
+
+static SharedThumbnailCache *global_instance = nullptr;
+
+namespace {
+
+struct CacheHeader {
+    quint32 magic;
+    quint32 version;
+    quint32 slotCount;
+    quint32 slotDataSize;
+    quint32 clock;
+};
+
+struct SlotPin {
+    qint32 pid;
+    quint32 count;
+};
+
+struct SlotHeader {
+    quint32 used;
+    quint32 stamp;
+    quint8 key[16];
+    quint64 mtime;
+    quint64 size;
+    quint32 width;
+    quint32 height;
+    quint32 bytesPerLine;
+    quint32 format;
+    quint32 opaque;
+    quint32 reserved;
+    SlotPin pins[PIN_COUNT];
+};
+
+const int headerSize = 64;
+const int slotHeaderSize = 128;
+const int slotStride = slotHeaderSize + SLOT_DATA_SIZE;
+
+static_assert(sizeof(CacheHeader) <= headerSize, "cache header overflow");
+static_assert(sizeof(SlotHeader) <= slotHeaderSize, "slot header overflow");
+
+QByteArray keyForUri(const QString &uri)
+{
+    //qHash is seeded per process, it can not be used across processes.
+    return QCryptographicHash::hash(uri.toUtf8(), QCryptographicHash::Md5);
+}
+
+bool isProcessAlive(qint32 pid)
+{
+    return kill(pid, 0) == 0 || errno == EPERM;
+}
+
+/*!
+ * \brief isPinned
+ * \return true if a living process shows the slot in place. the pins of
+ * exited processes are dropped here, they never released them.
+ */
+bool isPinned(SlotHeader *slot)
+{
+    bool pinned = false;
+    for (int i = 0; i < PIN_COUNT; i++) {
+        auto &pin = slot->pins[i];
+        if (pin.count == 0)
+            continue;
+        if (isProcessAlive(pin.pid)) {
+            pinned = true;
+        } else {
+            pin.pid = 0;
+            pin.count = 0;
+        }
+    }
+    return pinned;
+}
+
+bool pinSlot(SlotHeader *slot, qint32 pid)
+{
+    SlotPin *freePin = nullptr;
+    for (int i = 0; i < PIN_COUNT; i++) {
+        auto &pin = slot->pins[i];
+        if (pin.count > 0 && pin.pid == pid) {
+            pin.count++;
+            return true;
+        }
+        if (!freePin && (pin.count == 0 || !isProcessAlive(pin.pid)))
+            freePin = &pin;
+    }
+    if (!freePin)
+        return false;
+    freePin->pid = pid;
+    freePin->count = 1;
+    return true;
+}
+
+}
+
+SharedThumbnailCache *SharedThumbnailCache::getInstance()
+{
+    if (!global_instance)
+        global_instance = new SharedThumbnailCache;
+    return global_instance;
+}
+
+SharedThumbnailCache::SharedThumbnailCache()
+{
+    //the layout is versioned by the key, so an old process does not block the new layout.
+    m_shared_memory = new QSharedMemory(QString("peony-thumbnail-cache-%1-v%2").arg(getuid()).arg(CACHE_VERSION));
+    int totalSize = headerSize + SLOT_COUNT * slotStride;
+
+    if (!m_shared_memory->attach()) {
+        if (!m_shared_memory->create(totalSize)) {
+            if (m_shared_memory->error() != QSharedMemory::AlreadyExists || !m_shared_memory->attach()) {
+                qDebug()<<"shared thumbnail cache is not available:"<<m_shared_memory->errorString();
+                return;
+            }
+        }
+    }
+
+    if (m_shared_memory->size() < totalSize) {
+        //created by an incompatible version.
+        m_shared_memory->detach();
+        return;
+    }
+
+    m_shared_memory->lock();
+    auto header = static_cast<CacheHeader *>(m_shared_memory->data());
+    if (header->magic != CACHE_MAGIC) {
+        //new segment, the memory is zero filled.
+        header->version = CACHE_VERSION;
+        header->slotCount = SLOT_COUNT;
+        header->slotDataSize = SLOT_DATA_SIZE;
+        header->magic = CACHE_MAGIC;
+    }
+    m_shared_memory->unlock();
+
+    if (header->version != CACHE_VERSION || header->slotCount != SLOT_COUNT || header->slotDataSize != SLOT_DATA_SIZE) {
+        m_shared_memory->detach();
+    }
+}
+
+SharedThumbnailCache::~SharedThumbnailCache()
+{
+    delete m_shared_memory;
+}
+
+bool SharedThumbnailCache::isValid()
+{
+    return m_shared_memory->isAttached();
+}
+
+QImage SharedThumbnailCache::lookup(const QString &uri, quint64 mtime, quint64 size, bool *opaque)
+{
+    if (!isValid())
+        return QImage();
+
+    auto key = keyForUri(uri);
+    quint32 hash;
+    memcpy(&hash, key.constData(), sizeof(hash));
+
+    //the semaphore of QSharedMemory is not shared by the threads of a process.
+    QMutexLocker locker(&m_mutex);
+    if (!m_shared_memory->lock())
+        return QImage();
+
+    QImage image;
+    auto base = static_cast<uchar *>(m_shared_memory->data());
+    for (int i = 0; i < PROBE_COUNT; i++) {
+        int index = int((hash + i) % SLOT_COUNT);
+        auto slotData = base + headerSize + index * slotStride;
+        auto slot = reinterpret_cast<SlotHeader *>(slotData);
+
+        //a slot of the uri might be kept for an old version which is still shown.
+        if (!slot->used || memcmp(slot->key, key.constData(), sizeof(slot->key)) != 0)
+            continue;
+        if (slot->mtime != mtime || slot->size != size)
+            continue;
+
+        auto format = QImage::Format(slot->format);
+        if (format != QImage::Format_ARGB32_Premultiplied && format != QImage::Format_RGB32)
+            break;
+        if (slot->width == 0 || slot->height == 0 || slot->width > SLOT_WIDTH || slot->bytesPerLine < slot->width * 4
+                || quint64(slot->bytesPerLine) * slot->height > SLOT_DATA_SIZE)
+            break;
+
+        //the pixels are shown in place, the slot is pinned until the image and
+        //all its shallow copies, such as the pixmap of the thumbnail, are deleted.
+        //a read-only image detaches from the segment if it is modified.
+        const uchar *pixels = slotData + slotHeaderSize;
+        if (pinSlot(slot, qint32(getpid()))) {
+            image = QImage(pixels, int(slot->width), int(slot->height), int(slot->bytesPerLine), format,
+                           release_slot_callback, reinterpret_cast<void *>(quintptr(index)));
+        } else {
+            //too many processes show it, copy it out.
+            image = QImage(pixels, int(slot->width), int(slot->height), int(slot->bytesPerLine), format).copy();
+        }
+
+        if (opaque)
+            *opaque = slot->opaque;
+        break;
+    }
+
+    m_shared_memory->unlock();
+    return image;
+}
+
+void SharedThumbnailCache::release_slot_callback(void *info)
+{
+    SharedThumbnailCache::getInstance()->releaseSlot(int(quintptr(info)));
+}
+
+void SharedThumbnailCache::releaseSlot(int index)
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_shared_memory->lock())
+        return;
+
+    auto base = static_cast<uchar *>(m_shared_memory->data());
+    auto slot = reinterpret_cast<SlotHeader *>(base + headerSize + index * slotStride);
+    qint32 pid = qint32(getpid());
+    for (int i = 0; i < PIN_COUNT; i++) {
+        auto &pin = slot->pins[i];
+        if (pin.count > 0 && pin.pid == pid) {
+            pin.count--;
+            break;
+        }
+    }
+
+    m_shared_memory->unlock();
+}
+
+void SharedThumbnailCache::publish(const QString &uri, quint64 mtime, quint64 size, const QImage &image, bool opaque)
+{
+    if (!isValid() || image.isNull())
+        return;
+
+    QImage img = image.convertToFormat(image.hasAlphaChannel()? QImage::Format_ARGB32_Premultiplied: QImage::Format_RGB32);
+    if (img.width() > SLOT_WIDTH || qint64(img.bytesPerLine()) * img.height() > SLOT_DATA_SIZE)
+        return;
+
+    auto key = keyForUri(uri);
+    quint32 hash;
+    memcpy(&hash, key.constData(), sizeof(hash));
+
+    QMutexLocker locker(&m_mutex);
+    if (!m_shared_memory->lock())
+        return;
+
+    auto base = static_cast<uchar *>(m_shared_memory->data());
+    auto header = reinterpret_cast<CacheHeader *>(base);
+
+    //reuse the slot of this uri, or an empty one, or the oldest one. the pixels
+    //of a pinned slot are shown by some process, they must not be overwritten.
+    SlotHeader *target = nullptr;
+    uchar *targetData = nullptr;
+    for (int i = 0; i < PROBE_COUNT; i++) {
+        auto slotData = base + headerSize + ((hash + i) % SLOT_COUNT) * slotStride;
+        auto slot = reinterpret_cast<SlotHeader *>(slotData);
+        if (isPinned(slot))
+            continue;
+        if (!slot->used || memcmp(slot->key, key.constData(), sizeof(slot->key)) == 0) {
+            target = slot;
+            targetData = slotData;
+            break;
+        }
+        if (!target || slot->stamp < target->stamp) {
+            target = slot;
+            targetData = slotData;
+        }
+    }
+
+    if (target) {
+        target->used = 1;
+        memcpy(target->key, key.constData(), sizeof(target->key));
+        target->stamp = header->clock++;
+        target->mtime = mtime;
+        target->size = size;
+        target->width = quint32(img.width());
+        target->height = quint32(img.height());
+        target->bytesPerLine = quint32(img.bytesPerLine());
+        target->format = quint32(img.format());
+        target->opaque = opaque;
+        memcpy(targetData + slotHeaderSize, img.constBits(), size_t(img.bytesPerLine() * img.height()));
+    }
+
+    m_shared_memory->unlock();
+}
@@ -0,0 +1,94 @@
+/*
+ * Peony-Qt's Library
+ *
+ * Copyright (C) 2020, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef SHAREDTHUMBNAILCACHE_H
+#define SHAREDTHUMBNAILCACHE_H
+
+#include <QImage>
+#include <QString>
+#include <QMutex>
+
+class QSharedMemory;
+
+namespace Peony {
+
+/*!
+ * \brief The SharedThumbnailCache class
+ * \details
+ * peony and peony-qt-desktop hold their own ThumbnailManager, and they
+ * usually thumbnail the same files (~/Desktop, and the folders opened from
+ * desktop). This class shares the generated thumbnails between the processes
+ * of current user through a shared memory segment.
+ *
+ * The segment is an array of fixed size slots. A slot is found by the md5 of
+ * the uri, and it is only hit when the file's mtime and size match, so a
+ * modified file will be thumbnailed again.
+ *
+ * Publishing and looking up are serialized with the segment's system semaphore.
+ * A thumbnail found is not copied out of the segment, the image returned wraps
+ * the pixels of its slot in place, so the processes showing it share the memory
+ * of one slot. The slot is pinned by the process until the image and its shallow
+ * copies are deleted, and a pinned slot is never overwritten. The pins of a
+ * process which exited without releasing them are dropped by the next publisher.
+ *
+ * \note
+ * Only thumbnails which fit in a slot (128x256 32bit pixels) are shared.
+ */
+class SharedThumbnailCache
+{
+public:
+    static SharedThumbnailCache *getInstance();
+
+    bool isValid();
+
+    /*!
+     * \brief lookup
+     * \param opaque set to true if the thumbnail was published as opaque.
+     * \return the cached thumbnail, or a null image if there is no valid one.
+     * The image is read-only and maps the shared memory, keep it or its shallow
+     * copies rather than deep copies, such as converting it to another format.
+     */
+    QImage lookup(const QString &uri, quint64 mtime, quint64 size, bool *opaque = nullptr);
+
+    /*!
+     * \brief publish
+     * \details
+     * share a generated thumbnail with other processes. images too large
+     * to fit in a slot are ignored.
+     */
+    void publish(const QString &uri, quint64 mtime, quint64 size, const QImage &image, bool opaque);
+
+private:
+    SharedThumbnailCache();
+    ~SharedThumbnailCache();
+
+    static void release_slot_callback(void *info);
+    void releaseSlot(int index);
+
+    QSharedMemory *m_shared_memory = nullptr;
+    //the system semaphore is not reentrant for the threads of a process.
+    QMutex m_mutex;
+};
+
+}
+
+#endif // SHAREDTHUMBNAILCACHE_H
@@ -54,6 +54,7 @@ void Peony::ThumbnailJob::run()
     qDebug()<<"job start, current end:"<<endCount<<"current start request:"<<runCount;
 
     setParent(nullptr);
-    auto strongPtr = m_watcher.lock();
-    ThumbnailManager::getInstance()->createThumbnailInternal(m_uri, strongPtr);
+    //do not hold a strong reference here, the watcher expiring during the
+    //generation is how the job knows it has been cancelled.
+    ThumbnailManager::getInstance()->createThumbnailInternal(m_uri, m_watcher);
 }
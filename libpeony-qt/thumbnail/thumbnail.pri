@@ -2,8 +2,10 @@ INCLUDEPATH += $$PWD
 
 HEADERS += $$PWD/pdf-thumbnail.h \
     $$PWD/generic-thumbnailer.h \
-    $$PWD/thumbnail-job.h
+    $$PWD/thumbnail-job.h \
+    $$PWD/shared-thumbnail-cache.h
 
 SOURCES += $$PWD/pdf-thumbnail.cpp \
     $$PWD/generic-thumbnailer.cpp \
-    $$PWD/thumbnail-job.cpp
+    $$PWD/thumbnail-job.cpp \
+    $$PWD/shared-thumbnail-cache.cpp
@@ -30,6 +30,11 @@
 
 #include "icon-view-delegate.h"
 
+#include "thumbnail-manager.h"
+#include "thumbnail-shadow.h"
+#include "theme-icon-cache.h"
+#include "clipboard-utils.h"
+
 #include <QPushButton>
 #include <QWidget>
 #include <QPainter>
@@ -78,6 +83,11 @@ void DesktopIconViewDelegate::paint(QPainter *painter, const QStyleOptionViewIte
         }
     }
 
+    if (ClipboardUtils::isCutFile(index.data(Qt::UserRole).toString())) {
+        //a dragged cut item is both.
+        painter->setOpacity(painter->opacity() * 0.5);
+    }
+
     //paint background
     if (!view->indexWidget(index)) {
         //painter->setClipRect(opt.rect);
@@ -114,6 +124,11 @@ void DesktopIconViewDelegate::paint(QPainter *painter, const QStyleOptionViewIte
         maxTextHight = 0;
     }
 
+    //the shadow is not baked into the thumbnails, paint it behind the icon.
+    if (ThumbnailManager::getInstance()->hasShadow(index.data(Qt::UserRole).toString())) {
+        ThumbnailShadow::paint(painter, opt);
+    }
+
     //paint icon item
     auto color = QColor(230, 230, 230);
     opt.palette.setColor(QPalette::Text, color);
@@ -195,7 +210,7 @@ void DesktopIconViewDelegate::paint(QPainter *painter, const QStyleOptionViewIte
         topRight.setX(topRight.x() - offset - symbolicIconSize.width());
         topRight.setY(topRight.y() + offset);
         auto linkRect = QRect(topRight, symbolicIconSize);
-        QIcon symbolicLinkIcon = QIcon::fromTheme("emblem-symbolic-link");
+        QIcon symbolicLinkIcon = ThemeIconCache::getInstance()->icon("emblem-symbolic-link");
         symbolicLinkIcon.paint(painter, linkRect, Qt::AlignCenter);
     }
 
@@ -50,6 +50,8 @@
 #include <QDesktopServices>
 
 #include "desktop-index-widget.h"
+#include "desktop-view-settings.h"
+#include "desktop-layout-store.h"
 
 #include "file-meta-info.h"
 
@@ -67,10 +69,18 @@
 #include <QWheelEvent>
 #include <QApplication>
 
+#include <QPainter>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <QStyleOption>
+#include <QRubberBand>
+
 #include <QDebug>
 
 using namespace Peony;
 
+//item positions are kept by DesktopLayoutStore now, the metadata
+//is only read for importing the layout of older versions.
 #define ITEM_POS_ATTRIBUTE "metadata::peony-qt-desktop-item-position"
 
 DesktopIconView::DesktopIconView(QWidget *parent) : QListView(parent)
@@ -83,6 +93,11 @@ DesktopIconView::DesktopIconView(QWidget *parent) : QListView(parent)
         viewport()->update();
     });
 
+    //cut items are painted translucent.
+    connect(ClipboardUtils::getInstance(), &ClipboardUtils::clipboardChanged, this, [=](){
+        viewport()->update();
+    });
+
     m_edit_trigger_timer.setSingleShot(true);
     m_edit_trigger_timer.setInterval(3000);
     m_last_index = QModelIndex();
@@ -113,8 +128,16 @@ DesktopIconView::DesktopIconView(QWidget *parent) : QListView(parent)
     //setContextMenuPolicy(Qt::CustomContextMenu);
     setSelectionMode(QListView::ExtendedSelection);
 
-    auto zoomLevel = this->zoomLevel();
-    setDefaultZoomLevel(zoomLevel);
+    //the view settings are loaded asynchronously, apply the saved
+    //zoom level when they are loaded.
+    auto settings = DesktopViewSettings::getInstance();
+    applyZoomLevel(ZoomLevel(settings->zoomLevel()));
+    connect(settings, &DesktopViewSettings::loaded, this, [=](){
+        auto zoomLevel = ZoomLevel(settings->zoomLevel());
+        if (zoomLevel != Invalid && zoomLevel != m_zoom_level)
+            applyZoomLevel(zoomLevel);
+    });
+    settings->load();
 
 #if QT_VERSION > QT_VERSION_CHECK(5, 12, 0)
     QTimer::singleShot(500, this, [=](){
@@ -146,6 +169,14 @@ DesktopIconView::DesktopIconView(QWidget *parent) : QListView(parent)
 
     m_proxy_model->setSourceModel(m_model);
 
+    //rows are reordered or reset, the cells of items should be laid out again.
+    connect(m_proxy_model, &QSortFilterProxyModel::layoutAboutToBeChanged, this, [=](){
+        m_layout_invalid = true;
+    });
+    connect(m_proxy_model, &QSortFilterProxyModel::modelAboutToBeReset, this, [=](){
+        m_layout_invalid = true;
+    });
+
     //connect(m_model, &DesktopItemModel::dataChanged, this, &DesktopIconView::clearAllIndexWidgets);
 
     connect(m_model, &DesktopItemModel::refreshed, this, [=](){
@@ -156,48 +187,18 @@ DesktopIconView::DesktopIconView(QWidget *parent) : QListView(parent)
     connect(m_model, &DesktopItemModel::requestClearIndexWidget, this, &DesktopIconView::clearAllIndexWidgets);
 
     connect(m_model, &DesktopItemModel::requestLayoutNewItem, this, [=](const QString &uri){
-        auto index = m_proxy_model->mapFromSource(m_model->indexFromUri(uri));
-        //qDebug()<<"=====================layout new item"<<index.data();
-
-        //qDebug()<<"=====================find a new empty place put new item";
-        auto rect = QRect(QPoint(0, 0), gridSize());
-        rect.moveTo(this->contentsMargins().left(), this->contentsMargins().top());
-
-        auto grid = this->gridSize();
-        auto viewRect = this->rect();
-        auto next = rect;
-        while (true) {
-            if (this->indexAt(next.center()).data(Qt::UserRole).toString() == uri) {
-                this->setPositionForIndex(next.topLeft(), index);
-                this->saveItemPositionInfo(uri);
-                return;
-            }
-            if (!this->indexAt(next.center()).isValid()) {
-                //put it into empty
-                qDebug()<<"put"<<index.data()<<next.topLeft();
-                this->setPositionForIndex(next.topLeft(), index);
-                this->saveItemPositionInfo(uri);
-                break;
-            }
-            //aligin.
-            next = QListView::visualRect(this->indexAt(next.center()));
-            next.translate(0, grid.height());
-            if (next.bottom() > viewRect.bottom()) {
-                int top = next.y();
-                while (true) {
-                    if (top < gridSize().height()) {
-                        break;
-                    }
-                    top-=gridSize().height();
-                }
-                //put item to next column first column
-                next.moveTo(next.x() + grid.width(), top);
-            }
-        }
+        //the new item has been put into the first free cell by
+        //the layout engine when it was inserted, just save it.
+        this->saveItemPositionInfo(uri);
     });
 
     connect(m_model, &DesktopItemModel::requestUpdateItemPositions, this, &DesktopIconView::updateItemPosistions);
 
+    //the renamed item is inserted as a new one later, keep its position.
+    connect(m_model, &DesktopItemModel::fileRenamed, this, [=](const QString &oldUri, const QString &newUri){
+        DesktopLayoutStore::getInstance()->movePosition(oldUri, newUri);
+    });
+
     connect(m_model, &DesktopItemModel::fileCreated, this, [=](const QString &uri){
         if (m_new_files_to_be_selected.isEmpty()) {
             m_new_files_to_be_selected<<uri;
@@ -238,7 +239,8 @@ DesktopIconView::DesktopIconView(QWidget *parent) : QListView(parent)
 
     connect(this, &QListView::iconSizeChanged, this, [=](){
         //qDebug()<<"save=============";
-        this->setSortType(GlobalSettings::getInstance()->getValue(LAST_DESKTOP_SORT_ORDER).toInt());
+        //the cells of items are kept by layout engine while zooming,
+        //there is no need to resort them, only save the new positions.
 #if QT_VERSION > QT_VERSION_CHECK(5, 12, 0)
         QTimer::singleShot(100, this, [=](){
 #else
@@ -485,103 +487,83 @@ void DesktopIconView::initDoubleClick()
 void DesktopIconView::saveAllItemPosistionInfos()
 {
     //qDebug()<<"======================save";
+    executeDelayedItemsLayout();
+    auto store = DesktopLayoutStore::getInstance();
     for (int i = 0; i < m_proxy_model->rowCount(); i++) {
         auto index = m_proxy_model->index(i, 0);
-        auto indexRect = QListView::visualRect(index);
-        QStringList topLeft;
-        topLeft<<QString::number(indexRect.top());
-        topLeft<<QString::number(indexRect.left());
-
-        auto metaInfo = FileMetaInfo::fromUri(index.data(Qt::UserRole).toString());
-        if (metaInfo) {
-            //qDebug()<<"save real"<<index.data()<<topLeft;
-            metaInfo->setMetaInfoStringList(ITEM_POS_ATTRIBUTE, topLeft);
-        }
+        auto indexRect = m_layout.cellRect(m_layout.cellOf(i));
+        store->setPosition(index.data(Qt::UserRole).toString(), indexRect.topLeft());
     }
     //qDebug()<<"======================save finished";
 }
 
 void DesktopIconView::saveItemPositionInfo(const QString &uri)
 {
+    executeDelayedItemsLayout();
     auto index = m_proxy_model->mapFromSource(m_model->indexFromUri(uri));
-    auto indexRect = QListView::visualRect(index);
-    QStringList topLeft;
-    topLeft<<QString::number(indexRect.top());
-    topLeft<<QString::number(indexRect.left());
-    auto metaInfo = FileMetaInfo::fromUri(index.data(Qt::UserRole).toString());
-    if (metaInfo) {
-        //qDebug()<<"save"<<uri<<topLeft;
-        metaInfo->setMetaInfoStringList(ITEM_POS_ATTRIBUTE, topLeft);
-    }
+    if (!index.isValid())
+        return;
+    auto indexRect = m_layout.cellRect(m_layout.cellOf(index.row()));
+    DesktopLayoutStore::getInstance()->setPosition(uri, indexRect.topLeft());
 }
 
 void DesktopIconView::resetAllItemPositionInfos()
 {
+    //the reset items will be saved with their current positions when updated.
+    auto store = DesktopLayoutStore::getInstance();
     for (int i = 0; i < m_proxy_model->rowCount(); i++) {
         auto index = m_proxy_model->index(i, 0);
-        auto indexRect = QListView::visualRect(index);
-        QStringList topLeft;
-        topLeft<<QString::number(indexRect.top());
-        topLeft<<QString::number(indexRect.left());
-        auto metaInfo = FileMetaInfo::fromUri(index.data(Qt::UserRole).toString());
-        if (metaInfo) {
-            QStringList tmp;
-            tmp<<"-1"<<"-1";
-            metaInfo->setMetaInfoStringList(ITEM_POS_ATTRIBUTE, tmp);
-        }
+        store->setPosition(index.data(Qt::UserRole).toString(), QPoint(-1, -1));
     }
 }
 
 void DesktopIconView::resetItemPosistionInfo(const QString &uri)
 {
-    auto metaInfo = FileMetaInfo::fromUri(uri);
-    if (metaInfo)
-        metaInfo->removeMetaInfo(ITEM_POS_ATTRIBUTE);
+    DesktopLayoutStore::getInstance()->removePosition(uri);
 }
 
 void DesktopIconView::updateItemPosistions(const QString &uri)
 {
+    executeDelayedItemsLayout();
+    //this monitor configuration has no layout yet, import the
+    //positions which were saved as metadata by older versions.
+    bool importMetaInfo = !DesktopLayoutStore::getInstance()->hasLayout();
     if (uri.isNull()) {
         for (int i = 0; i < m_proxy_model->rowCount(); i++) {
-            auto index = m_proxy_model->index(i, 0);
-            auto metaInfo = FileMetaInfo::fromUri(index.data(Qt::UserRole).toString());
-            if (metaInfo) {
-                updateItemPosistions(index.data(Qt::UserRole).toString());
-            }
+            updateItemPosition(i, importMetaInfo);
         }
         return;
     }
 
     auto index = m_proxy_model->mapFromSource(m_model->indexFromUri(uri));
     //qDebug()<<"update"<<uri<<index.data();
+    if (index.isValid())
+        updateItemPosition(index.row(), importMetaInfo);
+}
 
-    if (!index.isValid()) {
-        //qDebug()<<"err: index invalid";
-        return;
-    }
-    auto metaInfo = FileMetaInfo::fromUri(uri);
-    if (!metaInfo) {
-        //qDebug()<<"err: no meta data";
-        return;
+void DesktopIconView::updateItemPosition(int row, bool importMetaInfo)
+{
+    auto uri = m_proxy_model->index(row, 0).data(Qt::UserRole).toString();
+    auto store = DesktopLayoutStore::getInstance();
+    if (!store->contains(uri)) {
+        if (!importMetaInfo)
+            return;
+        auto metaInfo = FileMetaInfo::fromUri(uri);
+        if (!metaInfo)
+            return;
+        auto list = metaInfo->getMetaInfoStringList(ITEM_POS_ATTRIBUTE);
+        if (list.count() != 2)
+            return;
+        store->setPosition(uri, QPoint(list.at(1).toInt(), list.first().toInt()));
     }
 
-    auto list = metaInfo->getMetaInfoStringList(ITEM_POS_ATTRIBUTE);
-    if (!list.isEmpty()) {
-        if (list.count() == 2) {
-            int top = list.first().toInt();
-            int left = list.at(1).toInt();
-            if (top >= 0 && left >= 0) {
-//                auto rect = visualRect(index);
-//                auto grid = gridSize();
-//                if (abs(rect.top() - top) < grid.width() && abs(rect.left() - left))
-//                    return;
-                QPoint p(left, top);
-                //qDebug()<<"set"<<index.data()<<p;
-                setPositionForIndex(QPoint(left, top), index);
-            } else {
-                saveItemPositionInfo(uri);
-            }
-        }
+    auto p = store->position(uri);
+    if (p.x() >= 0 && p.y() >= 0) {
+        //qDebug()<<"set"<<uri<<p;
+        m_layout.moveItem(row, m_layout.cellAt(p));
+        viewport()->update();
+    } else {
+        saveItemPositionInfo(uri);
     }
 }
 
@@ -642,6 +624,7 @@ int DesktopIconView::getSortOrder()
 void DesktopIconView::setSortOrder(int sortOrder)
 {
     m_proxy_model->sort(0, Qt::SortOrder(sortOrder));
+    DesktopViewSettings::getInstance()->setSortOrder(sortOrder);
 }
 
 void DesktopIconView::editUri(const QString &uri)
@@ -751,6 +734,8 @@ void DesktopIconView::keyPressEvent(QKeyEvent *e)
 void DesktopIconView::resizeEvent(QResizeEvent *e)
 {
     QListView::resizeEvent(e);
+    //each monitor configuration has its own layout.
+    DesktopLayoutStore::getInstance()->setScreenSize(e->size());
     refresh();
 }
 
@@ -801,6 +786,12 @@ Huge //icon: 96x96; grid: 130x150; hover rect = 120x140; font: system*1.4
 void DesktopIconView::setDefaultZoomLevel(ZoomLevel level)
 {
     //qDebug()<<"set default zoom level:"<<level;
+    applyZoomLevel(level);
+    DesktopViewSettings::getInstance()->setZoomLevel(int(m_zoom_level));
+}
+
+void DesktopIconView::applyZoomLevel(ZoomLevel level)
+{
     m_zoom_level = level;
     switch (level) {
     case Small:
@@ -821,52 +812,43 @@ void DesktopIconView::setDefaultZoomLevel(ZoomLevel level)
         setGridSize(QSize(96, 96));
         break;
     }
-    clearAllIndexWidgets();
-    auto metaInfo = FileMetaInfo::fromUri("computer:///");
-    if (metaInfo) {
-        qDebug()<<"set zoom level"<<m_zoom_level;
-        metaInfo->setMetaInfoInt("peony-qt-desktop-zoom-level", int(m_zoom_level));
-    } else {
 
+    //the item rect in a cell, it was offset from the QListView's item rect in
+    //visualRect(), which is vertically centered in grid.
+    auto grid = gridSize();
+    auto itemSize = itemDelegate()->sizeHint(viewOptions(), QModelIndex()).boundedTo(grid);
+    QPoint offset(10, 5);
+    switch (m_zoom_level) {
+    case Small:
+        offset *= 0.8;
+        break;
+    case Large:
+        offset *= 1.2;
+        break;
+    case Huge:
+        offset *= 1.4;
+        break;
+    default:
+        break;
     }
+    offset.ry() += (grid.height() - itemSize.height())/2;
+    m_layout.setGridSize(grid);
+    m_layout.setItemRect(QRect(offset, itemSize));
+    viewport()->update();
+
+    clearAllIndexWidgets();
 }
 
 DesktopIconView::ZoomLevel DesktopIconView::zoomLevel() const
 {
-    //FIXME:
-    if (m_zoom_level != Invalid)
-        return m_zoom_level;
-
-    auto metaInfo = FileMetaInfo::fromUri("computer:///");
-    if (metaInfo) {
-        auto i = metaInfo->getMetaInfoInt("peony-qt-desktop-zoom-level");
-        return ZoomLevel(i);
-    }
-
-    GFile *computer = g_file_new_for_uri("computer:///");
-    GFileInfo *info = g_file_query_info(computer,
-                                        "metadata::peony-qt-desktop-zoom-level",
-                                        G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
-                                        nullptr,
-                                        nullptr);
-    char* zoom_level = g_file_info_get_attribute_as_string(info, "metadata::peony-qt-desktop-zoom-level");
-    if (!zoom_level) {
-        //qDebug()<<"======================no zoom level meta info\n\n\n";
-        g_object_unref(info);
-        g_object_unref(computer);
-        return Normal;
-    }
-    g_object_unref(info);
-    g_object_unref(computer);
-    QString zoomLevel = zoom_level;
-    g_free(zoom_level);
-    //qDebug()<<ZoomLevel(QString(zoomLevel).toInt())<<"\n\n\n\n\n\n\n\n";
-    return ZoomLevel(zoomLevel.toInt()) == Invalid? Normal: ZoomLevel(QString(zoomLevel).toInt());
+    //zoom level is always applied in constructor, see DesktopViewSettings.
+    return m_zoom_level == Invalid? Normal: m_zoom_level;
 }
 
 void DesktopIconView::mousePressEvent(QMouseEvent *e)
 {
     m_real_do_edit = false;
+    m_pressed_pos = e->pos() + QPoint(horizontalOffset(), verticalOffset());
     if (!indexAt(e->pos()).isValid()) {
         clearAllIndexWidgets();
         clearSelection();
@@ -906,9 +888,28 @@ void DesktopIconView::mousePressEvent(QMouseEvent *e)
     QListView::mousePressEvent(e);
 }
 
+void DesktopIconView::mouseMoveEvent(QMouseEvent *e)
+{
+    QListView::mouseMoveEvent(e);
+
+    if (state() != DragSelectingState)
+        return;
+
+    const QPoint offset(horizontalOffset(), verticalOffset());
+    auto rubberBand = QRect(m_pressed_pos, e->pos() + offset).normalized();
+    viewport()->update(rubberBand.united(m_rubber_band).translated(-offset).adjusted(-16, -16, 16, 16));
+    m_rubber_band = rubberBand;
+}
+
 void DesktopIconView::mouseReleaseEvent(QMouseEvent *e)
 {
     QListView::mouseReleaseEvent(e);
+
+    if (m_rubber_band.isValid()) {
+        const QPoint offset(horizontalOffset(), verticalOffset());
+        viewport()->update(m_rubber_band.translated(-offset).adjusted(-16, -16, 16, 16));
+        m_rubber_band = QRect();
+    }
 }
 
 void DesktopIconView::mouseDoubleClickEvent(QMouseEvent *event)
@@ -924,6 +925,7 @@ void DesktopIconView::dragEnterEvent(QDragEnterEvent *e)
     if (e->mimeData()->hasUrls()) {
         e->setDropAction(Qt::MoveAction);
         e->acceptProposedAction();
+        setState(DraggingState);
     }
 }
 
@@ -938,6 +940,22 @@ void DesktopIconView::dragMoveEvent(QDragMoveEvent *e)
         QHoverEvent he(QHoverEvent::HoverLeave, e->posF(), e->posF());
         viewportEvent(&he);
     }
+
+    //indicate the folder to drop into, or the cell an internal move puts the
+    //dragged item into.
+    const QPoint offset(horizontalOffset(), verticalOffset());
+    QRect dropIndicatorRect;
+    if (index.isValid()) {
+        if (this != e->source() || !selectionModel()->isSelected(index))
+            dropIndicatorRect = visualRect(index).translated(offset);
+    } else if (this == e->source()) {
+        dropIndicatorRect = m_layout.cellRect(m_layout.cellAt(e->pos() + offset));
+    }
+    if (dropIndicatorRect != m_drop_indicator_rect) {
+        viewport()->update(dropIndicatorRect.united(m_drop_indicator_rect).translated(-offset).adjusted(-2, -2, 2, 2));
+        m_drop_indicator_rect = dropIndicatorRect;
+    }
+
     if (e->isAccepted())
         return;
     //qDebug()<<"drag move event";
@@ -949,9 +967,20 @@ void DesktopIconView::dragMoveEvent(QDragMoveEvent *e)
     e->accept();
 }
 
+void DesktopIconView::dragLeaveEvent(QDragLeaveEvent *e)
+{
+    const QPoint offset(horizontalOffset(), verticalOffset());
+    viewport()->update(m_drop_indicator_rect.translated(-offset).adjusted(-2, -2, 2, 2));
+    m_drop_indicator_rect = QRect();
+    QListView::dragLeaveEvent(e);
+}
+
 void DesktopIconView::dropEvent(QDropEvent *e)
 {
     m_real_do_edit = false;
+    const QPoint offset(horizontalOffset(), verticalOffset());
+    viewport()->update(m_drop_indicator_rect.translated(-offset).adjusted(-2, -2, 2, 2));
+    m_drop_indicator_rect = QRect();
     //qDebug()<<"drop event";
     /*!
       \todo
@@ -969,9 +998,25 @@ void DesktopIconView::dropEvent(QDropEvent *e)
             auto info = FileInfo::fromUri(index.data(Qt::UserRole).toString());
             if (!info->isDir())
                 return;
+            //move into the folder.
+            QAbstractItemView::dropEvent(e);
+            return;
         }
 
-        QListView::dropEvent(e);
+        //move the dragged items by the cells they were dragged over, as
+        //QListView::Snap movement does.
+        auto cellOffset = m_layout.cellAt(e->pos() + offset) - m_layout.cellAt(m_pressed_pos);
+        QVector<int> rows;
+        for (auto selection : selectedIndexes()) {
+            rows<<selection.row();
+        }
+        m_layout.moveItems(rows, cellOffset);
+        viewport()->update();
+        updateEditorGeometries();
+
+        //internal move should not remove the dragged items, see QListView::startDrag().
+        e->setDropAction(Qt::CopyAction);
+        e->accept();
 
         auto urls = e->mimeData()->urls();
         for (auto url : urls) {
@@ -981,6 +1026,7 @@ void DesktopIconView::dropEvent(QDropEvent *e)
         }
         return;
     }
+    setState(NoState);
     m_model->dropMimeData(e->mimeData(), Qt::MoveAction, -1, -1, this->indexAt(e->pos()));
     //FIXME: save item position
 }
@@ -1031,22 +1077,160 @@ void DesktopIconView::refresh()
 
 QRect DesktopIconView::visualRect(const QModelIndex &index) const
 {
-    auto rect = QListView::visualRect(index);
-    QPoint p(10, 5);
+    if (!index.isValid() || index.parent() != rootIndex())
+        return QRect();
 
-    switch (zoomLevel()) {
-    case Small:
-        p *= 0.8;
-        break;
-    case Large:
-        p *= 1.2;
+    auto rect = m_layout.itemRect(index.row());
+    return rect.translated(-horizontalOffset(), -verticalOffset());
+}
+
+QModelIndex DesktopIconView::indexAt(const QPoint &point) const
+{
+    if (!model())
+        return QModelIndex();
+
+    int row = m_layout.itemAt(point + QPoint(horizontalOffset(), verticalOffset()));
+    if (row < 0)
+        return QModelIndex();
+    return model()->index(row, modelColumn(), rootIndex());
+}
+
+void DesktopIconView::doItemsLayout()
+{
+    m_layout.setGridSize(gridSize());
+    m_layout.setViewportSize(viewport()->size());
+
+    int rowCount = model()? model()->rowCount(rootIndex()): 0;
+    if (m_layout_invalid || m_layout.count() != rowCount) {
+        m_layout.reset(rowCount);
+        m_layout_invalid = false;
+    }
+
+    //skip the QListView's layout.
+    QAbstractItemView::doItemsLayout();
+}
+
+void DesktopIconView::rowsInserted(const QModelIndex &parent, int start, int end)
+{
+    //new items are put into free cells, other items keep their cells.
+    if (parent == rootIndex()) {
+        m_layout.insertItems(start, end - start + 1);
+        viewport()->update();
+    }
+    QAbstractItemView::rowsInserted(parent, start, end);
+}
+
+void DesktopIconView::rowsAboutToBeRemoved(const QModelIndex &parent, int start, int end)
+{
+    if (parent == rootIndex()) {
+        if (m_hover_index.isValid() && m_hover_index.row() >= start && m_hover_index.row() <= end)
+            m_hover_index = QModelIndex();
+        m_layout.removeItems(start, end - start + 1);
+        viewport()->update();
+    }
+    QAbstractItemView::rowsAboutToBeRemoved(parent, start, end);
+}
+
+void DesktopIconView::setSelection(const QRect &rect, QItemSelectionModel::SelectionFlags command)
+{
+    if (!model() || !selectionModel())
+        return;
+
+    auto rows = m_layout.itemsIn(rect.normalized().translated(horizontalOffset(), verticalOffset()));
+    int rowCount = model()->rowCount(rootIndex());
+
+    QItemSelection selection;
+    for (auto row : rows) {
+        if (row >= rowCount)
+            break;
+        auto index = model()->index(row, modelColumn(), rootIndex());
+        selection.select(index, index);
+    }
+    selectionModel()->select(selection, command);
+}
+
+void DesktopIconView::updateGeometries()
+{
+    //scroll bars are always off in desktop, skip the QListView's
+    //scroll bars updating, it depends on its own layout.
+    QAbstractItemView::updateGeometries();
+}
+
+bool DesktopIconView::viewportEvent(QEvent *e)
+{
+    switch (e->type()) {
+    case QEvent::HoverEnter:
+    case QEvent::HoverMove:
+        m_hover_index = indexAt(static_cast<QHoverEvent *>(e)->pos());
         break;
-    case Huge:
-        p *= 1.4;
+    case QEvent::HoverLeave:
+    case QEvent::Leave:
+        m_hover_index = QModelIndex();
         break;
     default:
         break;
     }
-    rect.moveTo(rect.topLeft() + p);
-    return rect;
+    return QListView::viewportEvent(e);
+}
+
+void DesktopIconView::paintEvent(QPaintEvent *e)
+{
+    if (!model())
+        return;
+
+    QPainter p(viewport());
+
+    //only the items in exposed cells are painted.
+    const QPoint offset(horizontalOffset(), verticalOffset());
+    auto rows = m_layout.itemsIn(e->rect().translated(offset));
+
+    QStyleOptionViewItem option = viewOptions();
+    const QStyle::State state = option.state;
+    const bool enabled = (state & QStyle::State_Enabled) != 0;
+    const QModelIndex current = currentIndex();
+    const bool focus = (hasFocus() || viewport()->hasFocus()) && current.isValid();
+    for (auto row : rows) {
+        auto index = model()->index(row, modelColumn(), rootIndex());
+        if (!index.isValid())
+            continue;
+
+        option.rect = visualRect(index);
+        option.state = state;
+        if (selectionModel() && selectionModel()->isSelected(index))
+            option.state |= QStyle::State_Selected;
+        if (enabled) {
+            if (model()->flags(index) & Qt::ItemIsEnabled) {
+                option.palette.setCurrentColorGroup(QPalette::Normal);
+            } else {
+                option.state &= ~QStyle::State_Enabled;
+                option.palette.setCurrentColorGroup(QPalette::Disabled);
+            }
+        }
+        if (focus && index == current) {
+            option.state |= QStyle::State_HasFocus;
+            if (this->state() == EditingState)
+                option.state |= QStyle::State_Editing;
+        }
+        option.state.setFlag(QStyle::State_MouseOver, index == m_hover_index);
+
+        itemDelegate(index)->paint(&p, option, index);
+    }
+
+    if (m_rubber_band.isValid()) {
+        QStyleOptionRubberBand opt;
+        opt.initFrom(this);
+        opt.shape = QRubberBand::Rectangle;
+        opt.opaque = false;
+        opt.rect = m_rubber_band.translated(-offset).intersected(viewport()->rect().adjusted(-16, -16, 16, 16));
+        p.save();
+        style()->drawControl(QStyle::CE_RubberBand, &opt, &p);
+        p.restore();
+    }
+
+    if (state() == DraggingState && showDropIndicator() && m_drop_indicator_rect.isValid()) {
+        QStyleOption opt;
+        opt.initFrom(this);
+        opt.rect = m_drop_indicator_rect.translated(-offset);
+        style()->drawPrimitive(QStyle::PE_IndicatorItemViewItemDrop, &opt, &p, this);
+    }
 }
@@ -25,6 +25,7 @@
 
 #include <QListView>
 #include "directory-view-plugin-iface.h"
+#include "grid-layout-engine.h"
 
 #include <QStandardPaths>
 #include <QTimer>
@@ -77,8 +78,18 @@ public:
     int getSortOrder();
 
     QRect visualRect(const QModelIndex &index) const;
+    QModelIndex indexAt(const QPoint &point) const;
     const QFont getViewItemFont(QStyleOptionViewItem *item);
 
+    /*!
+     * \brief doItemsLayout
+     * \details
+     * Desktop items are placed by a free placement GridLayoutEngine. The cells of
+     * items are kept unless the model is reset or resorted, then all the
+     * items are placed in flow order and their saved positions will be restored.
+     */
+    void doItemsLayout();
+
 Q_SIGNALS:
     void zoomLevelChanged(ZoomLevel level);
 
@@ -128,21 +139,58 @@ public Q_SLOTS:
 
 protected:
     void mousePressEvent(QMouseEvent *e);
+    void mouseMoveEvent(QMouseEvent *e);
     void mouseReleaseEvent(QMouseEvent *e);
     void mouseDoubleClickEvent(QMouseEvent *event);
 
     void dragEnterEvent(QDragEnterEvent *e);
     void dragMoveEvent(QDragMoveEvent *e);
+    void dragLeaveEvent(QDragLeaveEvent *e);
     void dropEvent(QDropEvent *e);
 
     void wheelEvent(QWheelEvent *e);
     void keyPressEvent(QKeyEvent *e);
 
     void resizeEvent(QResizeEvent *e);
+    void paintEvent(QPaintEvent *e);
+    bool viewportEvent(QEvent *e);
+
+    void rowsInserted(const QModelIndex &parent, int start, int end);
+    void rowsAboutToBeRemoved(const QModelIndex &parent, int start, int end);
+
+    void setSelection(const QRect &rect, QItemSelectionModel::SelectionFlags command);
+    void updateGeometries();
+
+private:
+    /*!
+     * \brief applyZoomLevel
+     * \param level
+     * \details
+     * Set the icon size, grid size and item rect of level without saving it.
+     */
+    void applyZoomLevel(ZoomLevel level);
+
+    /*!
+     * \brief updateItemPosition
+     * \param row
+     * \param importMetaInfo
+     * \details
+     * Move the item to its position saved in DesktopLayoutStore. If importMetaInfo
+     * is true, the position saved as file metadata is used when there is none.
+     */
+    void updateItemPosition(int row, bool importMetaInfo);
 
 private:
     ZoomLevel m_zoom_level = Invalid;
 
+    GridLayoutEngine m_layout = GridLayoutEngine(GridLayoutEngine::TopToBottom, GridLayoutEngine::Free);
+    bool m_layout_invalid = true;
+    QPersistentModelIndex m_hover_index;
+    QRect m_rubber_band;
+    //in contents coordinates, as the rubber band.
+    QRect m_drop_indicator_rect;
+    QPoint m_pressed_pos;
+
     QModelIndex m_last_index;
     QTimer m_edit_trigger_timer;
 
@@ -26,6 +26,9 @@
 #include "desktop-icon-view-delegate.h"
 #include "desktop-icon-view.h"
 
+#include "thumbnail-manager.h"
+#include "thumbnail-shadow.h"
+
 #include <QPainter>
 #include <QStyle>
 #include <QApplication>
@@ -92,6 +95,9 @@ void DesktopIndexWidget::paintEvent(QPaintEvent *e)
     //setFixedHeight(opt.rect.height() + y_delta);
 
     // draw icon
+    if (ThumbnailManager::getInstance()->hasShadow(m_index.data(Qt::UserRole).toString())) {
+        ThumbnailShadow::paint(&p, opt);
+    }
     opt.text = nullptr;
     QApplication::style()->drawControl(QStyle::CE_ItemViewItem, &opt, &p, m_delegate->getView());
 
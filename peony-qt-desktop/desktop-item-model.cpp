@@ -32,11 +32,13 @@
 #include "file-trash-operation.h"
 
 #include "thumbnail-manager.h"
+#include "theme-icon-cache.h"
 
 #include "file-meta-info.h"
 
 #include <QStandardPaths>
 #include <QIcon>
+#include <QApplication>
 
 #include <QMimeData>
 #include <QUrl>
@@ -45,11 +47,51 @@
 
 #include <QDebug>
 
+//save the snapshot once after a batch of changes.
+#define SNAPSHOT_SAVE_DELAY 1000
+
 using namespace Peony;
 
+static QVariant snapshotData(const DesktopSnapshotItem &item, int role)
+{
+    switch (role) {
+    case Qt::DisplayRole:
+    case Qt::ToolTipRole:
+        return item.displayName;
+    case Qt::DecorationRole:
+        return ThemeIconCache::getInstance()->icon(item.iconName, "text-x-generic");
+    case DesktopItemModel::UriRole:
+        return item.uri;
+    case DesktopItemModel::IsLinkRole:
+        return false;
+    }
+    return QVariant();
+}
+
 DesktopItemModel::DesktopItemModel(QObject *parent)
     : QAbstractListModel(parent)
 {
+    m_snapshot_timer.setSingleShot(true);
+    m_snapshot_timer.setInterval(SNAPSHOT_SAVE_DELAY);
+    connect(&m_snapshot_timer, &QTimer::timeout, this, &DesktopItemModel::updateSnapshot);
+
+    auto scheduleSnapshot = [=](){
+        if (!m_showing_snapshot)
+            m_snapshot_timer.start();
+    };
+    connect(this, &DesktopItemModel::refreshed, this, scheduleSnapshot);
+    connect(this, &DesktopItemModel::rowsInserted, this, scheduleSnapshot);
+    connect(this, &DesktopItemModel::rowsRemoved, this, scheduleSnapshot);
+    connect(this, &DesktopItemModel::dataChanged, this, scheduleSnapshot);
+
+    connect(qApp, &QApplication::aboutToQuit, this, [=](){
+        if (m_snapshot_timer.isActive()) {
+            m_snapshot_timer.stop();
+            updateSnapshot();
+        }
+        DesktopSnapshot::getInstance()->sync();
+    });
+
     m_thumbnail_watcher = std::make_shared<FileWatcher>("thumbnail:///, this");
 
     connect(m_thumbnail_watcher.get(), &FileWatcher::fileChanged, this, [=](const QString &uri){
@@ -121,6 +163,8 @@ DesktopItemModel::DesktopItemModel(QObject *parent)
         }
     });
 
+    this->connect(m_desktop_watcher.get(), &FileWatcher::fileRenamed, this, &DesktopItemModel::fileRenamed);
+
     this->connect(m_desktop_watcher.get(), &FileWatcher::fileDeleted, [=](const QString &uri){
         for (auto info : m_files) {
             if (info->uri() == uri) {
@@ -172,12 +216,25 @@ void DesktopItemModel::refresh()
     }
     m_files.clear();
 
+    //paint the desktop of last time immediately at startup.
+    if (!m_snapshot_loaded) {
+        m_snapshot_loaded = true;
+        m_snapshot_items = DesktopSnapshot::getInstance()->items();
+        for (int i = 0; i < m_snapshot_items.count(); i++) {
+            m_snapshot_index.insert(m_snapshot_items.at(i).uri, i);
+        }
+        m_showing_snapshot = !m_snapshot_items.isEmpty();
+    }
+
     m_enumerator = new FileEnumerator(this);
     m_enumerator->setAutoDelete();
     m_enumerator->setEnumerateDirectory("file://" + QStandardPaths::writableLocation(QStandardPaths::DesktopLocation));
     m_enumerator->connect(m_enumerator, &FileEnumerator::enumerateFinished, this, &DesktopItemModel::onEnumerateFinished);
     m_enumerator->enumerateAsync();
     endResetModel();
+
+    if (m_showing_snapshot)
+        Q_EMIT requestUpdateItemPositions();
 }
 
 int DesktopItemModel::rowCount(const QModelIndex &parent) const
@@ -187,6 +244,8 @@ int DesktopItemModel::rowCount(const QModelIndex &parent) const
     if (parent.isValid())
         return 0;
 
+    if (m_showing_snapshot)
+        return m_snapshot_items.count();
     return m_files.count();
 }
 
@@ -195,8 +254,18 @@ QVariant DesktopItemModel::data(const QModelIndex &index, int role) const
     if (!index.isValid())
         return QVariant();
 
+    if (m_showing_snapshot)
+        return snapshotData(m_snapshot_items.at(index.row()), role);
+
     //qDebug()<<"data"<<m_files.at(index.row())->uri();
     auto info = m_files.at(index.row());
+    if (info->isEmptyInfo()) {
+        //the info is not queried yet, keep showing the snapshot.
+        int snapshotRow = m_snapshot_index.value(info->uri(), -1);
+        if (snapshotRow >= 0)
+            return snapshotData(m_snapshot_items.at(snapshotRow), role);
+    }
+
     switch (role) {
     case Qt::DisplayRole:
         return info->displayName();
@@ -207,11 +276,11 @@ QVariant DesktopItemModel::data(const QModelIndex &index, int role) const
         auto thumbnail = ThumbnailManager::getInstance()->tryGetThumbnail(info->uri());
         if (!thumbnail.isNull()) {
             if (info->uri().endsWith(".desktop") && !info->canExecute()) {
-                return QIcon::fromTheme(info->iconName(), QIcon::fromTheme("text-x-generic"));
+                return ThemeIconCache::getInstance()->icon(info->iconName(), "text-x-generic");
             }
             return thumbnail;
         }
-        return QIcon::fromTheme(info->iconName(), QIcon::fromTheme("text-x-generic"));
+        return ThemeIconCache::getInstance()->icon(info->iconName(), "text-x-generic");
     }
     case UriRole:
         return info->uri();
@@ -223,7 +292,12 @@ QVariant DesktopItemModel::data(const QModelIndex &index, int role) const
 
 void DesktopItemModel::onEnumerateFinished()
 {
-    //beginResetModel();
+    //replace the snapshot items with the real ones, their display names
+    //and icons are still taken from snapshot until the infos are queried.
+    bool showingSnapshot = m_showing_snapshot;
+    if (showingSnapshot)
+        beginResetModel();
+
     FileInfoManager::getInstance()->clear();
     m_files.clear();
 
@@ -257,6 +331,8 @@ void DesktopItemModel::onEnumerateFinished()
             m_info_query_queue.removeOne(info->uri());
             if (m_info_query_queue.isEmpty()) {
                 this->beginResetModel();
+                m_snapshot_items.clear();
+                m_snapshot_index.clear();
                 this->endResetModel();
                 Q_EMIT this->refreshed();
             }
@@ -265,6 +341,12 @@ void DesktopItemModel::onEnumerateFinished()
         job->queryAsync();
     }
 
+    if (showingSnapshot) {
+        m_showing_snapshot = false;
+        endResetModel();
+        Q_EMIT requestUpdateItemPositions();
+    }
+
     //qDebug()<<"startMornitor";
     m_trash_watcher->startMonitor();
     m_desktop_watcher->startMonitor();
@@ -272,6 +354,11 @@ void DesktopItemModel::onEnumerateFinished()
 
 const QModelIndex DesktopItemModel::indexFromUri(const QString &uri)
 {
+    if (m_showing_snapshot) {
+        int row = m_snapshot_index.value(uri, -1);
+        return row < 0? QModelIndex(): index(row);
+    }
+
     for (auto info : m_files) {
         if (info->uri() == uri) {
             return index(m_files.indexOf(info));
@@ -282,6 +369,12 @@ const QModelIndex DesktopItemModel::indexFromUri(const QString &uri)
 
 const QString DesktopItemModel::indexUri(const QModelIndex &index)
 {
+    if (m_showing_snapshot) {
+        if (index.row() < 0 || index.row() >= m_snapshot_items.count())
+            return nullptr;
+        return m_snapshot_items.at(index.row()).uri;
+    }
+
     if (index.row() < 0 || index.row() >= m_files.count()) {
         return nullptr;
     }
@@ -318,6 +411,10 @@ bool DesktopItemModel::removeRow(int row, const QModelIndex &parent)
 
 Qt::ItemFlags DesktopItemModel::flags(const QModelIndex &index) const
 {
+    //snapshot items can not be dragged or dropped before they are real files.
+    if (m_showing_snapshot)
+        return QAbstractItemModel::flags(index);
+
     auto uri = index.data(UriRole).toString();
     auto info = FileInfo::fromUri(uri, false);
     if (index.isValid()) {
@@ -401,6 +498,26 @@ bool DesktopItemModel::dropMimeData(const QMimeData *data, Qt::DropAction action
     return QAbstractItemModel::dropMimeData(data, action, row, column, parent);
 }
 
+void DesktopItemModel::updateSnapshot()
+{
+    //the infos are being queried.
+    if (m_showing_snapshot || !m_info_query_queue.isEmpty())
+        return;
+
+    QVector<DesktopSnapshotItem> items;
+    items.reserve(m_files.count());
+    for (auto info : m_files) {
+        if (info->isEmptyInfo())
+            continue;
+        DesktopSnapshotItem item;
+        item.uri = info->uri();
+        item.displayName = info->displayName();
+        item.iconName = info->iconName();
+        items<<item;
+    }
+    DesktopSnapshot::getInstance()->setItems(items);
+}
+
 Qt::DropActions DesktopItemModel::supportedDropActions() const
 {
     //return Qt::MoveAction;
@@ -25,8 +25,11 @@
 
 #include <QAbstractListModel>
 #include <QQueue>
+#include <QTimer>
 #include <memory>
 
+#include "desktop-snapshot.h"
+
 namespace Peony {
 
 class FileEnumerator;
@@ -78,12 +81,28 @@ Q_SIGNALS:
     void refreshed();
 
     void fileCreated(const QString &uri);
+    /*!
+     * \brief fileRenamed
+     * \details
+     * A desktop file is renamed, it is sent before the old item is removed and
+     * the new one is inserted.
+     */
+    void fileRenamed(const QString &oldUri, const QString &newUri);
 
 public Q_SLOTS:
+    /*!
+     * \brief refresh
+     * <br>
+     * Enumerate the desktop directory again. At the first refresh, the items of
+     * DesktopSnapshot are shown until the enumeration finished, and their display
+     * names and icons are used until the real file infos are queried.
+     * </br>
+     */
     void refresh();
 
 protected Q_SLOTS:
     void onEnumerateFinished();
+    void updateSnapshot();
 
 private:
     FileEnumerator *m_enumerator;
@@ -93,6 +112,12 @@ private:
     std::shared_ptr<FileWatcher> m_thumbnail_watcher; //just handle the thumbnail created.
 
     QQueue<QString> m_info_query_queue;
+
+    bool m_snapshot_loaded = false;
+    bool m_showing_snapshot = false;
+    QVector<DesktopSnapshotItem> m_snapshot_items;
+    QHash<QString, int> m_snapshot_index;
+    QTimer m_snapshot_timer;
 };
 
 }
@@ -50,14 +50,15 @@ bool DesktopItemProxyModel::filterAcceptsRow(int source_row, const QModelIndex &
     if (!sourceModel())
         return false;
 
+    //the display name might come from the desktop snapshot before
+    //the file info is queried, do not query the file info here.
     auto sourceIndex = sourceModel()->index(source_row, 0, source_parent);
-    auto uri = sourceIndex.data(Qt::UserRole).toString();
-    auto info = FileInfo::fromUri(uri);
-    //qDebug()<<"fiter"<<uri<<info->displayName();
-    if (info->displayName().isNull()) {
+    auto displayName = sourceIndex.data(Qt::DisplayRole).toString();
+    //qDebug()<<"fiter"<<displayName;
+    if (displayName.isNull()) {
         return false;
     }
-    if (info->displayName().startsWith(".")) {
+    if (displayName.startsWith(".")) {
         return false;
     }
     return true;
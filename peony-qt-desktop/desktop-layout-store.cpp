@@ -0,0 +1,265 @@
+/*
+ * Peony-Qt
+ *
+ * Copyright (C) 2019, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "desktop-layout-store.h"
+
+#include <QApplication>
+#include <QStandardPaths>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QUrl>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QtConcurrent>
+
+#include <QDebug>
+
+#define LAYOUT_FILE_NAME "peony-qt-desktop-layout.json"
+#define LAYOUT_FILE_VERSION 1
+
+//arranging the desktop changes all the items, write them once.
+#define WRITE_BEHIND_DELAY 1000
+
+using namespace Peony;
+
+static DesktopLayoutStore *global_instance = nullptr;
+
+DesktopLayoutStore *DesktopLayoutStore::getInstance()
+{
+    if (!global_instance) {
+        global_instance = new DesktopLayoutStore;
+        global_instance->load();
+    }
+    return global_instance;
+}
+
+DesktopLayoutStore::DesktopLayoutStore(QObject *parent) : QObject(parent)
+{
+    auto configDir = QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation) + "/org.ukui";
+    m_path = configDir + "/" + LAYOUT_FILE_NAME;
+
+    m_write_timer.setSingleShot(true);
+    m_write_timer.setInterval(WRITE_BEHIND_DELAY);
+    connect(&m_write_timer, &QTimer::timeout, this, &DesktopLayoutStore::writeAsync);
+
+    connect(qApp, &QApplication::aboutToQuit, this, &DesktopLayoutStore::sync);
+}
+
+void DesktopLayoutStore::load()
+{
+    m_layouts.clear();
+
+    QFile file(m_path);
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    QJsonParseError err;
+    auto doc = QJsonDocument::fromJson(file.readAll(), &err);
+    file.close();
+    if (err.error != QJsonParseError::NoError || !doc.isObject()) {
+        qDebug()<<"desktop layout file is broken:"<<err.errorString();
+        return;
+    }
+
+    //the files might be deleted or renamed while the desktop was not running,
+    //a uri is checked once even if it is in several layouts.
+    QHash<QString, bool> existence;
+    bool dropped = false;
+
+    auto layouts = doc.object().value("layouts").toObject();
+    for (auto it = layouts.constBegin(); it != layouts.constEnd(); it++) {
+        auto items = it.value().toObject();
+        QHash<QString, QPoint> positions;
+        positions.reserve(items.count());
+        for (auto item = items.constBegin(); item != items.constEnd(); item++) {
+            auto pos = item.value().toArray();
+            if (pos.count() != 2)
+                continue;
+
+            auto uri = item.key();
+            auto exists = existence.constFind(uri);
+            if (exists == existence.constEnd()) {
+                //only local files are checked, the special items such as
+                //computer:/// and trash:/// are always kept.
+                QUrl url(uri);
+                exists = existence.insert(uri, !url.isLocalFile() || QFileInfo::exists(url.toLocalFile()));
+            }
+            if (!exists.value()) {
+                dropped = true;
+                continue;
+            }
+            positions.insert(uri, QPoint(pos.at(0).toInt(), pos.at(1).toInt()));
+        }
+        m_layouts.insert(it.key(), positions);
+    }
+
+    if (dropped)
+        markDirty();
+}
+
+void DesktopLayoutStore::setScreenSize(const QSize &size)
+{
+    m_screen_size = size;
+    m_current_key = QString("%1x%2").arg(size.width()).arg(size.height());
+}
+
+bool DesktopLayoutStore::hasLayout()
+{
+    return !m_layouts.value(m_current_key).isEmpty();
+}
+
+bool DesktopLayoutStore::contains(const QString &uri)
+{
+    auto it = m_layouts.constFind(m_current_key);
+    if (it == m_layouts.constEnd())
+        return false;
+    return it->contains(uri);
+}
+
+const QPoint DesktopLayoutStore::position(const QString &uri)
+{
+    auto it = m_layouts.constFind(m_current_key);
+    if (it == m_layouts.constEnd())
+        return QPoint(-1, -1);
+    return it->value(uri, QPoint(-1, -1));
+}
+
+void DesktopLayoutStore::setPosition(const QString &uri, const QPoint &pos)
+{
+    //the desktop has not been put on a screen yet.
+    if (m_current_key.isNull())
+        return;
+
+    auto &positions = m_layouts[m_current_key];
+    auto it = positions.find(uri);
+    if (it != positions.end() && it.value() == pos)
+        return;
+
+    positions.insert(uri, pos);
+    markDirty();
+}
+
+void DesktopLayoutStore::removePosition(const QString &uri)
+{
+    auto it = m_layouts.find(m_current_key);
+    if (it == m_layouts.end())
+        return;
+
+    if (it->remove(uri) > 0)
+        markDirty();
+}
+
+void DesktopLayoutStore::movePosition(const QString &oldUri, const QString &newUri)
+{
+    if (oldUri == newUri)
+        return;
+
+    bool moved = false;
+    for (auto it = m_layouts.begin(); it != m_layouts.end(); it++) {
+        auto item = it->find(oldUri);
+        if (item == it->end())
+            continue;
+        it->insert(newUri, item.value());
+        it->remove(oldUri);
+        moved = true;
+    }
+
+    if (moved)
+        markDirty();
+}
+
+void DesktopLayoutStore::markDirty()
+{
+    m_dirty = true;
+    if (!m_write_timer.isActive())
+        m_write_timer.start();
+}
+
+const QByteArray DesktopLayoutStore::toJson()
+{
+    QJsonObject layouts;
+    for (auto it = m_layouts.constBegin(); it != m_layouts.constEnd(); it++) {
+        if (it->isEmpty())
+            continue;
+        QJsonObject items;
+        for (auto item = it->constBegin(); item != it->constEnd(); item++) {
+            QJsonArray pos;
+            pos<<item.value().x()<<item.value().y();
+            items.insert(item.key(), pos);
+        }
+        layouts.insert(it.key(), items);
+    }
+
+    QJsonObject root;
+    root.insert("version", LAYOUT_FILE_VERSION);
+    root.insert("layouts", layouts);
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+bool DesktopLayoutStore::write(const QByteArray &data)
+{
+    QDir().mkpath(QFileInfo(m_path).path());
+
+    //never leave a truncated file if we are interrupted.
+    QSaveFile file(m_path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug()<<"save desktop layout failed:"<<file.errorString();
+        return false;
+    }
+    file.write(data);
+    return file.commit();
+}
+
+void DesktopLayoutStore::writeAsync()
+{
+    if (!m_dirty)
+        return;
+
+    m_dirty = false;
+    auto data = toJson();
+    int generation = ++m_generation;
+    QtConcurrent::run([=](){
+        m_mutex.lock();
+        //a newer snapshot has been written already.
+        if (generation > m_written_generation) {
+            write(data);
+            m_written_generation = generation;
+        }
+        m_mutex.unlock();
+    });
+}
+
+void DesktopLayoutStore::sync()
+{
+    m_write_timer.stop();
+    //wait for the running write, or it might override the latest data.
+    m_mutex.lock();
+    if (m_dirty) {
+        m_dirty = false;
+        write(toJson());
+        m_written_generation = ++m_generation;
+    }
+    m_mutex.unlock();
+}
@@ -0,0 +1,147 @@
+/*
+ * Peony-Qt
+ *
+ * Copyright (C) 2019, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef DESKTOPLAYOUTSTORE_H
+#define DESKTOPLAYOUTSTORE_H
+
+#include <QObject>
+#include <QHash>
+#include <QPoint>
+#include <QSize>
+#include <QTimer>
+#include <QMutex>
+
+namespace Peony {
+
+/*!
+ * \brief The DesktopLayoutStore class
+ * <br>
+ * DesktopLayoutStore keeps the positions of desktop items in a single json file,
+ * ~/.config/org.ukui/peony-qt-desktop-layout.json. It used to be stored as the
+ * metadata of each file, which costs a gvfs-metadata request per item, so that
+ * arranging the desktop was very slow.
+ * </br>
+ * <br>
+ * The positions are grouped by screen size, each monitor configuration has its own
+ * layout and they do not override each other. Items are identified by their uris,
+ * so the positions are moved to the new uris when items are renamed, and the
+ * positions of the files which no longer exist are dropped when it is loaded.
+ * </br>
+ * <br>
+ * The file is small and loaded synchronously before the desktop is shown. The changes
+ * are only marked dirty in memory, and the whole file is written behind once
+ * in a worker thread after a short delay.
+ * </br>
+ */
+class DesktopLayoutStore : public QObject
+{
+    Q_OBJECT
+public:
+    static DesktopLayoutStore *getInstance();
+
+    /*!
+     * \brief load
+     * <br>
+     * Read the layout file. It is called when the instance is created, so
+     * the layout is ready before the first paint of desktop. The positions of
+     * the local files which do not exist any more are dropped.
+     * </br>
+     */
+    void load();
+
+    /*!
+     * \brief setScreenSize
+     * \param size
+     * <br>
+     * Choose the layout of the current monitor configuration, the following
+     * queries and changes only affect this layout.
+     * </br>
+     */
+    void setScreenSize(const QSize &size);
+    const QSize screenSize() {return m_screen_size;}
+
+    /*!
+     * \brief hasLayout
+     * \return true if the current screen size has ever saved any position.
+     */
+    bool hasLayout();
+
+    bool contains(const QString &uri);
+
+    /*!
+     * \brief position
+     * \param uri
+     * \return the saved top left of the item's cell. (-1, -1) if it is not saved,
+     * or it was reset and should be saved with its current position.
+     */
+    const QPoint position(const QString &uri);
+    void setPosition(const QString &uri, const QPoint &pos);
+    void removePosition(const QString &uri);
+    /*!
+     * \brief movePosition
+     * \param oldUri
+     * \param newUri
+     * <br>
+     * Move the positions of a renamed item to its new uri, in the layouts of
+     * all screen sizes.
+     * </br>
+     */
+    void movePosition(const QString &oldUri, const QString &newUri);
+
+public Q_SLOTS:
+    /*!
+     * \brief sync
+     * <br>
+     * Write the pending changes synchronously, it is called when the
+     * application is about to quit.
+     * </br>
+     */
+    void sync();
+
+private:
+    explicit DesktopLayoutStore(QObject *parent = nullptr);
+
+    void markDirty();
+    const QByteArray toJson();
+    void writeAsync();
+    bool write(const QByteArray &data);
+
+private:
+    QString m_path;
+    QSize m_screen_size;
+    QString m_current_key;
+
+    //screen size -> uri -> position.
+    QHash<QString, QHash<QString, QPoint>> m_layouts;
+
+    bool m_dirty = false;
+    QTimer m_write_timer;
+
+    //the snapshots might be written by worker threads out of order.
+    int m_generation = 0;
+    int m_written_generation = 0;
+    QMutex m_mutex;
+};
+
+}
+
+#endif // DESKTOPLAYOUTSTORE_H
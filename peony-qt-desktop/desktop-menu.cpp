@@ -37,6 +37,7 @@
 #include "desktop-icon-view.h"
 
 #include "desktop-menu-plugin-manager.h"
+#include "desktop-view-settings.h"
 
 #include "global-settings.h"
 
@@ -315,7 +316,7 @@ const QList<QAction *> DesktopMenu::constructViewOpActions()
         for (int i = 0; i < tmp.count(); i++) {
             connect(tmp.at(i), &QAction::triggered, [=](){
                 m_view->setSortType(i);
-                GlobalSettings::getInstance()->setValue(LAST_DESKTOP_SORT_ORDER, i);
+                DesktopViewSettings::getInstance()->setSortType(i);
             });
         }
 
@@ -376,8 +377,7 @@ const QList<QAction *> DesktopMenu::constructFileOpActions()
                                                                                           "Once you start a deletion, the files deleting will never be "
                                                                                           "restored again."));
                 if (result == QMessageBox::Yes) {
-                    FileEnumerator e;
-                    FileOperationUtils::remove(trashChildren);
+                    FileOperationUtils::emptyTrash();
                 }
             });
             l.last()->setEnabled(!trashChildren.isEmpty());
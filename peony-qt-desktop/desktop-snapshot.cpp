@@ -0,0 +1,207 @@
+/*
+ * Peony-Qt
+ *
+ * Copyright (C) 2019, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "desktop-snapshot.h"
+
+#include <QApplication>
+#include <QStandardPaths>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QCryptographicHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QtConcurrent>
+
+#include <QDebug>
+
+#define SNAPSHOT_FILE_NAME "snapshot.json"
+#define SNAPSHOT_FILE_VERSION 1
+
+using namespace Peony;
+
+static DesktopSnapshot *global_instance = nullptr;
+
+DesktopSnapshot *DesktopSnapshot::getInstance()
+{
+    if (!global_instance) {
+        global_instance = new DesktopSnapshot;
+    }
+    return global_instance;
+}
+
+DesktopSnapshot::DesktopSnapshot(QObject *parent) : QObject(parent)
+{
+    m_cache_dir = QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/peony-qt-desktop";
+
+    connect(qApp, &QApplication::aboutToQuit, this, &DesktopSnapshot::sync);
+}
+
+void DesktopSnapshot::load()
+{
+    m_loaded = true;
+
+    QFile file(m_cache_dir + "/" + SNAPSHOT_FILE_NAME);
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    QJsonParseError err;
+    auto doc = QJsonDocument::fromJson(file.readAll(), &err);
+    file.close();
+    if (err.error != QJsonParseError::NoError || !doc.isObject()) {
+        qDebug()<<"desktop snapshot is broken:"<<err.errorString();
+        return;
+    }
+
+    auto root = doc.object();
+    if (root.value("version").toInt() != SNAPSHOT_FILE_VERSION)
+        return;
+
+    auto items = root.value("items").toArray();
+    m_items.reserve(items.count());
+    for (auto value : items) {
+        auto object = value.toObject();
+        DesktopSnapshotItem item;
+        item.uri = object.value("uri").toString();
+        item.displayName = object.value("name").toString();
+        item.iconName = object.value("icon").toString();
+        if (!item.uri.isEmpty())
+            m_items<<item;
+    }
+}
+
+const QVector<DesktopSnapshotItem> DesktopSnapshot::items()
+{
+    if (!m_loaded)
+        load();
+    return m_items;
+}
+
+void DesktopSnapshot::setItems(const QVector<DesktopSnapshotItem> &items)
+{
+    m_loaded = true;
+    m_items = items;
+
+    auto data = toJson();
+    int generation = ++m_generation;
+    QtConcurrent::run([=](){
+        m_mutex.lock();
+        //a newer snapshot has been written already.
+        if (generation > m_written_generation) {
+            write(data);
+            m_written_generation = generation;
+        }
+        m_mutex.unlock();
+    });
+}
+
+const QByteArray DesktopSnapshot::toJson()
+{
+    QJsonArray items;
+    for (auto item : m_items) {
+        QJsonObject object;
+        object.insert("uri", item.uri);
+        object.insert("name", item.displayName);
+        object.insert("icon", item.iconName);
+        items.append(object);
+    }
+
+    QJsonObject root;
+    root.insert("version", SNAPSHOT_FILE_VERSION);
+    root.insert("items", items);
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
+
+bool DesktopSnapshot::write(const QByteArray &data)
+{
+    QDir().mkpath(m_cache_dir);
+
+    QSaveFile file(m_cache_dir + "/" + SNAPSHOT_FILE_NAME);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qDebug()<<"save desktop snapshot failed:"<<file.errorString();
+        return false;
+    }
+    file.write(data);
+    return file.commit();
+}
+
+void DesktopSnapshot::sync()
+{
+    //wait for the running write, or it might override the latest data.
+    m_mutex.lock();
+    if (m_generation > m_written_generation) {
+        write(toJson());
+        m_written_generation = m_generation;
+    }
+    m_mutex.unlock();
+}
+
+const QString DesktopSnapshot::wallpaperCachePath(const QString &path, const QSize &size)
+{
+    //the cache is invalid once the wallpaper file is modified.
+    QFileInfo info(path);
+    auto key = QString("%1:%2").arg(path).arg(info.lastModified().toMSecsSinceEpoch());
+    auto hash = QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Md5).toHex();
+    return QString("%1/wallpaper-%2x%3-%4").arg(m_cache_dir).arg(size.width()).arg(size.height()).arg(QString(hash));
+}
+
+const QImage DesktopSnapshot::wallpaper(const QString &path, const QSize &size)
+{
+    auto cachePath = wallpaperCachePath(path, size);
+    if (!QFile::exists(cachePath))
+        return QImage();
+
+    //the image format is detected from the contents.
+    QImage image(cachePath);
+    if (image.size() != size)
+        return QImage();
+    return image;
+}
+
+void DesktopSnapshot::saveWallpaper(const QString &path, const QSize &size, const QImage &image)
+{
+    if (image.isNull())
+        return;
+
+    auto cachePath = wallpaperCachePath(path, size);
+    auto sizePrefix = QString("wallpaper-%1x%2-").arg(size.width()).arg(size.height());
+    auto cacheDir = m_cache_dir;
+    QtConcurrent::run([=](){
+        QDir dir(cacheDir);
+        dir.mkpath(cacheDir);
+        //only keep the latest wallpaper of each screen size.
+        for (auto name : dir.entryList(QStringList()<<sizePrefix + "*", QDir::Files)) {
+            if (dir.filePath(name) != cachePath)
+                dir.remove(name);
+        }
+
+        //jpeg decodes much faster than png, but it loses the alpha channel.
+        QSaveFile file(cachePath);
+        if (!file.open(QIODevice::WriteOnly))
+            return;
+        image.save(&file, image.hasAlphaChannel()? "PNG": "JPG", 95);
+        file.commit();
+    });
+}
@@ -0,0 +1,115 @@
+/*
+ * Peony-Qt
+ *
+ * Copyright (C) 2019, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef DESKTOPSNAPSHOT_H
+#define DESKTOPSNAPSHOT_H
+
+#include <QObject>
+#include <QVector>
+#include <QImage>
+#include <QMutex>
+
+namespace Peony {
+
+struct DesktopSnapshotItem
+{
+    QString uri;
+    QString displayName;
+    QString iconName;
+};
+
+/*!
+ * \brief The DesktopSnapshot class
+ * <br>
+ * DesktopSnapshot persists what the desktop looked like last time, so that the
+ * desktop can be painted immediately at login, before the desktop directory is
+ * enumerated and the file infos are queried.
+ * </br>
+ * <br>
+ * It keeps the item list with their display names and icon names in
+ * ~/.cache/peony-qt-desktop/snapshot.json, and the wallpaper scaled to
+ * each screen size in the same directory. The item positions are kept by
+ * DesktopLayoutStore.
+ * </br>
+ * \note
+ * The snapshot is only used for the first paint. DesktopItemModel reconciles it
+ * with the real directory contents in the background.
+ */
+class DesktopSnapshot : public QObject
+{
+    Q_OBJECT
+public:
+    static DesktopSnapshot *getInstance();
+
+    /*!
+     * \brief items
+     * \return the items saved last time, they are loaded synchronously at first call.
+     */
+    const QVector<DesktopSnapshotItem> items();
+
+    /*!
+     * \brief setItems
+     * <br>
+     * Replace the saved items. The snapshot file is written in a worker
+     * thread, call sync() to write it synchronously.
+     * </br>
+     */
+    void setItems(const QVector<DesktopSnapshotItem> &items);
+
+    /*!
+     * \brief wallpaper
+     * \param path
+     * \param size
+     * \return the wallpaper of path which has been scaled to size before, or a null
+     * image if there is none or the wallpaper file changed since then.
+     * \note
+     * wallpaper() and saveWallpaper() can be called in worker threads.
+     */
+    const QImage wallpaper(const QString &path, const QSize &size);
+    void saveWallpaper(const QString &path, const QSize &size, const QImage &image);
+
+public Q_SLOTS:
+    void sync();
+
+private:
+    explicit DesktopSnapshot(QObject *parent = nullptr);
+
+    void load();
+    const QByteArray toJson();
+    bool write(const QByteArray &data);
+    const QString wallpaperCachePath(const QString &path, const QSize &size);
+
+private:
+    QString m_cache_dir;
+
+    bool m_loaded = false;
+    QVector<DesktopSnapshotItem> m_items;
+
+    //the snapshots might be written by worker threads out of order.
+    int m_generation = 0;
+    int m_written_generation = 0;
+    QMutex m_mutex;
+};
+
+}
+
+#endif // DESKTOPSNAPSHOT_H
@@ -0,0 +1,224 @@
+/*
+ * Peony-Qt
+ *
+ * Copyright (C) 2019, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#include "desktop-view-settings.h"
+
+#include "global-settings.h"
+
+#include <QApplication>
+
+#include <QDebug>
+
+#define DESKTOP_VIEW_SETTINGS_URI "computer:///"
+#define ZOOM_LEVEL_ATTRIBUTE "metadata::peony-qt-desktop-zoom-level"
+#define SORT_ORDER_ATTRIBUTE "metadata::peony-qt-desktop-sort-order"
+
+//write the changed values behind in a batch.
+#define WRITE_BEHIND_DELAY 1000
+
+using namespace Peony;
+
+static DesktopViewSettings *global_instance = nullptr;
+
+DesktopViewSettings *DesktopViewSettings::getInstance()
+{
+    if (!global_instance) {
+        global_instance = new DesktopViewSettings;
+    }
+    return global_instance;
+}
+
+DesktopViewSettings::DesktopViewSettings(QObject *parent) : QObject(parent)
+{
+    m_file = g_file_new_for_uri(DESKTOP_VIEW_SETTINGS_URI);
+    m_cancellable = g_cancellable_new();
+
+    m_write_timer.setSingleShot(true);
+    m_write_timer.setInterval(WRITE_BEHIND_DELAY);
+    connect(&m_write_timer, &QTimer::timeout, this, &DesktopViewSettings::writeAsync);
+
+    connect(qApp, &QApplication::aboutToQuit, this, &DesktopViewSettings::sync);
+}
+
+DesktopViewSettings::~DesktopViewSettings()
+{
+    g_cancellable_cancel(m_cancellable);
+    g_object_unref(m_cancellable);
+    g_object_unref(m_file);
+}
+
+void DesktopViewSettings::load()
+{
+    if (m_loading || m_loaded)
+        return;
+
+    m_loading = true;
+    g_file_query_info_async(m_file,
+                            ZOOM_LEVEL_ATTRIBUTE "," SORT_ORDER_ATTRIBUTE,
+                            G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                            G_PRIORITY_DEFAULT,
+                            m_cancellable,
+                            GAsyncReadyCallback(query_info_async_callback),
+                            this);
+}
+
+GAsyncReadyCallback DesktopViewSettings::query_info_async_callback(GFile *file, GAsyncResult *res, DesktopViewSettings *p_this)
+{
+    GError *err = nullptr;
+    GFileInfo *info = g_file_query_info_finish(file, res, &err);
+    if (err) {
+        if (err->code == G_IO_ERROR_CANCELLED) {
+            g_error_free(err);
+            return nullptr;
+        }
+        qDebug()<<"load desktop view settings failed:"<<err->message;
+        g_error_free(err);
+    }
+
+    if (info) {
+        //do not override the values set before loaded.
+        char *zoomLevel = g_file_info_get_attribute_as_string(info, ZOOM_LEVEL_ATTRIBUTE);
+        if (zoomLevel) {
+            if (!p_this->m_zoom_level_changed)
+                p_this->m_zoom_level = QString(zoomLevel).toInt();
+            g_free(zoomLevel);
+        }
+        char *sortOrder = g_file_info_get_attribute_as_string(info, SORT_ORDER_ATTRIBUTE);
+        if (sortOrder) {
+            if (!p_this->m_sort_order_changed)
+                p_this->m_sort_order = QString(sortOrder).toInt();
+            g_free(sortOrder);
+        }
+        g_object_unref(info);
+    }
+
+    p_this->m_loading = false;
+    p_this->m_loaded = true;
+    Q_EMIT p_this->loaded();
+
+    return nullptr;
+}
+
+int DesktopViewSettings::sortType()
+{
+    return GlobalSettings::getInstance()->getValue(LAST_DESKTOP_SORT_ORDER).toInt();
+}
+
+void DesktopViewSettings::setZoomLevel(int zoomLevel)
+{
+    if (m_zoom_level == zoomLevel)
+        return;
+
+    m_zoom_level = zoomLevel;
+    m_zoom_level_changed = true;
+    scheduleWrite();
+}
+
+void DesktopViewSettings::setSortType(int sortType)
+{
+    //GlobalSettings caches the value and writes it asynchronously.
+    GlobalSettings::getInstance()->setValue(LAST_DESKTOP_SORT_ORDER, sortType);
+}
+
+void DesktopViewSettings::setSortOrder(int sortOrder)
+{
+    if (m_sort_order == sortOrder)
+        return;
+
+    m_sort_order = sortOrder;
+    m_sort_order_changed = true;
+    scheduleWrite();
+}
+
+void DesktopViewSettings::scheduleWrite()
+{
+    if (!m_write_timer.isActive())
+        m_write_timer.start();
+}
+
+GFileInfo *DesktopViewSettings::takeChangedInfo()
+{
+    if (!m_zoom_level_changed && !m_sort_order_changed)
+        return nullptr;
+
+    GFileInfo *info = g_file_info_new();
+    if (m_zoom_level_changed) {
+        g_file_info_set_attribute_string(info, ZOOM_LEVEL_ATTRIBUTE, QString::number(m_zoom_level).toUtf8().constData());
+        m_zoom_level_changed = false;
+    }
+    if (m_sort_order_changed) {
+        g_file_info_set_attribute_string(info, SORT_ORDER_ATTRIBUTE, QString::number(m_sort_order).toUtf8().constData());
+        m_sort_order_changed = false;
+    }
+    return info;
+}
+
+void DesktopViewSettings::writeAsync()
+{
+    //wait for loading, or the loaded values might override the changed ones.
+    if (!m_loaded) {
+        scheduleWrite();
+        return;
+    }
+
+    GFileInfo *info = takeChangedInfo();
+    if (!info)
+        return;
+
+    g_file_set_attributes_async(m_file,
+                                info,
+                                G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                G_PRIORITY_DEFAULT,
+                                m_cancellable,
+                                GAsyncReadyCallback(set_attributes_async_callback),
+                                this);
+    g_object_unref(info);
+}
+
+GAsyncReadyCallback DesktopViewSettings::set_attributes_async_callback(GFile *file, GAsyncResult *res, DesktopViewSettings *p_this)
+{
+    Q_UNUSED(p_this)
+    GError *err = nullptr;
+    g_file_set_attributes_finish(file, res, nullptr, &err);
+    if (err) {
+        if (err->code != G_IO_ERROR_CANCELLED)
+            qDebug()<<"save desktop view settings failed:"<<err->message;
+        g_error_free(err);
+    }
+    return nullptr;
+}
+
+void DesktopViewSettings::sync()
+{
+    m_write_timer.stop();
+    GFileInfo *info = takeChangedInfo();
+    if (!info)
+        return;
+
+    GError *err = nullptr;
+    g_file_set_attributes_from_info(m_file, info, G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS, nullptr, &err);
+    if (err) {
+        qDebug()<<"save desktop view settings failed:"<<err->message;
+        g_error_free(err);
+    }
+    g_object_unref(info);
+}
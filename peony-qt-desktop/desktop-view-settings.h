@@ -0,0 +1,127 @@
+/*
+ * Peony-Qt
+ *
+ * Copyright (C) 2019, Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ * Authors: Yue Lan <lanyue@kylinos.cn>
+ *
+ */
+
+#ifndef DESKTOPVIEWSETTINGS_H
+#define DESKTOPVIEWSETTINGS_H
+
+#include <QObject>
+#include <QTimer>
+
+#include <gio/gio.h>
+
+namespace Peony {
+
+/*!
+ * \brief The DesktopViewSettings class
+ * <br>
+ * DesktopViewSettings keeps the state of desktop view in memory, such as
+ * zoom level and sort order. The zoom level and sort order are stored as
+ * metadata of computer:///, which is handled by gvfs-metadata daemon, so
+ * they are loaded asynchronously once at startup, and the changed values are
+ * written behind in a single batch.
+ * </br>
+ * <br>
+ * Getters never do any I/O, so that they can be used in layout and painting.
+ * Before loaded, they return the default values.
+ * </br>
+ * \note
+ * The sort type is kept in GlobalSettings as before, this class just forwards it.
+ */
+class DesktopViewSettings : public QObject
+{
+    Q_OBJECT
+public:
+    static DesktopViewSettings *getInstance();
+
+    /*!
+     * \brief load
+     * <br>
+     * Start loading the settings asynchronously, loaded() will be emitted
+     * when finished. Only the first call takes effect.
+     * </br>
+     */
+    void load();
+    bool isLoaded() {return m_loaded;}
+
+    /*!
+     * \brief zoomLevel
+     * \return the value of DesktopIconView::ZoomLevel, 0 (Invalid) if it
+     * is not set or not loaded yet.
+     */
+    int zoomLevel() {return m_zoom_level;}
+    int sortType();
+    int sortOrder() {return m_sort_order;}
+
+Q_SIGNALS:
+    void loaded();
+
+public Q_SLOTS:
+    void setZoomLevel(int zoomLevel);
+    void setSortType(int sortType);
+    void setSortOrder(int sortOrder);
+
+    /*!
+     * \brief sync
+     * <br>
+     * Write the changed values synchronously. It is called when application
+     * is about to quit, the pending write-behind would be lost otherwise.
+     * </br>
+     */
+    void sync();
+
+protected:
+    static GAsyncReadyCallback query_info_async_callback(GFile *file,
+                                                         GAsyncResult *res,
+                                                         DesktopViewSettings *p_this);
+
+    static GAsyncReadyCallback set_attributes_async_callback(GFile *file,
+                                                             GAsyncResult *res,
+                                                             DesktopViewSettings *p_this);
+
+private:
+    explicit DesktopViewSettings(QObject *parent = nullptr);
+    ~DesktopViewSettings();
+
+    void scheduleWrite();
+    GFileInfo *takeChangedInfo();
+    void writeAsync();
+
+private:
+    GFile *m_file = nullptr;
+    GCancellable *m_cancellable = nullptr;
+
+    bool m_loading = false;
+    bool m_loaded = false;
+
+    int m_zoom_level = 0;
+    int m_sort_order = Qt::AscendingOrder;
+
+    //the values changed before loaded are kept.
+    bool m_zoom_level_changed = false;
+    bool m_sort_order_changed = false;
+
+    QTimer m_write_timer;
+};
+
+}
+
+#endif // DESKTOPVIEWSETTINGS_H
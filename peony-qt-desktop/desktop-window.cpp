@@ -33,6 +33,7 @@
 
 #include "desktop-icon-view.h"
 #include "desktop-item-model.h"
+#include "desktop-snapshot.h"
 
 #include "clipboard-utils.h"
 #include "file-copy-operation.h"
@@ -57,6 +58,9 @@
 
 #include <QVariantAnimation>
 #include <QPainter>
+#include <QImageReader>
+#include <QFutureWatcher>
+#include <QtConcurrent>
 
 #include <QFileDialog>
 
@@ -90,7 +94,6 @@ DesktopWindow::DesktopWindow(QScreen *screen, bool is_primary, QWidget *parent)
     });
 
     connect(m_opacity, &QVariantAnimation::finished, this, [=](){
-        m_bg_back_pixmap = m_bg_font_pixmap;
         m_bg_back_cache_pixmap = m_bg_font_cache_pixmap;
         m_last_pure_color = m_color_to_be_set;
     });
@@ -285,29 +288,17 @@ void DesktopWindow::setBg(const QString &path) {
         return;
     }
 
-    m_use_pure_color = false;
-
-    m_bg_back_pixmap = m_bg_font_pixmap;
-
-    m_bg_font_pixmap = QPixmap(path);
-    // FIXME: implement different pixmap clip algorithm.
-
-    m_bg_back_cache_pixmap = m_bg_back_pixmap.scaled(m_screen->size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-
-    m_bg_font_cache_pixmap = m_bg_font_pixmap.scaled(m_screen->size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-
     m_current_bg_path = path;
     setBgPath(path);
 
-    if (m_opacity->state() == QVariantAnimation::Running) {
-        m_opacity->setCurrentTime(500);
-    } else {
-        m_opacity->stop();
-        m_opacity->start();
-    }
+    //the transition starts when the scaled wallpaper is ready.
+    loadBgAsync(path, m_screen->size(), true);
 }
 
 void DesktopWindow::setBg(const QColor &color) {
+    //drop the wallpaper which is still loading.
+    m_bg_request++;
+
     m_color_to_be_set = color;
 
     m_use_pure_color = true;
@@ -378,11 +369,77 @@ void DesktopWindow::scaleBg(const QRect &geometry) {
     setWindowFlag(Qt::FramelessWindowHint);
     show();
 
-    m_bg_back_cache_pixmap = m_bg_back_pixmap.scaled(geometry.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-    m_bg_font_cache_pixmap = m_bg_font_pixmap.scaled(geometry.size(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    //the current wallpaper is stretched when painting until
+    //the one of new size is ready.
+    if (!m_use_pure_color && !m_current_bg_path.isEmpty())
+        loadBgAsync(m_current_bg_path, geometry.size(), false);
     this->update();
 }
 
+static QImage loadScaledWallpaper(DesktopSnapshot *snapshot, const QString &path, const QSize &size)
+{
+    auto image = snapshot->wallpaper(path, size);
+    if (!image.isNull())
+        return image;
+
+    QImageReader reader(path);
+    auto sourceSize = reader.size();
+    if (sourceSize.isValid() && reader.supportsOption(QImageIOHandler::ScaledSize)) {
+        //let the decoder skip the details we do not need, such as the
+        //jpeg decoder, it never holds the full resolution image then.
+        auto decodeSize = sourceSize.scaled(size, Qt::KeepAspectRatioByExpanding);
+        if (decodeSize.width() < sourceSize.width() && decodeSize.height() < sourceSize.height())
+            reader.setScaledSize(decodeSize);
+    }
+
+    if (!reader.read(&image)) {
+        qDebug()<<"load wallpaper failed:"<<path<<reader.errorString();
+        return QImage();
+    }
+
+    // FIXME: implement different pixmap clip algorithm.
+    if (image.size() != size)
+        image = image.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    snapshot->saveWallpaper(path, size, image);
+    return image;
+}
+
+void DesktopWindow::loadBgAsync(const QString &path, const QSize &size, bool transition)
+{
+    int request = ++m_bg_request;
+    auto snapshot = DesktopSnapshot::getInstance();
+    auto watcher = new QFutureWatcher<QImage>(this);
+    connect(watcher, &QFutureWatcher<QImage>::finished, this, [=](){
+        auto image = watcher->result();
+        watcher->deleteLater();
+        //another wallpaper or size has been requested since then.
+        if (request != m_bg_request || image.isNull())
+            return;
+
+        auto pixmap = QPixmap::fromImage(image);
+        if (!transition) {
+            m_bg_font_cache_pixmap = pixmap;
+            if (m_opacity->state() != QVariantAnimation::Running)
+                m_bg_back_cache_pixmap = pixmap;
+            this->update();
+            return;
+        }
+
+        m_use_pure_color = false;
+        m_bg_back_cache_pixmap = m_bg_font_cache_pixmap;
+        m_bg_font_cache_pixmap = pixmap;
+        if (m_opacity->state() == QVariantAnimation::Running) {
+            m_opacity->setCurrentTime(500);
+        } else {
+            m_opacity->stop();
+            m_opacity->start();
+        }
+    });
+    watcher->setFuture(QtConcurrent::run([=](){
+        return loadScaledWallpaper(snapshot, path, size);
+    }));
+}
+
 void DesktopWindow::initShortcut() {
     // shotcut
     return;
@@ -86,17 +86,31 @@ protected:
     void initShortcut();
     void initGSettings();
 
+    /*!
+     * \brief loadBgAsync
+     * \param path
+     * \param size
+     * \param transition
+     * <br>
+     * Decode the wallpaper of path at size in a worker thread. The scaled wallpaper
+     * is cached on disk by DesktopSnapshot, only the scaled one is kept in memory.
+     * If transition is true, the transition animation starts when it is ready.
+     * </br>
+     */
+    void loadBgAsync(const QString &path, const QSize &size, bool transition);
+
 private:
     QString m_current_bg_path;
 
     DesktopIconView *m_view;
 
-    QPixmap m_bg_font_pixmap;
-    QPixmap m_bg_back_pixmap;
-
+    //the wallpapers scaled to screen size, the full resolution ones are not kept.
     QPixmap m_bg_font_cache_pixmap;
     QPixmap m_bg_back_cache_pixmap;
 
+    //increased by each request, the results of older requests are dropped.
+    int m_bg_request = 0;
+
     QGraphicsOpacityEffect *m_opacity_effect;
 
     QScreen *m_screen;
@@ -25,6 +25,8 @@
 
 #include "fm-dbus-service.h"
 #include "desktop-menu-plugin-manager.h"
+#include "desktop-view-settings.h"
+#include "desktop-layout-store.h"
 
 #include "volume-manager.h"
 
@@ -126,6 +128,10 @@ PeonyDesktopApplication::PeonyDesktopApplication(int &argc, char *argv[], const
         setStyleSheet(QString::fromLatin1(file.readAll()));
         file.close();
         Peony::DesktopMenuPluginManager::getInstance();
+        //load the view settings as early as possible.
+        Peony::DesktopViewSettings::getInstance()->load();
+        //the item positions should be ready before the first paint.
+        Peony::DesktopLayoutStore::getInstance();
 
         /*
         QSystemTrayIcon *trayIcon = new QSystemTrayIcon(this);
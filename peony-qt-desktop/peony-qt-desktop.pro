@@ -46,7 +46,10 @@ SOURCES += \
     desktop-index-widget.cpp \
     desktop-menu.cpp \
     desktop-menu-plugin-manager.cpp \
-    desktop-item-proxy-model.cpp
+    desktop-item-proxy-model.cpp \
+    desktop-view-settings.cpp \
+    desktop-layout-store.cpp \
+    desktop-snapshot.cpp
 
 HEADERS += \
     desktop-window.h \
@@ -58,7 +61,10 @@ HEADERS += \
     desktop-index-widget.h \
     desktop-menu.h \
     desktop-menu-plugin-manager.h \
-    desktop-item-proxy-model.h
+    desktop-item-proxy-model.h \
+    desktop-view-settings.h \
+    desktop-layout-store.h \
+    desktop-snapshot.h
 
 target.path = /usr/bin
 !isEmpty(target.path): INSTALLS += target
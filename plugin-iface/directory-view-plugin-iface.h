@@ -27,7 +27,7 @@
 
 #include <QString>
 
-#define DirectoryViewPluginIface_iid "org.ukui.peony-qt.plugin-iface.DirectoryViewPluginInterface"
+#define DirectoryViewPluginIface_iid "org.ukui.peony-qt.plugin-iface.DirectoryViewPluginInterface/1.1"
 
 namespace Peony {
 
@@ -36,6 +36,7 @@ class DirectoryViewProxyIface;
 
 class FileItemModel;
 class FileItemProxyFilterSortModel;
+class FlatDirectoryModel;
 
 /*!
  * \brief The DirectoryViewPluginIface class
@@ -207,6 +208,19 @@ public:
      * implement batch rename
      */
     virtual void editUris(const QStringList uris) = 0;
+
+    //new virtual methods must be appended here, and the interface iid bumped.
+    /*!
+     * \brief bindFlatModel
+     * \param model
+     * \details
+     * Show a large flat directory with a FlatDirectoryModel rather than
+     * a FileItemModel. The model sorts and filters hidden files itself,
+     * so there is no proxy model. A view which doesn't support it just
+     * ignores the model.
+     * \see FlatDirectoryModel
+     */
+    virtual void bindFlatModel(FlatDirectoryModel *model) {Q_UNUSED(model)}
 };
 
 /*!
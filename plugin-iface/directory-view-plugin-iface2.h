@@ -27,7 +27,7 @@
 
 #include <QWidget>
 
-#define DirectoryViewPluginIface2_iid "org.ukui.peony-qt.plugin-iface.DirectoryViewPluginInterface2"
+#define DirectoryViewPluginIface2_iid "org.ukui.peony-qt.plugin-iface.DirectoryViewPluginInterface2/1.1"
 
 namespace Peony {
 
@@ -307,6 +307,8 @@ void TabWidget::addPage(const QString &uri, bool jumpTo)
     viewContainer->goToUri(uri, false, true);
     if (jumpTo) {
         m_stack->setCurrentWidget(viewContainer);
+    } else {
+        viewContainer->setActive(false);
     }
 
     bindContainerSignal(viewContainer);
@@ -431,6 +433,12 @@ void TabWidget::changeCurrentIndex(int index)
 {
     m_tab_bar->setCurrentIndex(index);
     m_stack->setCurrentIndex(index);
+    //background tabs will be suspended after a while.
+    for (int i = 0; i < m_stack->count(); i++) {
+        auto container = qobject_cast<Peony::DirectoryViewContainer *>(m_stack->widget(i));
+        if (container)
+            container->setActive(i == index);
+    }
     Q_EMIT currentIndexChanged(index);
     Q_EMIT activePageChanged();
 }